@@ -2,6 +2,7 @@
 #define BASIC_FONT_H
 
 #include <stdint.h>
+#include <psxgpu.h>
 
 #define GLYPH_WHITE_WIDTH   5
 #define GLYPH_WHITE_HEIGHT 11
@@ -19,6 +20,57 @@
 #define GLYPH_HG_WHITE_HEIGHT   24
 #define GLYPH_HG_GAP             0
 
+typedef enum {
+    FONT_BIG,
+    FONT_MD,
+    FONT_SM,
+    FONT_HG,
+    FONT_MAX,
+} FontSize;
+
+// Prebaked text. Strings are resolved once (glyphs, positions, color
+// escapes and width) and can then be drawn anywhere, as many times as
+// needed, without being parsed again. Meant for static strings
+#define FONT_TEXT_MAX_GLYPHS 32
+
+#define FONT_TEXT_FIXED   0x01 // Color was set by the text itself
+#define FONT_TEXT_UNFADED 0x02 // Color was reset by the text, ignores fade
+
+typedef struct {
+    int16_t x, y;
+    uint8_t u0, v0, w, h;
+    uint8_t flags;
+    uint8_t rgb[3];
+} FontTextGlyph;
+
+typedef struct {
+    uint8_t       num_glyphs;
+    uint8_t       end_flags;
+    uint8_t       end_rgb[3];
+    uint16_t      width;
+    FontTextGlyph glyphs[FONT_TEXT_MAX_GLYPHS];
+} FontText;
+
+// Retained text run, drawn with the big font. Glyph sprites are kept
+// across frames (one set per render buffer) and only rebuilt when the
+// text or color of the run changes; drawing a run just links its sprites
+// into the HUD layer. Runs only support plain text (no escape codes)
+#define FONT_RUN_MAX_GLYPHS 10
+
+typedef struct {
+    uint8_t num_glyphs;
+    char    text[FONT_RUN_MAX_GLYPHS + 1];
+    uint8_t rgb[3];
+} FontRunBuffer;
+
+typedef struct {
+    int16_t       vx, vy;
+    char          text[FONT_RUN_MAX_GLYPHS + 1];
+    uint8_t       rgb[3];
+    FontRunBuffer built[2];
+    SPRT          sprt[2][FONT_RUN_MAX_GLYPHS];
+} FontRun;
+
 void font_init();
 void font_flush();
 void font_draw_big(const char *text, int16_t vx, int16_t vy);
@@ -26,6 +78,14 @@ void font_draw_md(const char *text, int16_t vx, int16_t vy);
 void font_draw_sm(const char *text, int16_t vx, int16_t vy);
 void font_draw_hg(const char *text, int16_t vx, int16_t vy);
 
+void font_text_bake(FontText *ftext, FontSize size, const char *text);
+void font_text_draw(FontText *ftext, int16_t vx, int16_t vy);
+
+void font_run_init(FontRun *run, int16_t vx, int16_t vy);
+void font_run_set_text(FontRun *run, const char *text);
+void font_run_set_color(FontRun *run, uint8_t r0, uint8_t g0, uint8_t b0);
+void font_run_draw(FontRun *run);
+
 uint16_t font_measurew_big(const char *text);
 uint16_t font_measurew_md(const char *text);
 uint16_t font_measurew_sm(const char *text);
@@ -0,0 +1,40 @@
+#ifndef BUDGET_H
+#define BUDGET_H
+
+#include <stdint.h>
+
+// Primitive budget for levels. Each frame, whatever draws the level
+// reports how many primitives it took, and at the end of the frame the
+// governor compares that and the packet buffer usage against their limits.
+// Detail is dropped in the order below, one step per frame while over
+// budget, and only given back after the load stays low for a while, so
+// that it does not flicker in and out.
+#define BUDGET_MAX_PRIMS   1536
+#define BUDGET_HIGH        90   // Load (%) at which detail is dropped
+#define BUDGET_LOW         75   // Load (%) under which detail comes back
+#define BUDGET_HOLD_FRAMES 60   // Frames under BUDGET_LOW before that
+
+typedef enum {
+    BUDGET_LEVEL_FULL,
+    BUDGET_LEVEL_NO_FAR_STRIPS, // Parallax strips scrolling slowly
+    BUDGET_LEVEL_NO_DECOR,      // Decorative objects
+    BUDGET_LEVEL_NO_BACKGROUND, // Whole parallax background
+    BUDGET_LEVEL_MAX,
+} BudgetLevel;
+
+typedef enum {
+    BUDGET_TILES,
+    BUDGET_OBJECTS,
+    BUDGET_PARALLAX,
+    BUDGET_WATER,
+    BUDGET_KIND_MAX,
+} BudgetKind;
+
+void        budget_reset();
+void        budget_count(BudgetKind kind, uint16_t n);
+void        budget_end_frame();
+BudgetLevel budget_level();
+uint8_t     budget_load();
+uint16_t    budget_get_count(BudgetKind kind);
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stdint.h>
+#include <psxgpu.h>
+#include "vram.h"
+
+// Persistent asset cache. Lives outside of the scene arena, so whatever
+// is stored here survives scene_change. Entries are keyed by file path;
+// the hash only narrows the search, and the path itself is kept for
+// telling apart paths that hash the same.
+#define CACHE_BUFFER_LEN  32768
+#define CACHE_MAX_ENTRIES 64
+
+// Hardware residency of a cached asset. When a flag is cleared, the copy
+// on that hardware was overwritten and must be uploaded again
+typedef enum {
+    CACHE_RESIDENT_NONE = 0x00,
+    CACHE_RESIDENT_VRAM = 0x01,
+} CacheResidency;
+
+typedef struct {
+    uint32_t hash;
+    char     *path;   // Copy on the cache arena
+    uint8_t  residency;
+    void     *data;
+
+    // Texture information, if this entry is VRAM-resident
+    uint8_t  mode;
+    uint8_t  has_clut;
+    RECT     prect;
+    RECT     crect;
+} CacheEntry;
+
+void        cache_init();
+void       *cache_alloc(uint32_t size);
+CacheEntry *cache_find(const char *path);
+CacheEntry *cache_insert(const char *path);
+void       *cache_get(const char *path);
+void        cache_put(const char *path, void *data);
+
+uint8_t cache_load_texture(const char *path, TIM_IMAGE *tim, VramArea *area);
+void    cache_vram_written(RECT *rect);
+void    cache_invalidate_residency(uint8_t residency);
+
+void cache_debrief();
+
+#endif
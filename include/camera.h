@@ -17,6 +17,11 @@ typedef struct {
 
     VECTOR  focus;
     uint8_t follow_player;
+
+    // How far the camera moved on its last update, and where the view is
+    // expected to be after the next frame at that speed
+    VECTOR  vel;
+    VECTOR  lookahead;
 } Camera;
 
 void camera_init(Camera *);
@@ -0,0 +1,47 @@
+#ifndef CDLOAD_H
+#define CDLOAD_H
+
+#include <stdint.h>
+#include <psxgpu.h>
+#include "vram.h"
+
+// Asynchronous CD loader. Files are read in chunks into two alternating
+// sector buffers, so that a chunk can be decoded (or uploaded to VRAM)
+// while the next one is being read. Chunk data is only valid during the
+// callback, and callbacks must not perform blocking CD reads themselves.
+// Compressed files are delivered decompressed, as a single last chunk.
+// Ranges of a file (starting on a sector boundary) are delivered as-is.
+#define CDLOAD_CHUNK_SECTORS 8
+#define CDLOAD_CHUNK_SIZE    (CDLOAD_CHUNK_SECTORS * 2048)
+#define CDLOAD_QUEUE_LEN     16
+
+// Called once per chunk, in file order. On error, called once with
+// data == NULL and last set.
+typedef void (*CdLoadCallback)(uint8_t *data, uint32_t offset,
+                               uint32_t length, uint8_t last,
+                               void *userdata);
+
+// Result of a streamed texture upload. Valid once loaded is set.
+// If area is set, the texture is placed at an offset within it instead
+typedef struct {
+    uint8_t  loaded;
+    uint8_t  mode;
+    RECT     prect;
+    RECT     crect;
+
+    VramArea *area;
+    uint16_t ox, oy;
+    uint8_t  clut_row;
+} CdLoadTexture;
+
+uint8_t cdload_request(const char *filename, CdLoadCallback cb, void *userdata);
+uint8_t cdload_request_range(const char *filename, uint32_t offset, uint32_t length,
+                             CdLoadCallback cb, void *userdata);
+uint8_t cdload_texture(const char *filename, CdLoadTexture *tex);
+uint8_t cdload_texture_at(const char *filename, CdLoadTexture *tex, VramArea *area,
+                          uint16_t ox, uint16_t oy, uint8_t clut_row);
+uint8_t cdload_process();
+uint8_t cdload_busy();
+void    cdload_sync(void (*idle)(void));
+
+#endif
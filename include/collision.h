@@ -19,6 +19,17 @@ typedef enum {
 CollisionEvent linecast(int32_t vx, int32_t vy, LinecastDirection direction,
                         uint8_t magnitude, LinecastDirection floor_direction);
 
+// Sensors only reach so far. Anything between the tip of a sensor and
+// where the same sensor starts on the next step is never seen when moving
+// faster than that, so thin walls and floors could be passed through.
+// This gives the magnitude a sensor needs to leave no such gap, given the
+// movement on its axis (20.12). Since linecast samples every tile it
+// crosses and keeps the nearest hit, one stretched cast stands in for a
+// cast per sub-step. Slower movement keeps the sensor as it is
+#define LINECAST_MAX_SWEEP 128
+
+uint8_t linecast_sweep_magnitude(uint8_t magnitude, int32_t vel);
+
 
 /* Simpler collision detection algorithms */
 
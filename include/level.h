@@ -7,9 +7,18 @@
 #include "object.h"
 #include "object_state.h"
 
-#define LEVEL_MAX_X_CHUNKS   255
+#define LEVEL_MAX_X_CHUNKS  1023
 #define LEVEL_MAX_Y_CHUNKS    31
 
+// Native asset formats, see chunkgen.py, cooklvl.py and cookcollision.py
+#define COLLISION_MAGIC   "COL1"
+#define COLLISION_VERSION 1
+#define MAP128_MAGIC      "M128"
+#define MAP128_VERSION    1
+#define LEVEL_MAGIC       "LVL1"
+#define LEVEL_VERSION     2
+
+// Also the layout of each entry in MAP16.COL
 typedef struct {
     uint8_t floor[8];
     uint8_t rwall[8];
@@ -30,6 +39,7 @@ typedef struct {
     Collision **collision;
 } TileMap16;
 
+// Also the layout of each frame in MAP128.MAP
 typedef struct {
     uint16_t index;
     uint8_t  props;
@@ -41,6 +51,7 @@ typedef struct {
     uint16_t num_tiles;
     uint16_t frame_side;
     Frame128 *frames;
+    Frame128 **chunks; // Frames of each chunk, NULL if not resident
 } TileMap128;
 
 #define MAP128_PROP_SOLID  0
@@ -48,9 +59,10 @@ typedef struct {
 #define MAP128_PROP_NONE   2
 #define MAP128_PROP_FRONT  4
 
+// Also the layout of each layer in LVL files, where tiles is an offset
 typedef struct {
-    uint8_t width;
-    uint8_t height;
+    uint16_t width;
+    uint16_t height;
     uint16_t *tiles;
 } LevelLayerData;
 
@@ -63,6 +75,7 @@ typedef struct {
     uint16_t crectx, crecty;
     uint16_t prectx, precty;
     uint16_t clutmode, _unused1;
+    uint32_t num_chunks; // Length of objects array
 } LevelData;
 
 void load_map16(TileMap16 *mapping, const char *filename, const char *collision_filename);
@@ -72,6 +85,7 @@ uint16_t level_get_num_sprites();
 
 void prepare_renderer();
 void render_lvl(int32_t cam_x, int32_t cam_y, uint8_t front);
+void level_prefetch(int32_t ahead_x, int32_t ahead_y);
 
 void update_obj_window(int32_t cam_x, int32_t cam_y, uint8_t round);
 
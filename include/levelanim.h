@@ -0,0 +1,55 @@
+#ifndef LEVELANIM_H
+#define LEVELANIM_H
+
+#include <stdint.h>
+#include "util.h"
+
+// Level art animations, cooked by buildanm.py from a level's
+// animations.toml. Palette animations rotate a range of colors of a CLUT
+// row; tile animations swap a small rectangle of a texture between frames
+// stored on the file. Both are applied with small uploads between frames,
+// so that waterfalls, conveyors and lights need no objects.
+#define LEVELANIM_MAGIC   "ANM1"
+#define LEVELANIM_VERSION 1
+
+typedef enum {
+    LEVELANIM_AREA_TILES,
+    LEVELANIM_AREA_BG,
+    LEVELANIM_AREA_OBJECTS,
+} LevelAnimArea;
+
+typedef struct {
+    AssetHeader header;
+    uint16_t    num_palettes;
+    uint16_t    num_tiles;
+    uint32_t    palettes_offset;  // PaletteAnim[num_palettes]
+    uint32_t    tiles_offset;     // TileAnim[num_tiles]
+} LevelAnimFile;
+
+typedef struct {
+    uint8_t  area;
+    uint8_t  row;
+    uint8_t  first;
+    uint8_t  count;
+    uint8_t  period;
+    int8_t   direction;
+    uint16_t _unused;
+} PaletteAnim;
+
+typedef struct {
+    uint8_t  area;
+    uint8_t  num_frames;
+    uint8_t  period;
+    uint8_t  _unused;
+    int16_t  x, y, w, h;          // Within area, in VRAM halfwords
+    uint32_t frames_offset;       // uint16_t[num_frames][h][w], each
+                                  // frame padded to 4 bytes
+} TileAnim;
+
+void levelanim_load(const char *filename);
+void levelanim_start();
+void levelanim_update();
+void levelanim_flush();
+void levelanim_unload();
+
+#endif
@@ -4,21 +4,81 @@
 #include <stdint.h>
 #include <stdlib.h>
 
+// All arena allocations are aligned to this amount of bytes
+#define ARENA_ALIGNMENT 8
+
+// Tags used for accounting where arena memory goes.
+// Every allocation is attributed to exactly one tag.
+typedef enum {
+    ARENA_TAG_MISC,
+    ARENA_TAG_TILES,
+    ARENA_TAG_COLLISION,
+    ARENA_TAG_OBJECTS,
+    ARENA_TAG_PARALLAX,
+    ARENA_TAG_MODELS,
+    ARENA_TAG_MAX,
+} ArenaTag;
+
+// Scopes are nested lifetimes within an arena. Pushing a scope stores
+// a marker at the current allocation pointer; popping it discards
+// everything allocated since then, including any inner scopes.
+typedef enum {
+    ARENA_SCOPE_PERSISTENT,
+    ARENA_SCOPE_SCENE,
+    ARENA_SCOPE_LEVEL,
+    ARENA_SCOPE_ACT,
+    ARENA_SCOPE_MAX,
+} ArenaScope;
+
 typedef struct {
-    uintptr_t start;
     uintptr_t ptr;
-    size_t    size;
+    uint32_t  tag_bytes[ARENA_TAG_MAX];
+    uint8_t   parent;
+} ArenaMarker;
+
+typedef struct {
+    uintptr_t   start;
+    uintptr_t   ptr;
+    size_t      size;
+    uint8_t     scope;
+    uint32_t    tag_bytes[ARENA_TAG_MAX];
+    ArenaMarker markers[ARENA_SCOPE_MAX];
 } ArenaAllocator;
 
-void  alloc_arena_init(ArenaAllocator *arena, void *start, uintptr_t size);
+void  alloc_arena_init(ArenaAllocator *arena, void *start, size_t size);
 void  alloc_arena_free(ArenaAllocator *arena);
 void *alloc_arena_malloc(ArenaAllocator *arena, size_t size);
+void *alloc_arena_malloc_tagged(ArenaAllocator *arena, size_t size, ArenaTag tag);
+
+void  alloc_arena_push(ArenaAllocator *arena, ArenaScope scope);
+void  alloc_arena_pop(ArenaAllocator *arena, ArenaScope scope);
+void *alloc_arena_scope_start(ArenaAllocator *arena, ArenaScope scope);
 
 uint32_t alloc_arena_bytes_used(ArenaAllocator *arena);
 uint32_t alloc_arena_bytes_free(ArenaAllocator *arena);
+uint32_t alloc_arena_bytes_tagged(ArenaAllocator *arena, ArenaTag tag);
+uint32_t alloc_arena_bytes_scope(ArenaAllocator *arena, ArenaScope scope);
+const char *alloc_arena_tag_name(ArenaTag tag);
+const char *alloc_arena_scope_name(ArenaScope scope);
+
+// Per-frame scratch allocator. Allocations are served from the 1KB
+// scratchpad first and spill over to a main RAM frame arena when it is
+// full. Everything is discarded on swap_buffers, so pointers obtained here
+// must never outlive the current frame.
+typedef struct {
+    uint32_t hits;          // Allocations served by the scratchpad
+    uint32_t spills;        // Allocations served by main RAM
+    uint32_t scratch_bytes;
+    uint32_t spill_bytes;
+    uint32_t scratch_peak;  // Highest usage since fastalloc_init
+    uint32_t spill_peak;
+} FastAllocStats;
 
 void fastalloc_init();
 void fastalloc_free();
 void *fastalloc_malloc(size_t size);
+uint32_t fastalloc_get_frame();
+void fastalloc_get_stats(FastAllocStats *stats);
+uint32_t fastalloc_hit_rate();
 
 #endif
@@ -96,6 +96,7 @@ typedef struct {
 
 
 void load_object_table(const char *filename, ObjectTable *tbl);
+void load_object_table_cached(const char *filename, ObjectTable *tbl);
 
 
 #endif
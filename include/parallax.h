@@ -4,22 +4,37 @@
 #include <stdint.h>
 #include "camera.h"
 
-/* .PRL file layout
+/* .PRL file layout (big endian)
    ==================
    number of strips: u8
    Array of strips:
-      number of parts: u8
+      u0: u8
+      v0: u8
+      width: u16
+      height: u16
+      texture index (BG0 or BG1): u8
       do not repeat (single)?: u8
-      horizontal scroll factor: s16
+      horizontal scroll factor: s32 (20.12)
+      horizontal speed: s32 (20.12)
       Y position: s16
-      Array of parts:
-          u0: u8
-          v0: u8
-          texture index (BG0 or BG1): u8
-          width: u16
-          height: u16
+      band height: u8 (0 if the strip is not split in bands)
+      If band height is not 0:
+          wave amplitude: u8
+          wave step per band: u16 (4096 = full period)
+          wave speed per step: u16 (4096 = full period)
+          Array of band scroll factors, one per band: s32 (20.12)
  */
 
+// Line scroll. A strip may be split into bands a few lines tall, each with
+// its own scroll factor, and optionally displaced by a sine wave that moves
+// down the bands over time (water shimmer, heat haze, floor perspective).
+// Band polygons are built on load; drawing them only patches their X.
+#define PRL_MAX_BANDS 64
+
+// Strips scrolling slower than this (20.12) are far behind everything else,
+// and are the first detail dropped when the level is over budget
+#define PRL_FAR_SCROLLX 0x0400
+
 // Holds a single parallax strip for a level.
 // A strip is a horizontally-repeating quad.
 typedef struct {
@@ -33,8 +48,23 @@ typedef struct {
     int32_t speedx;
     int16_t y0;
 
+    // Line scroll
+    uint8_t  band_height;
+    uint8_t  num_bands;
+    uint8_t  polys_per_band;
+    uint8_t  wave_amplitude;
+    uint16_t wave_step;
+    uint16_t wave_speed;
+    int32_t  *band_scrollx;
+    int16_t  built_vy[2];
+
+    // Palette, swapped for its underwater copy below the water surface
+    uint16_t clut_x;
+    uint16_t clut_y;
+
     // State
     int32_t rposx;
+    uint16_t wave_phase;
 } ParallaxStrip;
 
 // Holds all parallax strips for a level
@@ -45,6 +75,7 @@ typedef struct {
 
 void load_parallax(Parallax *parallax, const char *filename,
                    uint8_t tx_mode, int32_t px, int32_t py, int32_t cx, int32_t cy);
+void parallax_update(Parallax *prl);
 void parallax_draw(Parallax *prl, Camera *camera);
 
 #endif
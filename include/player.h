@@ -19,6 +19,17 @@
 
 #define HEIGHT_RADIUS_CLIMB     10
 
+// Sensor placement and hit resolution, shared with the host tests.
+// Push sensors start this far above the player's centre, unless standing
+// on flat ground. Ceiling sensors reach half as far as ground sensors
+#define PUSH_SENSOR_Y            8
+#define CEILING_MAGNITUDE(r)    ((r) >> 1)
+// Where the player's centre is put after a hit, from the hit coordinate
+#define PUSH_SNAP_RIGHT         10
+#define PUSH_SNAP_LEFT          25
+#define GROUND_SNAP             16
+#define CEILING_SNAP            32
+
 #define PLAYER_HURT_IFRAMES     120
 #define PLAYER_FLY_MAXFRAMES    480
 
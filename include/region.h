@@ -0,0 +1,21 @@
+#ifndef REGION_H
+#define REGION_H
+
+#include <stdint.h>
+#include "level.h"
+
+// Streamed level regions. Acts which are too long for all of their 128x128
+// chunks to fit in RAM are split at cook time (see buildrgn.py) into
+// regions a few chunks wide. Only the regions around the camera are kept
+// resident; the others are read from the CD as the camera moves.
+// Streaming is opt-in, for acts that do not fit in RAM otherwise. Streamed
+// acts play no CD-DA music, since every read would pause it.
+#define REGION_MAGIC   "RGN1"
+#define REGION_VERSION 1
+#define REGION_SLOTS   3
+
+uint8_t region_init(TileMap128 *mapping, const char *filename);
+void    region_update(int32_t cam_x, uint8_t wait);
+void    region_unload();
+
+#endif
@@ -9,10 +9,14 @@
 #define CENTERX     (SCREEN_XRES >> 1)
 #define CENTERY     (SCREEN_YRES >> 1)
 
-// Length of the ordering table, i.e. the range Z coordinates can have, 0-15 in
-// this case. Larger values will allow for more granularity with depth (useful
-// when drawing a complex 3D scene) at the expense of RAM usage and performance.
-#define OT_LENGTH 2048
+// Length of the ordering table, i.e. the range Z coordinates can have.
+// Larger values will allow for more granularity with depth (useful when
+// drawing a complex 3D scene) at the expense of RAM usage and performance.
+// 2D scenes only ever use the OTZ_LAYER_* depths below, so that is what
+// scenes get by default. Scenes with 3D models request the full length
+// on load, which is then taken from the scene arena.
+#define OT_LENGTH    2048
+#define OT_LENGTH_2D 16
 
 // Length of the sub ordering table. This ordering table is used for offscreen
 // rendering of some textures like character sprites, which usually need extra
@@ -26,6 +30,12 @@
 //#define BUFFER_LENGTH 40960
 //#define BUFFER_LENGTH 65532
 
+// When defined, swap_buffers does not wait for vblank. The frame just built
+// is handed over to the vblank handler, which flips the display and starts
+// drawing it; meanwhile the CPU goes on building the next frame on the
+// other buffer. Comment out to wait for vblank on every swap instead
+#define RENDER_PIPELINED
+
 // Lerp color with respect to background color (0-128) and target color
 // (useful for fade in and fade out)
 #define LERPC(bg, c) ((c * bg) / 128)
@@ -48,7 +58,7 @@
 typedef struct {
     DISPENV disp_env;
     DRAWENV draw_env;
-    uint32_t ot[OT_LENGTH];
+    uint32_t *ot;
     uint32_t sub_ot[SUB_OT_LENGTH];
     uint8_t  buffer[BUFFER_LENGTH];
 } RenderBuffer;
@@ -57,15 +67,21 @@ typedef struct {
     RenderBuffer buffers[2];
     uint8_t      *next_packet;
     int          active_buffer;
+    uint16_t     ot_length;
 } RenderContext;
 
 void     setup_context();
 void     set_clear_color(uint8_t r, uint8_t g, uint8_t b);
 void     force_clear();
 void     swap_buffers();
+void     render_sync();
+void     render_set_ot_length(uint16_t length);
+int      render_get_buffer_index();
+uint16_t render_get_ot_length();
 void     *get_next_prim();
 uint32_t *get_ot_at(uint32_t otz);
 void     increment_prim(uint32_t size);
+uint32_t render_get_packet_usage();
 void     sort_prim(void *prim, uint32_t otz);
 void     draw_quad(int16_t vx, int16_t vy,
                    int16_t w, int16_t h,
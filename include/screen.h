@@ -2,6 +2,7 @@
 #define SCREEN_H
 
 #include <stdint.h>
+#include "memalloc.h"
 
 typedef enum {
     SCREEN_DISCLAIMER,
@@ -17,6 +18,7 @@ typedef enum {
 } ScreenIndex;
 
 void scene_change(ScreenIndex scr);
+uint8_t scene_was_changed();
 
 void scene_init();
 void scene_load();
@@ -25,6 +27,10 @@ void scene_update();
 void scene_draw();
 
 void *screen_alloc(uint32_t size);
+void *screen_alloc_data(uint32_t size);
+void *screen_alloc_tagged(uint32_t size, ArenaTag tag);
+void screen_push_scope(ArenaScope scope);
+void screen_pop_scope(ArenaScope scope);
 void screen_free();
 void screen_debrief();
 void *screen_get_data();
@@ -49,6 +49,10 @@ void    sound_cdda_init();
 void    sound_cdda_play_track(uint8_t track, uint8_t loops);
 void    sound_cdda_stop();
 void    sound_cdda_set_mute(uint8_t state);
+void    sound_cdda_suspend();
+void    sound_cdda_resume();
+void    sound_cdda_set_blocked(uint8_t state);
+uint8_t sound_cdda_is_playing();
 uint8_t sound_cdda_get_num_tracks();
 
 /* Volume */
@@ -0,0 +1,26 @@
+#ifndef TEXTFMT_H
+#define TEXTFMT_H
+
+#include <stdint.h>
+
+// Small number formatters for on-screen text, meant to replace snprintf
+// on per-frame paths. Every function writes its output at dst, followed
+// by a terminating NUL, and returns a pointer to that NUL so that calls
+// can be chained to build a whole line. Fields are right-aligned up to
+// width characters, and are never truncated.
+#define TEXTFMT_PAD_SPACE ' '
+#define TEXTFMT_PAD_ZERO  '0'
+
+// Same as "%*d" (space pad) or "%0*d" (zero pad)
+char *textfmt_dec(char *dst, int32_t value, uint8_t width, char pad);
+// Same as "%0*X"
+char *textfmt_hex(char *dst, uint32_t value, uint8_t width);
+// Same as "%2d:%02d" with minutes and seconds
+char *textfmt_time(char *dst, uint32_t seconds);
+// 20.12 fixed point with a number of decimal places (at most 4),
+// truncated towards zero, e.g. 0x1800 with 2 decimals is "1.50"
+char *textfmt_fixed(char *dst, int32_t value, uint8_t decimals, uint8_t width);
+// Copies a string, same as "%s"
+char *textfmt_str(char *dst, const char *src);
+
+#endif
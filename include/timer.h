@@ -3,8 +3,15 @@
 
 #include <stdint.h>
 
+// The simulation always steps at 60Hz, regardless of video mode. When a
+// frame takes longer than a vblank to draw (or on PAL), the next frame
+// runs as many steps as needed to catch up, up to this many
+#define TIMER_MAX_STEPS 2
+
 void     timer_init();
 void     timer_update();
+uint8_t  timer_steps();
+void     timer_reset_steps();
 int      get_frame_rate();
 
 uint32_t get_elapsed_frames();
@@ -3,6 +3,8 @@
 
 #include <psxgpu.h>
 #include <psxgte.h>
+#include <psxcd.h>
+#include "vram.h"
 
 // These definitions should be given by CMake
 #ifndef GIT_SHA1
@@ -29,6 +31,21 @@
 #define RGB_TO_CLUT(x) (x >> 3)
 #define CLAMP(x, min, max) (MIN(MAX(x, min), max))
 
+#define LZ_MAGIC       0x534c5a31 // "SLZ1"
+#define LZ_HEADER_SIZE 12
+
+// Header of native (little endian, naturally aligned) asset files, which
+// are used in place once loaded. Offsets within such files are relative to
+// the start of the file
+typedef struct {
+    char     magic[4];
+    uint16_t version;
+    uint16_t _unused;
+} AssetHeader;
+
+// Allocator used to hold file contents, e.g. to read into the scene arena
+typedef void *(*FileAllocator)(uint32_t size);
+
 // Fixed-point RECT
 typedef struct _FRECT {
     int32_t x;
@@ -47,9 +64,31 @@ int RotAverageNclip4(SVECTOR *a, SVECTOR *b, SVECTOR *c, SVECTOR *d,
 void CrossProduct0(VECTOR *v0, VECTOR *v1, VECTOR *out);
 void CrossProduct12(VECTOR *v0, VECTOR *v1, VECTOR *out);
 
+void     file_index_init();
+uint8_t  file_locate(const char *filename, CdlFILE *filepos);
 uint8_t *file_read(const char *filename, uint32_t *length);
+// Like file_read, but files kept uncompressed within a pack on RAM are
+// handed out in place. Only valid while the pack is mounted, and must be
+// released with file_release instead of free
+uint8_t *file_read_view(const char *filename, uint32_t *length);
+void     file_release(uint8_t *bytes);
+uint8_t *file_read_alloc(const char *filename, uint32_t *length, FileAllocator alloc);
+uint8_t *file_read_asset(const char *filename, uint32_t *length, FileAllocator alloc,
+                         const char *magic, uint16_t version);
+uint8_t *file_pack_data(const char *filename, uint32_t *length);
+uint8_t  file_pack_mount(const char *filename);
+void     file_pack_unmount();
+uint8_t  file_pack_prefetch(const char *filename);
+void     file_pack_discard_prefetch();
+uint8_t  lz_header(uint8_t *data, uint32_t length, uint32_t *size, uint32_t *inplace);
+void     lz_decompress(uint8_t *dst, const uint8_t *src, uint32_t size);
 void     load_texture(uint8_t *data, TIM_IMAGE *tim);
+uint8_t  load_texture_at(uint8_t *data, TIM_IMAGE *tim, VramArea *area,
+                         uint16_t ox, uint16_t oy, uint8_t clut_row);
 void     load_clut_only(TIM_IMAGE *tim);
+void     texture_batch_begin();
+void     texture_batch_free(void *data);
+void     texture_batch_end();
 uint16_t clut_get_color(TIM_IMAGE *tim, uint32_t n);
 void     clut_set_color(TIM_IMAGE *tim, uint32_t n, uint8_t r, uint8_t g, uint8_t b);
 void     clut_print_all_colors(TIM_IMAGE *tim);
@@ -0,0 +1,54 @@
+#ifndef VRAM_H
+#define VRAM_H
+
+#include <stdint.h>
+#include <psxgpu.h>
+
+// VRAM allocator. Texture areas are handed out in cells of one texture
+// page wide (64 VRAM pixels) by half the VRAM tall (256 lines), and CLUTs
+// are handed out as whole rows on the bottom of VRAM (480 and below).
+// Framebuffers, the character offscreen renderer and the basic font are
+// never handed out, and neither is the font's CLUT row.
+#define VRAM_CELL_W      64
+#define VRAM_CELL_H      256
+#define VRAM_CELLS_X     16
+#define VRAM_CELLS_Y     2
+#define VRAM_CLUT_Y      480
+#define VRAM_CLUT_ROWS   32
+
+// Well-known areas, allocated once per scene (or once per session, if
+// persistent) and looked up by whatever draws their textures. Areas may
+// also hold CLUT rows only, when allocated with no width or height
+typedef enum {
+    VRAM_AREA_PLAYER,
+    VRAM_AREA_TILES,
+    VRAM_AREA_BG,
+    VRAM_AREA_OBJ_COMMON,
+    VRAM_AREA_OBJ_LEVEL,
+    VRAM_AREA_WATER,
+    VRAM_AREA_MAX,
+} VramAreaId;
+
+typedef enum {
+    VRAM_SCOPE_PERSISTENT,
+    VRAM_SCOPE_SCENE,
+} VramScope;
+
+typedef struct {
+    uint8_t allocated;
+    uint8_t scope;
+    uint8_t resident;  // Cleared when anything else is uploaded over it
+    RECT    prect;
+    RECT    crect;     // One CLUT row per palette, x is always 0
+} VramArea;
+
+void      vram_init();
+VramArea *vram_alloc(VramAreaId id, uint16_t w, uint16_t h,
+                     uint8_t clut_rows, VramScope scope);
+VramArea *vram_get(VramAreaId id);
+uint8_t   vram_area_fits(VramArea *area, RECT *prect, RECT *crect);
+void      vram_free_scene();
+void      vram_written(RECT *rect);
+void      vram_debrief();
+
+#endif
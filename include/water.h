@@ -0,0 +1,19 @@
+#ifndef WATER_H
+#define WATER_H
+
+#include <stdint.h>
+
+// Underwater palettes. Instead of blending a translucent quad over
+// everything below the water surface, things under it are drawn with an
+// underwater copy of their CLUT. These copies are built on level load from
+// the palettes already in VRAM, and live on their own CLUT rows.
+#define WATER_NO_LINE INT16_MAX
+
+void     water_init(int32_t water_y);
+void     water_update(int32_t cam_y);
+int16_t  water_line();
+uint16_t water_clut_row(uint16_t row);
+uint16_t water_clut_row_at(uint16_t row, int16_t vy);
+void     water_tint(uint16_t *dst, const uint16_t *src, uint16_t n);
+
+#endif
@@ -1,5 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <strings.h>
 #include "basic_font.h"
 #include "render.h"
 #include "util.h"
@@ -221,9 +223,60 @@ static uint8_t glyph_info_hg[] = {
     0xff, 0, 0, 0, // > (no char)
 };
 
+// Special entries of the glyph lookup tables. Anything below these is an
+// index into the glyph info table of that font
+#define GLYPH_SPACE   0xfa
+#define GLYPH_NEWLINE 0xfb
+#define GLYPH_TAB     0xfc
+#define GLYPH_RESET   0xfd  // \r
+#define GLYPH_ESCAPE  0xfe  // \a, followed by a color code
+#define GLYPH_BLANK   0xff  // No glyph on this font, skip as whitespace
+
+typedef struct {
+    uint8_t *ginfo;
+    uint8_t ws_w, ws_h, gap;
+    uint8_t lut[256];
+} FontFace;
+
+static FontFace font_faces[] = {
+    { glyph_info_big, GLYPH_WHITE_WIDTH,     GLYPH_WHITE_HEIGHT,     GLYPH_GAP     },
+    { glyph_info_md,  GLYPH_MD_WHITE_WIDTH,  GLYPH_MD_WHITE_HEIGHT,  GLYPH_MD_GAP  },
+    { glyph_info_sm,  GLYPH_SML_WHITE_WIDTH, GLYPH_SML_WHITE_HEIGHT, GLYPH_SML_GAP },
+    { glyph_info_hg,  GLYPH_HG_WHITE_WIDTH,  GLYPH_HG_WHITE_HEIGHT,  GLYPH_HG_GAP  },
+};
+
+static void
+_font_build_lut(FontFace *face)
+{
+    static const char symbols[] = "*.:-=!?<>";
+    for(int c = 0; c < 256; c++) {
+        uint8_t offset = GLYPH_BLANK;
+        if((c >= 'a') && (c <= 'z'))      offset = c - 'a';
+        else if((c >= 'A') && (c <= 'Z')) offset = c - 'A';
+        else if((c >= '0') && (c <= '9')) offset = 26 + (c - '0');
+        else {
+            for(uint8_t i = 0; symbols[i] != '\0'; i++)
+                if(symbols[i] == c) offset = 36 + i;
+        }
+
+        // Glyphs missing from this font are skipped as whitespace
+        if((offset != GLYPH_BLANK) && (face->ginfo[offset << 2] == 0xff))
+            offset = GLYPH_BLANK;
+        face->lut[c] = offset;
+    }
+    face->lut[' ']  = GLYPH_SPACE;
+    face->lut['\n'] = GLYPH_NEWLINE;
+    face->lut['\t'] = GLYPH_TAB;
+    face->lut['\r'] = GLYPH_RESET;
+    face->lut['\a'] = GLYPH_ESCAPE;
+}
+
 void
 font_init()
 {
+    for(int i = 0; i < FONT_MAX; i++)
+        _font_build_lut(&font_faces[i]);
+
     // Upload font to VRAM
     TIM_IMAGE tim;
     uint32_t length;
@@ -267,73 +320,24 @@ _draw_glyph(
 }
 
 uint16_t
-_font_measurew_generic(const char *text,
-                       const uint8_t ws_w,
-                       const uint8_t gap,
-                       uint8_t *ginfo)
+_font_measurew_generic(const char *text, FontFace *face)
 {
     uint16_t w = 0;
     uint16_t vx = 0;
-    while(*text != '\0') {
-        switch(*text) {
-        case ' ':
-            vx += ws_w + gap;
-            text++;
-            continue;
-        case '\n':
-            vx = 0;
-            text++;
-            continue;
-        case '\t':
-            vx += (ws_w << 2) + (gap << 2);
-            text++;
-            continue;
-        case '\r':
-            text++;
-            continue;
-        case '\a':
+    for(; *text != '\0'; text++) {
+        uint8_t glyph = face->lut[(uint8_t)*text];
+        switch(glyph) {
+        case GLYPH_SPACE:   vx += face->ws_w + face->gap;               continue;
+        case GLYPH_NEWLINE: vx = 0;                                     continue;
+        case GLYPH_TAB:     vx += (face->ws_w << 2) + (face->gap << 2); continue;
+        case GLYPH_RESET:                                               continue;
+        case GLYPH_ESCAPE:
             // Jump two characters
-            text += 2;
+            if(*(++text) == '\0') return w;
             continue;
+        case GLYPH_BLANK:   vx += face->ws_w + face->gap; break;
+        default:            vx += face->ginfo[(glyph << 2) + 2] + face->gap; break;
         }
-
-        uint8_t offset = 0xff;
-
-        if((*text >= 'a') && (*text <= 'z'))
-            offset = (uint8_t)((unsigned)(*text) - (unsigned)('a'));
-        else if((*text >= 'A') && (*text <= 'Z'))
-            offset = (uint8_t)((unsigned)(*text) - (unsigned)('A'));
-        else if((*text >= '0') && (*text <= '9')) {
-            offset = 26 + (uint8_t)((unsigned)(*text) - (unsigned)('0'));
-        } else {
-            switch(*text) {
-            case '*': offset = 36; break;
-            case '.': offset = 37; break;
-            case ':': offset = 38; break;
-            case '-': offset = 39; break;
-            case '=': offset = 40; break;
-            case '!': offset = 41; break;
-            case '?': offset = 42; break;
-            case '<': offset = 43; break;
-            case '>': offset = 44; break;
-            default:  offset = 0xff; break;
-            }
-        }
-
-        uint8_t gw = ws_w;
-        if(offset != 0xff) {
-            uint8_t *info = &ginfo[offset * 4];
-            if(info[0] == 0xff) {
-                // Glyph doesn't exist, so don't draw
-                goto jump_ws;
-            }
-            gw = info[2];
-        }
-
-    jump_ws:
-        vx += gw + gap;
-        text++;
-
         if(vx > w) w = vx;
     }
     return w;
@@ -342,160 +346,259 @@ _font_measurew_generic(const char *text,
 uint16_t
 font_measurew_big(const char *text)
 {
-    return _font_measurew_generic(
-        text, GLYPH_WHITE_WIDTH, GLYPH_GAP, glyph_info_big);
+    return _font_measurew_generic(text, &font_faces[FONT_BIG]);
 }
 
 uint16_t
 font_measurew_md(const char *text)
 {
-    return _font_measurew_generic(
-        text, GLYPH_MD_WHITE_WIDTH, GLYPH_MD_GAP, glyph_info_md);
+    return _font_measurew_generic(text, &font_faces[FONT_MD]);
 }
 
 uint16_t
 font_measurew_sm(const char *text)
 {
-   return _font_measurew_generic(
-       text, GLYPH_SML_WHITE_WIDTH, GLYPH_SML_GAP, glyph_info_sm);
+    return _font_measurew_generic(text, &font_faces[FONT_SM]);
 }
 
 uint16_t
 font_measurew_hg(const char *text)
 {
-   return _font_measurew_generic(
-       text, GLYPH_HG_WHITE_WIDTH, GLYPH_HG_GAP, glyph_info_hg);
+    return _font_measurew_generic(text, &font_faces[FONT_HG]);
+}
+
+static void
+_font_escape_color(char code)
+{
+    switch(code) {
+    case 's': font_set_color_sonic();    break;
+    case 't': font_set_color_miles();    break;
+    case 'k': font_set_color_knuckles(); break;
+    case 'a': font_set_color_amy();      break;
+    case 'y': font_set_color_yellow();   break;
+    case 'w': font_set_color_white();    break;
+    case 'z': font_set_color_super();    break;
+    case 'd': font_set_color_default();  break;
+    }
 }
 
 void
-_font_draw_generic(const char *text, int16_t vx, int16_t vy,
-                   const uint8_t ws_w, const uint8_t ws_h,
-                   const uint8_t gap,
-                   uint8_t *ginfo)
+_font_draw_generic(const char *text, int16_t vx, int16_t vy, FontFace *face)
 {
     int16_t start_vx = vx;
-    while(*text != '\0') {
-        switch(*text) {
-        case ' ':
-            vx += ws_w + gap;
-            text++;
-            continue;
-        case '\n':
-            vy += ws_h + gap;
+    for(; *text != '\0'; text++) {
+        uint8_t glyph = face->lut[(uint8_t)*text];
+        switch(glyph) {
+        case GLYPH_SPACE:
+        case GLYPH_BLANK:
+            vx += face->ws_w + face->gap;
+            break;
+        case GLYPH_NEWLINE:
+            vy += face->ws_h + face->gap;
             vx = start_vx;
-            text++;
-            continue;
-        case '\t':
-            vx += (ws_w << 2) + (gap << 2);
-            text++;
-            continue;
-        }
-
-        uint8_t offset = 0xff;
-
-        if((*text >= 'a') && (*text <= 'z'))
-            offset = (uint8_t)((unsigned)(*text) - (unsigned)('a'));
-        else if((*text >= 'A') && (*text <= 'Z'))
-            offset = (uint8_t)((unsigned)(*text) - (unsigned)('A'));
-        else if((*text >= '0') && (*text <= '9')) {
-            offset = 26 + (uint8_t)((unsigned)(*text) - (unsigned)('0'));
-        } else {
-            switch(*text) {
-            case '*': offset = 36; break;
-            case '.': offset = 37; break;
-            case ':': offset = 38; break;
-            case '-': offset = 39; break;
-            case '=': offset = 40; break;
-            case '!': offset = 41; break;
-            case '?': offset = 42; break;
-            case '<': offset = 43; break;
-            case '>': offset = 44; break;
-            case '\a':
-                text++;
-                switch(*text) {
-                case 's':
-                    font_set_color_sonic();
-                    break;
-                case 't':
-                    font_set_color_miles();
-                    break;
-                case 'k':
-                    font_set_color_knuckles();
-                    break;
-                case 'a':
-                    font_set_color_amy();
-                    break;
-                case 'y':
-                    font_set_color_yellow();
-                    break;
-                case 'w':
-                    font_set_color_white();
-                    break;
-                case 'z':
-                    font_set_color_super();
-                    break;
-                case 'd':
-                    font_set_color_default();
-                    break;
-                }
-                offset = 0xfe;
-                break;
-            case '\r':
-                offset = 0xfe;
-                font_reset_color();
-                break;
-            default:  offset = 0xff; break;
-            }
-        }
-
-        uint8_t gw = ws_w;
-        if(offset < 0xfe) {
-            uint8_t *info = &ginfo[offset * 4];
-            if(info[0] == 0xff) {
-                // Glyph doesn't exist, so don't draw
-                goto jump_ws;
-            }
-            gw = info[2];
+            break;
+        case GLYPH_TAB:
+            vx += (face->ws_w << 2) + (face->gap << 2);
+            break;
+        case GLYPH_RESET:
+            font_reset_color();
+            break;
+        case GLYPH_ESCAPE:
+            if(*(++text) == '\0') return;
+            _font_escape_color(*text);
+            break;
+        default: {
+            uint8_t *info = &face->ginfo[glyph << 2];
             _draw_glyph(vx, vy, info[0], info[1], info[2], info[3]);
+            vx += info[2] + face->gap;
+        } break;
         }
-
-    jump_ws:
-        if(offset != 0xfe)
-            vx += gw + gap;
-        text++;
     }
 }
 
 void
 font_draw_big(const char *text, int16_t vx, int16_t vy)
 {
-    _font_draw_generic(text, vx, vy,
-                       GLYPH_WHITE_WIDTH, GLYPH_WHITE_HEIGHT, GLYPH_GAP,
-                       glyph_info_big);
+    _font_draw_generic(text, vx, vy, &font_faces[FONT_BIG]);
 }
 
 void
 font_draw_md(const char *text, int16_t vx, int16_t vy)
 {
-    _font_draw_generic(text, vx, vy,
-                       GLYPH_MD_WHITE_WIDTH, GLYPH_MD_WHITE_HEIGHT, GLYPH_MD_GAP,
-                       glyph_info_md);
+    _font_draw_generic(text, vx, vy, &font_faces[FONT_MD]);
 }
 
 void
 font_draw_sm(const char *text, int16_t vx, int16_t vy)
 {
-    _font_draw_generic(text, vx, vy,
-                       GLYPH_SML_WHITE_WIDTH, GLYPH_SML_WHITE_HEIGHT, GLYPH_SML_GAP,
-                       glyph_info_sm);
+    _font_draw_generic(text, vx, vy, &font_faces[FONT_SM]);
 }
 
 void
 font_draw_hg(const char *text, int16_t vx, int16_t vy)
 {
-    _font_draw_generic(text, vx, vy,
-                       GLYPH_HG_WHITE_WIDTH, GLYPH_HG_WHITE_HEIGHT, GLYPH_HG_GAP,
-                       glyph_info_hg);
+    _font_draw_generic(text, vx, vy, &font_faces[FONT_HG]);
+}
+
+void
+font_text_bake(FontText *ftext, FontSize size, const char *text)
+{
+    FontFace *face = &font_faces[size];
+    int16_t vx = 0, vy = 0;
+    uint8_t saved[3] = { font_color[0], font_color[1], font_color[2] };
+    uint8_t flags = 0;
+
+    // Color escapes are resolved now, using the regular color setters
+    ftext->num_glyphs = 0;
+    ftext->width = _font_measurew_generic(text, face);
+    for(; *text != '\0'; text++) {
+        uint8_t glyph = face->lut[(uint8_t)*text];
+        switch(glyph) {
+        case GLYPH_SPACE:
+        case GLYPH_BLANK:
+            vx += face->ws_w + face->gap;
+            break;
+        case GLYPH_NEWLINE:
+            vy += face->ws_h + face->gap;
+            vx = 0;
+            break;
+        case GLYPH_TAB:
+            vx += (face->ws_w << 2) + (face->gap << 2);
+            break;
+        case GLYPH_RESET:
+            font_set_color_default();
+            flags = FONT_TEXT_FIXED | FONT_TEXT_UNFADED;
+            break;
+        case GLYPH_ESCAPE:
+            if(*(++text) == '\0') goto done;
+            _font_escape_color(*text);
+            flags |= FONT_TEXT_FIXED;
+            break;
+        default: {
+            if(ftext->num_glyphs >= FONT_TEXT_MAX_GLYPHS) goto done;
+            uint8_t *info = &face->ginfo[glyph << 2];
+            FontTextGlyph *g = &ftext->glyphs[ftext->num_glyphs++];
+            g->x = vx;
+            g->y = vy;
+            g->u0 = info[0];
+            g->v0 = info[1];
+            g->w = info[2];
+            g->h = info[3];
+            g->flags = flags;
+            g->rgb[0] = font_color[0];
+            g->rgb[1] = font_color[1];
+            g->rgb[2] = font_color[2];
+            vx += info[2] + face->gap;
+        } break;
+        }
+    }
+
+done:
+    // Drawing leaves the font color as the text would have left it
+    ftext->end_flags = flags;
+    ftext->end_rgb[0] = font_color[0];
+    ftext->end_rgb[1] = font_color[1];
+    ftext->end_rgb[2] = font_color[2];
+    font_set_color(saved[0], saved[1], saved[2]);
+}
+
+void
+font_text_draw(FontText *ftext, int16_t vx, int16_t vy)
+{
+    for(uint8_t i = 0; i < ftext->num_glyphs; i++) {
+        FontTextGlyph *g = &ftext->glyphs[i];
+        uint8_t *rgb = (g->flags & FONT_TEXT_FIXED) ? g->rgb : font_color;
+        uint8_t fade = (g->flags & FONT_TEXT_UNFADED) ? 128 : font_fade;
+        SPRT *sprt = get_next_prim();
+        increment_prim(sizeof(SPRT));
+        setSprt(sprt);
+        setRGB0(sprt,
+                LERPC(fade, rgb[0]),
+                LERPC(fade, rgb[1]),
+                LERPC(fade, rgb[2]));
+        setXY0(sprt, vx + g->x, vy + g->y);
+        setWH(sprt, g->w, g->h);
+        setUV0(sprt, g->u0, g->v0);
+        sprt->clut = getClut(0, 490);
+        sort_prim(sprt, OTZ_LAYER_HUD);
+    }
+
+    if(ftext->end_flags & FONT_TEXT_UNFADED) font_reset_color();
+    if(ftext->end_flags & FONT_TEXT_FIXED)
+        font_set_color(ftext->end_rgb[0], ftext->end_rgb[1], ftext->end_rgb[2]);
+}
+
+void
+font_run_init(FontRun *run, int16_t vx, int16_t vy)
+{
+    bzero(run, sizeof(FontRun));
+    run->vx = vx;
+    run->vy = vy;
+    run->rgb[0] = run->rgb[1] = run->rgb[2] = 128;
+}
+
+void
+font_run_set_text(FontRun *run, const char *text)
+{
+    strncpy(run->text, text, FONT_RUN_MAX_GLYPHS);
+    run->text[FONT_RUN_MAX_GLYPHS] = '\0';
+}
+
+void
+font_run_set_color(FontRun *run, uint8_t r0, uint8_t g0, uint8_t b0)
+{
+    run->rgb[0] = LERPC(font_fade, r0);
+    run->rgb[1] = LERPC(font_fade, g0);
+    run->rgb[2] = LERPC(font_fade, b0);
+}
+
+static void
+_font_run_build(FontRun *run, uint8_t buf)
+{
+    FontRunBuffer *built = &run->built[buf];
+    SPRT *sprt = run->sprt[buf];
+    uint8_t n = 0;
+    int16_t vx = run->vx;
+
+    for(const char *text = run->text; *text != '\0'; text++) {
+        uint8_t glyph = font_faces[FONT_BIG].lut[(uint8_t)*text];
+        if(glyph >= GLYPH_SPACE) {
+            vx += GLYPH_WHITE_WIDTH + GLYPH_GAP;
+            continue;
+        }
+
+        uint8_t *info = &glyph_info_big[glyph << 2];
+        setSprt(&sprt[n]);
+        setRGB0(&sprt[n], run->rgb[0], run->rgb[1], run->rgb[2]);
+        setXY0(&sprt[n], vx, run->vy);
+        setWH(&sprt[n], info[2], info[3]);
+        setUV0(&sprt[n], info[0], info[1]);
+        sprt[n].clut = getClut(0, 490);
+        // Sprites of a run are chained once, and linked to the OT as a whole
+        if(n > 0) setaddr(&sprt[n - 1], &sprt[n]);
+        vx += info[2] + GLYPH_GAP;
+        n++;
+    }
+
+    built->num_glyphs = n;
+    memcpy(built->text, run->text, sizeof(built->text));
+    memcpy(built->rgb, run->rgb, sizeof(built->rgb));
+}
+
+void
+font_run_draw(FontRun *run)
+{
+    // The other buffer's sprites may still be read by the GPU, so only
+    // the ones for the frame being built are ever touched
+    uint8_t buf = render_get_buffer_index();
+    FontRunBuffer *built = &run->built[buf];
+    if((memcmp(built->rgb, run->rgb, sizeof(run->rgb)) != 0)
+       || (strcmp(built->text, run->text) != 0))
+        _font_run_build(run, buf);
+
+    if(built->num_glyphs == 0) return;
+    addPrims(get_ot_at(OTZ_LAYER_HUD),
+             &run->sprt[buf][0], &run->sprt[buf][built->num_glyphs - 1]);
 }
 
 void
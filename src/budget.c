@@ -0,0 +1,85 @@
+#include "budget.h"
+#include <strings.h>
+#include "render.h"
+#include "util.h"
+
+static struct {
+    uint16_t    counts[BUDGET_KIND_MAX]; // Frame being drawn
+    uint16_t    last[BUDGET_KIND_MAX];   // Last frame drawn
+    uint8_t     load;
+    uint8_t     hold;
+    uint8_t     stepped_load;               // Load when detail was dropped
+    uint8_t     saving[BUDGET_LEVEL_MAX];   // What dropping it saved
+    BudgetLevel level;
+} _budget = { 0 };
+
+void
+budget_reset()
+{
+    bzero(&_budget, sizeof(_budget));
+    _budget.level = BUDGET_LEVEL_FULL;
+}
+
+void
+budget_count(BudgetKind kind, uint16_t n)
+{
+    _budget.counts[kind] += n;
+}
+
+void
+budget_end_frame()
+{
+    uint32_t prims = 0;
+    for(uint8_t i = 0; i < BUDGET_KIND_MAX; i++) {
+        prims += _budget.counts[i];
+        _budget.last[i] = _budget.counts[i];
+        _budget.counts[i] = 0;
+    }
+
+    // Whichever runs out first is what the load is
+    uint32_t load = (prims * 100) / BUDGET_MAX_PRIMS;
+    load = MAX(load, (render_get_packet_usage() * 100) / BUFFER_LENGTH);
+    _budget.load = MIN(load, 255);
+
+    // The frame after dropping detail tells how much load that took off
+    if(_budget.stepped_load > 0) {
+        _budget.saving[_budget.level] =
+            (_budget.stepped_load > _budget.load)
+            ? _budget.stepped_load - _budget.load
+            : 0;
+        _budget.stepped_load = 0;
+    }
+
+    // Detail only comes back if the load would still stay low with it
+    if(_budget.load >= BUDGET_HIGH) {
+        if(_budget.level < BUDGET_LEVEL_MAX - 1) {
+            _budget.stepped_load = _budget.load;
+            _budget.level++;
+        }
+        _budget.hold = 0;
+    } else if((_budget.level > BUDGET_LEVEL_FULL)
+              && (_budget.load + _budget.saving[_budget.level] < BUDGET_LOW)) {
+        if(++_budget.hold >= BUDGET_HOLD_FRAMES) {
+            _budget.level--;
+            _budget.hold = 0;
+        }
+    } else _budget.hold = 0;
+}
+
+BudgetLevel
+budget_level()
+{
+    return _budget.level;
+}
+
+uint8_t
+budget_load()
+{
+    return _budget.load;
+}
+
+uint16_t
+budget_get_count(BudgetKind kind)
+{
+    return _budget.last[kind];
+}
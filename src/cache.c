@@ -0,0 +1,166 @@
+#include "cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "memalloc.h"
+#include "util.h"
+
+static uint8_t        cache_data[CACHE_BUFFER_LEN] = { 0 };
+static ArenaAllocator cache_arena;
+static CacheEntry     cache_entries[CACHE_MAX_ENTRIES];
+static uint8_t        cache_num_entries = 0;
+
+void
+cache_init()
+{
+    alloc_arena_init(&cache_arena, cache_data, CACHE_BUFFER_LEN);
+    cache_num_entries = 0;
+}
+
+// Nothing is ever evicted from the cache, so once it is full callers get
+// NULL and should keep their data elsewhere
+void *
+cache_alloc(uint32_t size)
+{
+    uint32_t aligned = (size + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+    if(aligned > alloc_arena_bytes_free(&cache_arena)) {
+        printf("Warning: Asset cache is full, %u bytes not cached\n", size);
+        return NULL;
+    }
+    void *ptr = alloc_arena_malloc(&cache_arena, size);
+    bzero(ptr, size);
+    return ptr;
+}
+
+CacheEntry *
+cache_find(const char *path)
+{
+    uint32_t hash = adler32(path);
+    for(uint8_t i = 0; i < cache_num_entries; i++) {
+        if((cache_entries[i].hash == hash)
+           && !strcmp(cache_entries[i].path, path))
+            return &cache_entries[i];
+    }
+    return NULL;
+}
+
+CacheEntry *
+cache_insert(const char *path)
+{
+    CacheEntry *entry = cache_find(path);
+    if(entry) return entry;
+
+    if(cache_num_entries >= CACHE_MAX_ENTRIES) {
+        printf("Warning: Asset cache is full, not caching %s\n", path);
+        return NULL;
+    }
+
+    char *entry_path = cache_alloc(strlen(path) + 1);
+    if(!entry_path) return NULL;
+    strcpy(entry_path, path);
+
+    entry = &cache_entries[cache_num_entries++];
+    *entry = (CacheEntry){ 0 };
+    entry->hash = adler32(path);
+    entry->path = entry_path;
+    return entry;
+}
+
+void *
+cache_get(const char *path)
+{
+    CacheEntry *entry = cache_find(path);
+    return entry ? entry->data : NULL;
+}
+
+void
+cache_put(const char *path, void *data)
+{
+    CacheEntry *entry = cache_insert(path);
+    if(entry) entry->data = data;
+}
+
+uint8_t
+cache_load_texture(const char *path, TIM_IMAGE *tim, VramArea *area)
+{
+    CacheEntry *entry = cache_find(path);
+    if(!entry || !(entry->residency & CACHE_RESIDENT_VRAM)
+       || (area && !area->resident)) {
+        uint32_t length;
+        uint8_t *file = file_read(path, &length);
+        if(!file) return 0;
+        if(!load_texture_at(file, tim, area, 0, 0, 0)) {
+            texture_batch_free(file);
+            return 0;
+        }
+
+        // Uploading may have invalidated an older copy of this very entry,
+        // so only mark it as resident afterwards
+        entry = cache_insert(path);
+        if(!entry) {
+            texture_batch_free(file);
+            return 1;
+        }
+        entry->mode = tim->mode;
+        entry->prect = *tim->prect;
+        entry->has_clut = (tim->mode & 0x8) != 0;
+        if(entry->has_clut) entry->crect = *tim->crect;
+        entry->residency |= CACHE_RESIDENT_VRAM;
+        texture_batch_free(file);
+
+        // The file is gone, so point at the entry's copy instead
+        tim->prect = &entry->prect;
+        tim->crect = entry->has_clut ? &entry->crect : NULL;
+        tim->paddr = NULL;
+        tim->caddr = NULL;
+        return 1;
+    }
+
+    // Texture is still in VRAM. Pixel data is not available anymore,
+    // but position and mode are enough for setting up primitives
+    printf("Texture %s already in VRAM\n", path);
+    tim->mode = entry->mode;
+    tim->prect = &entry->prect;
+    tim->crect = entry->has_clut ? &entry->crect : NULL;
+    tim->paddr = NULL;
+    tim->caddr = NULL;
+    return 1;
+}
+
+static uint8_t
+_rect_overlaps(RECT *a, RECT *b)
+{
+    return (a->x < b->x + b->w) && (b->x < a->x + a->w)
+        && (a->y < b->y + b->h) && (b->y < a->y + a->h);
+}
+
+void
+cache_vram_written(RECT *rect)
+{
+    for(uint8_t i = 0; i < cache_num_entries; i++) {
+        CacheEntry *entry = &cache_entries[i];
+        if(!(entry->residency & CACHE_RESIDENT_VRAM)) continue;
+        if(_rect_overlaps(rect, &entry->prect)
+           || (entry->has_clut && _rect_overlaps(rect, &entry->crect)))
+            entry->residency &= ~CACHE_RESIDENT_VRAM;
+    }
+}
+
+void
+cache_invalidate_residency(uint8_t residency)
+{
+    for(uint8_t i = 0; i < cache_num_entries; i++)
+        cache_entries[i].residency &= ~residency;
+}
+
+void
+cache_debrief()
+{
+    printf("Cache entries:    %u / %u\n"
+           "Cache bytes used: %u\n"
+           "Cache bytes free: %u\n",
+           cache_num_entries, CACHE_MAX_ENTRIES,
+           alloc_arena_bytes_used(&cache_arena),
+           alloc_arena_bytes_free(&cache_arena));
+}
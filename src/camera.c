@@ -2,6 +2,7 @@
 #include "render.h"
 #include "level.h"
 #include "util.h"
+#include "timer.h"
 #include <stdlib.h>
 #include <stdio.h>
 
@@ -18,6 +19,7 @@
 #define CAMERA_EXTEND_Y_UP    (104 << 12)
 #define CAMERA_EXTEND_Y_DOWN  (88 << 12)
 #define CAMERA_MOVE_DELAY     120
+#define CAMERA_LOOKAHEAD      TIMER_MAX_STEPS
 
 extern uint8_t paused;
 
@@ -25,7 +27,7 @@ void
 camera_init(Camera *c)
 {
     camera_set(c, CENTERX_FIXP, CENTERY_FIXP);
-    c->pos.vz = c->realpos.vz = 0;
+    c->pos.vz = c->realpos.vz = c->lookahead.vz = 0;
     c->extension_x = c->extension_y = 0;
     c->delay = 0;
     c->lag = 0;
@@ -42,6 +44,9 @@ camera_update(Camera *c, Player *player)
         c->focus = player->pos;
     }
 
+    int32_t oldx = c->pos.vx;
+    int32_t oldy = c->pos.vy;
+
     int32_t deltax = 0;
     int32_t deltay = 0;
 
@@ -144,6 +149,15 @@ camera_update(Camera *c, Player *player)
 
     if(c->pos.vy < CENTERY_FIXP) c->pos.vy = CENTERY_FIXP;
     else if(c->pos.vy > CAMERAY_MAX) c->pos.vy = CAMERAY_MAX;
+
+    // A frame may run as many steps as the timer allows, so look that far
+    // ahead. Whatever is about to scroll in can then be resolved early
+    c->vel.vx = c->pos.vx - oldx;
+    c->vel.vy = c->pos.vy - oldy;
+    c->lookahead.vx = CLAMP(c->pos.vx + (c->vel.vx * CAMERA_LOOKAHEAD),
+                            c->min_x, c->max_x);
+    c->lookahead.vy = CLAMP(c->pos.vy + (c->vel.vy * CAMERA_LOOKAHEAD),
+                            CENTERY_FIXP, CAMERAY_MAX);
 }
 
 void
@@ -151,6 +165,9 @@ camera_set(Camera *c, int32_t vx, int32_t vy)
 {
     c->pos.vx = c->realpos.vx = vx;
     c->pos.vy = c->realpos.vy = vy;
+    c->vel.vx = c->vel.vy = c->vel.vz = 0;
+    c->lookahead.vx = vx;
+    c->lookahead.vy = vy;
 }
 
 void
@@ -0,0 +1,423 @@
+#include "cdload.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <psxcd.h>
+#include "util.h"
+#include "cache.h"
+#include "sound.h"
+
+#define CDLOAD_NAME_LEN 64
+
+typedef struct {
+    char           filename[CDLOAD_NAME_LEN];
+    uint32_t       offset;  // Sector-aligned
+    uint32_t       length;  // Zero reads up to the end of the file
+    CdLoadCallback cb;
+    void           *userdata;
+} CdLoadRequest;
+
+static CdLoadRequest _queue[CDLOAD_QUEUE_LEN];
+static uint8_t       _queue_head = 0;
+static uint8_t       _queue_count = 0;
+
+static uint32_t _buffers[2][CDLOAD_CHUNK_SIZE / 4];
+
+// State of the request currently being serviced
+static struct {
+    uint8_t  active;
+    uint8_t  reading;
+    uint8_t  buffer;     // Buffer the drive is reading into
+    int      lba;
+    uint32_t size;
+    uint32_t offset;     // Bytes already handed to the callback
+    uint32_t next_read;  // Offset of the next chunk to request
+    uint8_t  whole;      // Whether the whole file is being read
+
+    // Compressed files are gathered whole and decompressed in place
+    uint8_t  *lz;
+    uint32_t lz_start;
+    uint32_t lz_size;
+} _cur = { 0 };
+
+// VRAM uploads that may still be reading from a sector buffer, or from
+// data handed over from elsewhere. These are only waited for when that
+// memory is about to be reused, so a frame being drawn in the meantime
+// does not stall the loader on every chunk
+static uint8_t _uploading[2] = { 0 };
+static uint8_t _uploading_other = 0;
+
+static void
+_upload_started(const void *src)
+{
+    const uint8_t *p = (const uint8_t *)src;
+    for(int i = 0; i < 2; i++) {
+        const uint8_t *buf = (const uint8_t *)_buffers[i];
+        if((p >= buf) && (p < buf + CDLOAD_CHUNK_SIZE)) {
+            _uploading[i] = 1;
+            return;
+        }
+    }
+    _uploading_other = 1;
+}
+
+static void
+_uploads_synced()
+{
+    _uploading[0] = _uploading[1] = 0;
+    _uploading_other = 0;
+}
+
+uint8_t
+cdload_request(const char *filename, CdLoadCallback cb, void *userdata)
+{
+    return cdload_request_range(filename, 0, 0, cb, userdata);
+}
+
+uint8_t
+cdload_request_range(const char *filename, uint32_t offset, uint32_t length,
+                     CdLoadCallback cb, void *userdata)
+{
+    if(_queue_count >= CDLOAD_QUEUE_LEN) {
+        printf("CD load queue is full, dropping %s\n", filename);
+        return 0;
+    }
+    CdLoadRequest *req =
+        &_queue[(_queue_head + _queue_count) % CDLOAD_QUEUE_LEN];
+    strncpy(req->filename, filename, CDLOAD_NAME_LEN - 1);
+    req->filename[CDLOAD_NAME_LEN - 1] = '\0';
+    req->offset = offset;
+    req->length = length;
+    req->cb = cb;
+    req->userdata = userdata;
+    _queue_count++;
+    return 1;
+}
+
+uint8_t
+cdload_busy()
+{
+    return _cur.active || (_queue_count > 0);
+}
+
+static void
+_start_read()
+{
+    CdlLOC loc;
+    uint32_t remaining = _cur.size - _cur.next_read;
+    int numsectors = (remaining + 2047) / 2048;
+    if(numsectors > CDLOAD_CHUNK_SECTORS) numsectors = CDLOAD_CHUNK_SECTORS;
+
+    if(_uploading[_cur.buffer]) {
+        DrawSync(0);
+        _uploads_synced();
+    }
+
+    CdIntToPos(_cur.lba + (_cur.next_read / 2048), &loc);
+    CdControl(CdlSetloc, (uint8_t *) &loc, 0);
+    CdRead(numsectors, _buffers[_cur.buffer], CdlModeSpeed);
+    _cur.reading = 1;
+}
+
+static uint32_t
+_range_length(CdLoadRequest *req, uint32_t size)
+{
+    if(req->offset >= size) return 0;
+    size -= req->offset;
+    if(req->length && (req->length < size)) return req->length;
+    return size;
+}
+
+static void
+_deliver_unpacked(CdLoadRequest *req, uint8_t *data, uint32_t size)
+{
+    req->cb(data, 0, size, 1, req->userdata);
+    // The callback may have left a VRAM upload from this buffer pending
+    if(_uploading_other) {
+        DrawSync(0);
+        _uploads_synced();
+    }
+    free(data);
+}
+
+static void
+_finish_request()
+{
+    _cur.active = 0;
+    _queue_head = (_queue_head + 1) % CDLOAD_QUEUE_LEN;
+    _queue_count--;
+
+    // Music can only go on once nothing else needs the drive
+    if(_queue_count == 0) sound_cdda_resume();
+}
+
+uint8_t
+cdload_process()
+{
+    if(!_cur.active) {
+        if(_queue_count == 0) return 0;
+        CdLoadRequest *req = &_queue[_queue_head];
+
+        // Files within a mounted pack are already on RAM
+        uint32_t length;
+        uint8_t *data = file_pack_data(req->filename, &length);
+        if(data) {
+            uint32_t usize, inplace;
+            uint8_t whole = (req->offset == 0) && (req->length == 0);
+            if(whole && lz_header(data, length, &usize, &inplace)) {
+                uint8_t *buffer = (uint8_t *) malloc(usize);
+                if(buffer) {
+                    lz_decompress(buffer, data + LZ_HEADER_SIZE, usize);
+                    _deliver_unpacked(req, buffer, usize);
+                } else {
+                    printf("Error allocating %d bytes.\n", usize);
+                    req->cb(NULL, 0, 0, 1, req->userdata);
+                }
+            } else {
+                length = _range_length(req, length);
+                req->cb(data + req->offset, 0, length, 1, req->userdata);
+            }
+            _finish_request();
+            return cdload_busy();
+        }
+
+        CdlFILE filepos;
+        if(!file_locate(req->filename, &filepos)) {
+            printf("File %s not found!\n", req->filename);
+            req->cb(NULL, 0, 0, 1, req->userdata);
+            _finish_request();
+            return cdload_busy();
+        }
+
+        _cur.active = 1;
+        _cur.lba = CdPosToInt(&filepos.pos) + (req->offset / 2048);
+        _cur.size = _range_length(req, filepos.size);
+        _cur.whole = (req->offset == 0) && (req->length == 0);
+        _cur.offset = 0;
+        _cur.next_read = 0;
+        _cur.buffer = 0;
+        _cur.lz = NULL;
+        sound_cdda_suspend();
+        _start_read();
+        return 1;
+    }
+
+    // Still waiting on the drive?
+    int status = CdReadSync(1, 0);
+    if(status > 0) return 1;
+    if(status < 0) {
+        // Read error, retry the same chunk
+        _start_read();
+        return 1;
+    }
+
+    CdLoadRequest *req = &_queue[_queue_head];
+    uint8_t  done = _cur.buffer;
+    uint32_t length = _cur.size - _cur.offset;
+    if(length > CDLOAD_CHUNK_SIZE) length = CDLOAD_CHUNK_SIZE;
+    uint8_t  last = (_cur.offset + length) >= _cur.size;
+    _cur.reading = 0;
+
+    // Start reading the next chunk into the other buffer before handing
+    // this one over. The other buffer may still be the source of a VRAM
+    // upload issued by the previous callback, which _start_read waits for
+    _cur.next_read = _cur.offset + length;
+    if(!last) {
+        _cur.buffer ^= 1;
+        _start_read();
+    }
+
+    uint8_t *chunk = (uint8_t *)_buffers[done];
+    uint32_t usize, inplace;
+    if(_cur.whole && (_cur.offset == 0)
+       && lz_header(chunk, length, &usize, &inplace)) {
+        // Compressed data cannot be consumed chunk by chunk, so gather the
+        // whole file where it can be decompressed in place
+        _cur.lz_start = (inplace + 3) & ~3;
+        _cur.lz_size = usize;
+        _cur.lz = (uint8_t *) malloc(MAX(usize, _cur.lz_start + _cur.size));
+        if(!_cur.lz) {
+            printf("Error allocating %d bytes.\n", usize);
+            req->cb(NULL, 0, 0, 1, req->userdata);
+            // Drain the read already in flight before giving up
+            if(!last) CdReadSync(0, 0);
+            _finish_request();
+            return cdload_busy();
+        }
+    }
+
+    if(_cur.lz) {
+        memcpy(_cur.lz + _cur.lz_start + _cur.offset, chunk, length);
+        if(last) {
+            lz_decompress(_cur.lz, _cur.lz + _cur.lz_start + LZ_HEADER_SIZE,
+                          _cur.lz_size);
+            _deliver_unpacked(req, _cur.lz, _cur.lz_size);
+            _cur.lz = NULL;
+        }
+    } else req->cb(chunk, _cur.offset, length, last, req->userdata);
+    _cur.offset += length;
+
+    if(last) _finish_request();
+    return cdload_busy();
+}
+
+void
+cdload_sync(void (*idle)(void))
+{
+    while(cdload_process()) {
+        if(idle) idle();
+    }
+}
+
+
+/* ============================== */
+/*    STREAMED TEXTURE UPLOADS    */
+/* ============================== */
+
+// Only one request is serviced at a time, so a single state is enough
+static struct {
+    CdLoadTexture *tex;
+    uint32_t row_bytes;
+    uint16_t row;
+    uint16_t carry_len;
+    uint8_t  rejected;   // Did not fit its area, rest of the file is skipped
+    uint32_t carry[512]; // One full VRAM row
+} _tim;
+
+static uint32_t
+_le32(uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (p[3] << 24);
+}
+
+static uint16_t
+_le16(uint8_t *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static void
+_tim_upload_rows(uint8_t *data, uint16_t rows)
+{
+    CdLoadTexture *tex = _tim.tex;
+    RECT r = { tex->prect.x, tex->prect.y + _tim.row, tex->prect.w, rows };
+    LoadImage(&r, (const uint32_t *)data);
+    _upload_started(data);
+    _tim.row += rows;
+}
+
+static void
+_tim_chunk(uint8_t *data, uint32_t offset, uint32_t length,
+           uint8_t last, void *userdata)
+{
+    CdLoadTexture *tex = (CdLoadTexture *)userdata;
+    if(!data) {
+        tex->loaded = 0;
+        return;
+    }
+    // A rejected texture is still read to its end, but never uploaded
+    if((offset > 0) && _tim.rejected) return;
+
+    uint32_t b = 0;
+    if(offset == 0) {
+        // Both TIM headers and the CLUT always fit within the first chunk
+        _tim.tex = tex;
+        _tim.rejected = 0;
+        tex->mode = _le32(&data[4]);
+        b = 8;
+        if(tex->mode & 0x8) {
+            uint32_t len = _le32(&data[b]);
+            tex->crect = (RECT){
+                _le16(&data[b + 4]), _le16(&data[b + 6]),
+                _le16(&data[b + 8]), _le16(&data[b + 10]),
+            };
+            if(tex->area) {
+                tex->crect.x = tex->area->crect.x;
+                tex->crect.y = tex->area->crect.y + tex->clut_row;
+                if(!vram_area_fits(tex->area, NULL, &tex->crect)) {
+                    _tim.rejected = 1;
+                    return;
+                }
+            }
+            LoadImage(&tex->crect, (const uint32_t *)&data[b + 12]);
+            _upload_started(&data[b + 12]);
+            b += len;
+        }
+        tex->prect = (RECT){
+            _le16(&data[b + 4]), _le16(&data[b + 6]),
+            _le16(&data[b + 8]), _le16(&data[b + 10]),
+        };
+        if(tex->area) {
+            tex->prect.x = tex->area->prect.x + tex->ox;
+            tex->prect.y = tex->area->prect.y + tex->oy;
+            if(!vram_area_fits(tex->area, &tex->prect, NULL)) {
+                _tim.rejected = 1;
+                return;
+            }
+        }
+        b += 12;
+        _tim.row_bytes = tex->prect.w << 1;
+        _tim.row = 0;
+        _tim.carry_len = 0;
+    }
+
+    uint8_t *p = data + b;
+    uint32_t n = length - b;
+    uint8_t aligned = (_tim.row_bytes & 3) == 0;
+
+    while((n > 0) && (_tim.row < tex->prect.h)) {
+        if((_tim.carry_len > 0) || !aligned || (n < _tim.row_bytes)) {
+            // Row split across chunks (or unaligned); assemble it aside
+            uint32_t take = _tim.row_bytes - _tim.carry_len;
+            if(take > n) take = n;
+            memcpy((uint8_t *)_tim.carry + _tim.carry_len, p, take);
+            _tim.carry_len += take;
+            p += take;
+            n -= take;
+            if(_tim.carry_len == _tim.row_bytes) {
+                _tim_upload_rows((uint8_t *)_tim.carry, 1);
+                DrawSync(0);
+                _uploads_synced();
+                _tim.carry_len = 0;
+            }
+        } else {
+            uint16_t rows = n / _tim.row_bytes;
+            if(rows > (tex->prect.h - _tim.row))
+                rows = tex->prect.h - _tim.row;
+            _tim_upload_rows(p, rows);
+            p += rows * _tim.row_bytes;
+            n -= rows * _tim.row_bytes;
+        }
+    }
+
+    if(last) {
+        DrawSync(0);
+        _uploads_synced();
+        cache_vram_written(&tex->prect);
+        vram_written(&tex->prect);
+        if(tex->mode & 0x8) {
+            cache_vram_written(&tex->crect);
+            vram_written(&tex->crect);
+        }
+        if(tex->area) tex->area->resident = 1;
+        tex->loaded = 1;
+    }
+}
+
+uint8_t
+cdload_texture(const char *filename, CdLoadTexture *tex)
+{
+    return cdload_texture_at(filename, tex, NULL, 0, 0, 0);
+}
+
+uint8_t
+cdload_texture_at(const char *filename, CdLoadTexture *tex, VramArea *area,
+                  uint16_t ox, uint16_t oy, uint8_t clut_row)
+{
+    tex->loaded = 0;
+    tex->area = area;
+    tex->ox = ox;
+    tex->oy = oy;
+    tex->clut_row = clut_row;
+    return cdload_request(filename, _tim_chunk, tex);
+}
@@ -66,22 +66,11 @@ load_chara(Chara *chara, const char *filename, TIM_IMAGE *tim)
                chara->anims[i].start, chara->anims[i].end);
     }
 
-    /* chara->crectx = tim->crect->x; */
-    /* chara->crecty = tim->crect->y; */
-    /* chara->prectx = tim->prect->x; */
-    /* chara->precty = tim->prect->y; */
-    /* printf("prect: %d %d %d %d, %x\n", */
-    /*        tim->prect->x, tim->prect->y, */
-    /*        tim->prect->w, tim->prect->h, */
-    /*        getTPage(tim->mode & 0x3, 1, tim->prect->x, tim->prect->y)); */
-    /* printf("crect: %d %d %d %d, %x\n", */
-    /*        tim->crect->x, tim->crect->y, */
-    /*        tim->crect->w, tim->crect->h, */
-    /*        getClut(tim->crect->x, tim->crect->y)); */
-    chara->crectx = 0;
-    chara->crecty = 480;
-    chara->prectx = 320;
-    chara->precty = 0; // why not loading correctly???
+    // Sprites were placed on the player's VRAM area when uploaded
+    chara->crectx = tim->crect->x;
+    chara->crecty = tim->crect->y;
+    chara->prectx = tim->prect->x;
+    chara->precty = tim->prect->y;
 
     free(bytes);
 }
@@ -175,7 +164,7 @@ chara_draw_offscreen(Chara *chara, int16_t framenum, int flipx, int otz)
                 // Go to TPAGE right below
                 v0idx -= 28;
                 v0 = v0idx * 9;
-                precty = 256;
+                precty += 256;
             }
 
             int16_t tilex = (col << 3) + frame->x;
@@ -318,7 +307,7 @@ chara_draw_fb(Chara *chara, int16_t framenum,
                 v0idx -= 28;
                 v0 = v0idx * 9;
                 /* otz = SUB_OT_LENGTH - 50; */
-                precty = 256;
+                precty += 256;
             }
 
             //int16_t tilex = (col << 3) + (flipx ? (right << 3) : frame->x) + 5;
@@ -457,7 +446,7 @@ chara_draw_gte(Chara *chara, int16_t framenum,
                 // Go to TPAGE right below
                 v0idx -= 28;
                 v0 = v0idx * 9;
-                precty = 256;
+                precty += 256;
             }
 
             POLY_FT4 *poly = (POLY_FT4 *)get_next_prim();
@@ -24,21 +24,21 @@ _move_point_linecast(uint8_t direction, int32_t vx, int32_t vy,
     //const int32_t step = 1;
     // Move simulated sensor position backwards within range
     switch(direction) {
-    case CDIR_FLOOR: // Directed down
+    case CDIR_FLOOR: // Directed down, step back up
         (*ly) -= step;
         if(*ly < vy) *ly = vy;
         goto adjusty;
-    case CDIR_RWALL: // Directed left
-        (*lx) -= step; // TODO
-        if(*lx > vx) *lx = vx;
+    case CDIR_RWALL: // Directed right, step back left
+        (*lx) -= step;
+        if(*lx < vx) *lx = vx;
         goto adjustx;
-    case CDIR_CEILING: // Directed up
+    case CDIR_CEILING: // Directed up, step back down
         (*ly) += step;
         if(*ly > vy) *ly = vy;
         goto adjusty;
-    case CDIR_LWALL: // Directed right
-        (*lx) += step; // TODO
-        if(*lx < vx) *lx = vx;
+    case CDIR_LWALL: // Directed left, step back right
+        (*lx) += step;
+        if(*lx > vx) *lx = vx;
         goto adjustx;
     }
 
@@ -176,15 +176,23 @@ linecast(int32_t vx, int32_t vy, LinecastDirection direction,
         else if((cy < 0) || (cy >= leveldata->layers[layer].height)) chunk_pos = -1;
         else chunk_pos = (cy * leveldata->layers[layer].width) + cx;
 
-        int16_t chunk = leveldata->layers[layer].tiles[chunk_pos];
-        
-        if(chunk >= 0) {
+        // Nothing to look up outside of the level, or for chunk ids the
+        // mapping does not have. Chunks of streamed levels may also not
+        // be resident
+        Frame128 *frames = NULL;
+        if(chunk_pos >= 0) {
+            int16_t chunk = leveldata->layers[layer].tiles[chunk_pos];
+            if((chunk >= 0) && (chunk < map128->num_tiles))
+                frames = map128->chunks[chunk];
+        }
+
+        if(frames) {
             // Piece coordinates within chunk
             int32_t px = (lx & 0x7f) >> 4;
             int32_t py = (ly & 0x7f) >> 4;
-            uint16_t piece_pos = ((py << 3) + px) + (chunk << 6);
-            uint16_t piece = map128->frames[piece_pos].index;
-            uint8_t piece_props = map128->frames[piece_pos].props;
+            uint16_t piece_pos = (py << 3) + px;
+            uint16_t piece = frames[piece_pos].index;
+            uint8_t piece_props = frames[piece_pos].props;
 
             if((piece > 0) &&
                (piece_props != MAP128_PROP_NONE) &&
@@ -219,6 +227,14 @@ linecast(int32_t vx, int32_t vy, LinecastDirection direction,
     return ev;
 }
 
+uint8_t
+linecast_sweep_magnitude(uint8_t magnitude, int32_t vel)
+{
+    int32_t reach = abs(vel) >> 12;
+    if(reach <= magnitude) return magnitude;
+    return (reach > LINECAST_MAX_SWEEP) ? LINECAST_MAX_SWEEP : reach;
+}
+
 void
 draw_collision_hitbox(int32_t vx, int32_t vy, int32_t w, int32_t h)
 {
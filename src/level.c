@@ -1,11 +1,13 @@
 #include "level.h"
 #include <stdlib.h>
 #include <stdio.h>
-#include <assert.h>
 #include "util.h"
 #include "render.h"
 #include "memalloc.h"
 #include "screen.h"
+#include "vram.h"
+#include "water.h"
+#include "budget.h"
 
 #include "object.h"
 
@@ -15,45 +17,65 @@ extern int debug_mode;
 extern uint8_t level_fade;
 
 
+// Native asset files are read straight into the scene arena and used in
+// place, so their buffers live as long as the level does
+static void *
+_alloc_tiles(uint32_t size)
+{
+    return screen_alloc_tagged(size, ARENA_TAG_TILES);
+}
+
+static void *
+_alloc_collision(uint32_t size)
+{
+    return screen_alloc_tagged(size, ARENA_TAG_COLLISION);
+}
+
+typedef struct {
+    AssetHeader header;
+    uint16_t    num_tiles;
+    uint16_t    _unused;
+    uint32_t    ids_offset;       // uint16_t[num_tiles]
+    uint32_t    collision_offset; // Collision[num_tiles]
+} CollisionFile;
+
+typedef struct {
+    AssetHeader header;
+    uint16_t    tile_width;
+    uint16_t    num_tiles;
+    uint16_t    frame_side;
+    uint16_t    _unused;
+    uint32_t    frames_offset;    // Frame128[num_tiles * frame_side^2]
+} Map128File;
+
+typedef struct {
+    AssetHeader header;
+    uint8_t     num_layers;
+    uint8_t     _unused0;
+    uint16_t    _unused1;
+    // Followed by LevelLayerData[num_layers], where tiles holds an offset
+} LevelFile;
+
 void
 _load_collision(TileMap16 *mapping, const char *filename)
 {
     uint8_t *bytes;
-    uint32_t b, length;
+    uint32_t length;
 
-    bytes = file_read(filename, &length);
+    bytes = file_read_asset(filename, &length, _alloc_collision,
+                            COLLISION_MAGIC, COLLISION_VERSION);
     if(bytes == NULL) {
         printf("Error reading COLLISION file %s from the CD.\n", filename);
         return;
     }
 
-    b = 0;
-
-    uint16_t num_tiles = get_short_be(bytes, &b);
-
-    for(uint16_t i = 0; i < num_tiles; i++) {
-        uint16_t tile_id = get_short_be(bytes, &b);
-        mapping->collision[tile_id] = screen_alloc(sizeof(Collision));
-        Collision *collision = mapping->collision[tile_id];
-
-        collision->floor_angle = (int32_t)get_long_be(bytes, &b);
-        for(int j = 0; j < 8; j++)
-            collision->floor[j] = get_byte(bytes, &b);
-
-        collision->rwall_angle = (int32_t)get_long_be(bytes, &b);
-        for(int j = 0; j < 8; j++)
-            collision->rwall[j] = get_byte(bytes, &b);
+    CollisionFile *file = (CollisionFile *)bytes;
+    uint16_t *ids = (uint16_t *)(bytes + file->ids_offset);
+    Collision *data = (Collision *)(bytes + file->collision_offset);
 
-        collision->ceiling_angle = (int32_t)get_long_be(bytes, &b);
-        for(int j = 0; j < 8; j++)
-            collision->ceiling[j] = get_byte(bytes, &b);
-
-        collision->lwall_angle = (int32_t)get_long_be(bytes, &b);
-        for(int j = 0; j < 8; j++)
-            collision->lwall[j] = get_byte(bytes, &b);
+    for(uint16_t i = 0; i < file->num_tiles; i++) {
+        mapping->collision[ids[i]] = &data[i];
     }
-
-    free(bytes);
 }
 
 void
@@ -65,7 +87,7 @@ load_map16(TileMap16 *mapping, const char *filename, const char *collision_filen
     uint8_t *bytes;
     uint32_t b, length;
 
-    bytes = file_read(filename, &length);
+    bytes = file_read_view(filename, &length);
     if(bytes == NULL) {
         printf("Error reading MAP file %s from the CD.\n", filename);
         return;
@@ -80,12 +102,13 @@ load_map16(TileMap16 *mapping, const char *filename, const char *collision_filen
     uint32_t frames_per_tile = mapping->frame_side * mapping->frame_side;
     uint32_t total_frames = frames_per_tile * mapping->num_tiles;
 
-    mapping->frames = screen_alloc(total_frames * sizeof(uint16_t));
+    mapping->frames = screen_alloc_tagged(
+        total_frames * sizeof(uint16_t), ARENA_TAG_TILES);
     for(uint32_t i = 0; i < total_frames; i++) {
         mapping->frames[i] = get_short_be(bytes, &b);
     }
 
-    free(bytes);
+    file_release(bytes);
 
     if(!collision_filename) {
         mapping->collision = NULL;
@@ -93,7 +116,8 @@ load_map16(TileMap16 *mapping, const char *filename, const char *collision_filen
     }
 
     // Load collision data
-    mapping->collision = screen_alloc((mapping->num_tiles + 1) * sizeof(Collision *));
+    mapping->collision = screen_alloc_tagged(
+        (mapping->num_tiles + 1) * sizeof(Collision *), ARENA_TAG_COLLISION);
     for(uint16_t i = 0; i < mapping->num_tiles; i++) {
         mapping->collision[i] = NULL;
     }
@@ -107,31 +131,27 @@ load_map128(TileMap128 *mapping, const char *filename)
     mapping->num_tiles = 0;
 
     uint8_t *bytes;
-    uint32_t b, length;
+    uint32_t length;
 
-    bytes = file_read(filename, &length);
+    bytes = file_read_asset(filename, &length, _alloc_tiles,
+                            MAP128_MAGIC, MAP128_VERSION);
     if(bytes == NULL) {
         printf("Error reading MAP file %s from the CD.\n", filename);
         return;
     }
 
-    b = 0;
-
-    mapping->tile_width = get_short_be(bytes, &b);
-    mapping->num_tiles  = get_short_be(bytes, &b);
-    mapping->frame_side = get_short_be(bytes, &b);
+    Map128File *file = (Map128File *)bytes;
+    mapping->tile_width = file->tile_width;
+    mapping->num_tiles  = file->num_tiles;
+    mapping->frame_side = file->frame_side;
+    mapping->frames = (Frame128 *)(bytes + file->frames_offset);
 
     uint32_t frames_per_tile = mapping->frame_side * mapping->frame_side;
-    uint32_t total_frames = frames_per_tile * mapping->num_tiles;
-
-    mapping->frames = screen_alloc(total_frames * sizeof(Frame128));
-    for(uint32_t i = 0; i < total_frames; i++) {
-        mapping->frames[i].index = get_short_be(bytes, &b);
-        mapping->frames[i].props = get_byte(bytes, &b);
-        mapping->frames[i]._unused = 0;
+    mapping->chunks = screen_alloc_tagged(
+        mapping->num_tiles * sizeof(Frame128 *), ARENA_TAG_TILES);
+    for(uint16_t i = 0; i < mapping->num_tiles; i++) {
+        mapping->chunks[i] = &mapping->frames[i * frames_per_tile];
     }
-
-    free(bytes);
 }
 
 void
@@ -141,51 +161,47 @@ load_lvl(LevelData *lvl, const char *filename)
     lvl->num_layers = 0;
 
     uint8_t *bytes;
-    uint32_t b, length;
+    uint32_t length;
 
-    bytes = file_read(filename, &length);
+    bytes = file_read_asset(filename, &length, _alloc_tiles,
+                            LEVEL_MAGIC, LEVEL_VERSION);
     if(bytes == NULL) {
         return;
     }
 
-    b = 0;
-
-    lvl->num_layers = get_byte(bytes, &b);
-    lvl->_unused0 = 0; b += 1;
+    LevelFile *file = (LevelFile *)bytes;
+    lvl->num_layers = file->num_layers;
+    lvl->_unused0 = 0;
+    lvl->layers = (LevelLayerData *)(bytes + sizeof(LevelFile));
 
-    uint16_t max_tiles = 0;
-
-    lvl->layers = screen_alloc(lvl->num_layers * sizeof(LevelLayerData));
+    // Layers are used in place; turn their tile offsets into pointers
+    uint32_t max_tiles = 0;
     for(uint8_t n_layer = 0; n_layer < lvl->num_layers; n_layer++) {
         LevelLayerData *layer = &lvl->layers[n_layer];
-        layer->width = get_byte(bytes, &b);
-        layer->height = get_byte(bytes, &b);
-        uint16_t num_tiles = (uint16_t)layer->width * (uint16_t)layer->height;
+        uint32_t num_tiles = (uint32_t)layer->width * (uint32_t)layer->height;
         if(num_tiles > max_tiles) max_tiles = num_tiles;
-        layer->tiles = screen_alloc(num_tiles * sizeof(uint16_t));
-        for(uint16_t i = 0; i < num_tiles; i++) {
-            layer->tiles[i] = get_short_be(bytes, &b);
-        }
+        layer->tiles = (uint16_t *)(bytes + (uintptr_t)layer->tiles);
     }
 
-    free(bytes);
-
-    // These values are static because we're always using the same
-    // coordinates for tpage and clut info. For some reason they're
-    // not loading correctly, but we don't really need them
-    lvl->prectx   = 448;
-    lvl->precty   = 0;
-    lvl->crectx   = 0;
-    lvl->crecty   = 482;
+    // Tiles were placed on their VRAM area before the layout is loaded
+    VramArea *area = vram_get(VRAM_AREA_TILES);
+    if(area) {
+        lvl->prectx = area->prect.x;
+        lvl->precty = area->prect.y;
+        lvl->crectx = area->crect.x;
+        lvl->crecty = area->crect.y;
+    }
     //lvl->clutmode = 0; // NOTE: This was set to tim->mode previously.
     lvl->_unused1 = 0;
 
     // Initialize object state array within level map
     printf("Allocating object array\n");
-    lvl->objects = screen_alloc(max_tiles * sizeof(ChunkObjectData *));
-    for(uint16_t i = 0; i < max_tiles; i++) {
+    lvl->objects = screen_alloc_tagged(
+        max_tiles * sizeof(ChunkObjectData *), ARENA_TAG_OBJECTS);
+    for(uint32_t i = 0; i < max_tiles; i++) {
         lvl->objects[i] = NULL;
     }
+    lvl->num_chunks = max_tiles;
 }
 
 // =====================================
@@ -204,9 +220,15 @@ extern ObjectTable *obj_table_level;
 // around all the time, so we pre-configure 1300 8x8 sprites to be used
 // as level tiles and that's it.
 static uint16_t _numsprites = 0;
+static uint16_t _numdropped = 0; // Tiles past MAX_TILES, not drawn
 static uint8_t  _current_spritebuf = 0;
 static SPRT_8   _sprites[2][MAX_TILES];
 
+// Tile palettes above and below the water surface, and its screen Y
+static uint16_t _clut_dry;
+static uint16_t _clut_wet;
+static int16_t  _water_line = WATER_NO_LINE;
+
 // Macros
 #define TILECLIP(sz) \
     { \
@@ -237,10 +259,16 @@ _render_8(
         u0 = (u0_idx << 3),
         v0 = (v0_idx << 3);
 
-    assert(_numsprites < MAX_TILES);
+    // Tiles past this are not drawn, but they are still reported to the
+    // budget governor so that it drops other detail to make room
+    if(_numsprites >= MAX_TILES) {
+        _numdropped++;
+        return;
+    }
     SPRT_8 *sprt = &_sprites[_current_spritebuf ^ 1][_numsprites++];
     setXY0(sprt, vx, vy);
     setUV0(sprt, u0, v0);
+    sprt->clut = (vy >= _water_line) ? _clut_wet : _clut_dry;
     if(sprt->r0 != level_fade) setRGB0(sprt, level_fade, level_fade, level_fade);
     sort_prim(sprt, otz);
 }
@@ -270,8 +298,50 @@ _render_16(int16_t vx, int16_t vy, int16_t otz,
     }
 }
 
+// Chunks on view or about to scroll into it, resolved once when they first
+// show up: their frames on MAP128 and which of their 16x16 frames are not
+// empty, so that drawing them does not walk over empty space. Slots are
+// picked by chunk coordinates, and there are enough of them for the view
+// plus one chunk of camera lookahead on each axis
+#define CHUNK_CACHE_W 8
+#define CHUNK_CACHE_H 4
+
+typedef struct {
+    int32_t  chunk_pos;  // -1 if empty
+    uint16_t chunk;
+    uint8_t  num_frames;
+    Frame128 *frames;
+    uint8_t  frame_idx[64];
+} ChunkSlot;
+
+static ChunkSlot _chunk_cache[CHUNK_CACHE_H][CHUNK_CACHE_W];
+
+static ChunkSlot *
+_resolve_chunk(LevelLayerData *l, int32_t ix, int32_t iy)
+{
+    ChunkSlot *slot = &_chunk_cache[iy & (CHUNK_CACHE_H - 1)]
+                                   [ix & (CHUNK_CACHE_W - 1)];
+    int32_t chunk_pos = (iy * l->width) + ix;
+
+    // Streamed regions may have come or gone since the slot was filled
+    if((slot->chunk_pos == chunk_pos)
+       && ((slot->chunk == 0) || (slot->frames == map128->chunks[slot->chunk])))
+        return slot;
+
+    slot->chunk_pos = chunk_pos;
+    slot->chunk = l->tiles[chunk_pos];
+    slot->frames = (slot->chunk != 0) ? map128->chunks[slot->chunk] : NULL;
+    slot->num_frames = 0;
+    if(slot->frames) {
+        for(uint8_t idx = 0; idx < 64; idx++)
+            if(slot->frames[idx].index != 0)
+                slot->frame_idx[slot->num_frames++] = idx;
+    }
+    return slot;
+}
+
 void
-_render_128(int16_t vx, int16_t vy, uint16_t frame,
+_render_128(int16_t vx, int16_t vy, ChunkSlot *slot,
             uint32_t otz)
 {
     // Clipping
@@ -280,11 +350,10 @@ _render_128(int16_t vx, int16_t vy, uint16_t frame,
     // 128x128 has 8x8 tiles of 16x16.
     // Since this is a constant, we will then write the optimized code
     // just like _render_16.
-    // Frames per tile: 8 * 8 = 64 => rshift << 6
-    Frame128 *tileframes = &map128->frames[frame << 6];
-    for(int16_t idx = 0; idx < 64; idx++) {
-        if(tileframes[idx].index == 0) continue;
-
+    // Only the frames which are not empty were kept on the slot
+    Frame128 *tileframes = slot->frames;
+    for(uint8_t i = 0; i < slot->num_frames; i++) {
+        uint8_t idx = slot->frame_idx[i];
         int16_t
             //deltax = (idx % 8),
             deltax = (idx & 0x07),
@@ -301,8 +370,31 @@ _render_128(int16_t vx, int16_t vy, uint16_t frame,
 
 #define CLAMP_SUM(X, N, MAX) ((X + N) > MAX ? MAX : (X + N))
 
+// Range of chunks seen from a camera centered on vx, vy (in pixels)
+static void
+_view_chunks(LevelLayerData *l, int32_t vx, int32_t vy,
+             int32_t *tilex, int32_t *tiley,
+             int32_t *max_tile_x, int32_t *max_tile_y)
+{
+    // Find tile X and Y indices of the top left corner. Integer division
+    // by 128. Past the 255th chunk these no longer fit 16 bits
+    *tilex = (vx - CENTERX) >> 7;
+    *tiley = (vy - CENTERY) >> 7;
+
+    // We need to figure out the number of tiles we need to draw on X
+    // and Y coordinates. This is because we may well be extrapolating
+    // those tiles!
+    int16_t num_tiles_x, num_tiles_y;
+    num_tiles_x = (SCREEN_XRES >> 7) + 1;
+    num_tiles_y = (SCREEN_YRES >> 7) + 1;
+
+    // Clamp number of tiles
+    *max_tile_x = CLAMP_SUM(*tilex, num_tiles_x, (int32_t)l->width);
+    *max_tile_y = CLAMP_SUM(*tiley, num_tiles_y, (int32_t)l->height);
+}
+
 void
-_render_layer(int16_t vx, int16_t vy, uint8_t layer, uint32_t otz)
+_render_layer(int32_t vx, int32_t vy, uint8_t layer, uint32_t otz)
 {
     LevelLayerData *l = &leveldata->layers[layer];
     // vx and vy are the camera center.
@@ -311,46 +403,45 @@ _render_layer(int16_t vx, int16_t vy, uint8_t layer, uint32_t otz)
     // - what is the tile (x, y) containing this top-left corner point;
     // - the deltas that we should apply relative to the own tile's top-left
     //   corner.
-
-    // Correct vx / vy to the top left corner
-    vx -= CENTERX; vy -= CENTERY;
-
-    // Find tile X and Y indices. Integer division by 128
-    int16_t tilex, tiley;
-    tilex = vx >> 7; tiley = vy >> 7;
+    int32_t tilex, tiley, max_tile_x, max_tile_y;
+    _view_chunks(l, vx, vy, &tilex, &tiley, &max_tile_x, &max_tile_y);
 
     // Find pixel deltas for X and Y coordinates that are figuratively
     // subtracted from each tile's top left corner
     int16_t deltax, deltay;
-    deltax = vx - (tilex << 7);
-    deltay = vy - (tiley << 7);
-
-    // We need to figure out the number of tiles we need to draw on X
-    // and Y coordinates. This is because we may well be extrapolating
-    // those tiles!
-    int16_t num_tiles_x, num_tiles_y;
-    num_tiles_x = (SCREEN_XRES >> 7) + 1;
-    num_tiles_y = (SCREEN_YRES >> 7) + 1;
-
-    // Clamp number of tiles
-    int16_t max_tile_x, max_tile_y;
-    max_tile_x = CLAMP_SUM(tilex, num_tiles_x, (int16_t)l->width);
-    max_tile_y = CLAMP_SUM(tiley, num_tiles_y, (int16_t)l->height);
+    deltax = (vx - CENTERX) - (tilex << 7);
+    deltay = (vy - CENTERY) - (tiley << 7);
 
     // Now iterate over tiles and render them.
-    for(int16_t iy = tiley; iy <= max_tile_y; iy++) {
-        for(int16_t ix = tilex; ix <= max_tile_x; ix++) {
-            int16_t frame_idx = (iy * l->width) + ix;
-            if(l->tiles[frame_idx] == 0) continue;
+    for(int32_t iy = tiley; iy <= max_tile_y; iy++) {
+        for(int32_t ix = tilex; ix <= max_tile_x; ix++) {
+            ChunkSlot *slot = _resolve_chunk(l, ix, iy);
+            if(slot->num_frames == 0) continue;
 
             _render_128(((ix - tilex) << 7) - deltax,
                         ((iy - tiley) << 7) - deltay,
-                        l->tiles[frame_idx],
+                        slot,
                         otz);
         }
     }
 }
 
+void
+level_prefetch(int32_t ahead_x, int32_t ahead_y)
+{
+    if(leveldata->num_layers < 1) return;
+
+    // Resolve chunks where the view is headed to, a frame before they are
+    // drawn. Those already on view are found on the cache right away
+    LevelLayerData *l = &leveldata->layers[0];
+    int32_t tilex, tiley, max_tile_x, max_tile_y;
+    _view_chunks(l, ahead_x >> 12, ahead_y >> 12,
+                 &tilex, &tiley, &max_tile_x, &max_tile_y);
+    for(int32_t iy = tiley; iy <= max_tile_y; iy++)
+        for(int32_t ix = tilex; ix <= max_tile_x; ix++)
+            _resolve_chunk(l, ix, iy);
+}
+
 void
 prepare_renderer()
 {
@@ -366,6 +457,10 @@ prepare_renderer()
         setClut(sprt, leveldata->crectx, leveldata->crecty);
     }
     _current_spritebuf = 0;
+
+    for(uint8_t y = 0; y < CHUNK_CACHE_H; y++)
+        for(uint8_t x = 0; x < CHUNK_CACHE_W; x++)
+            _chunk_cache[y][x].chunk_pos = -1;
 }
 
 inline int32_t
@@ -394,8 +489,8 @@ _render_obj(ObjectState *obj, ObjectTableEntry *typedata,
     // ty = chunk y index on map
 
     // Calculate object center/bottom
-    int16_t vx = (int16_t)(tx << 7) + obj->rx;
-    int16_t vy = (int16_t)(ty << 7) + obj->ry;
+    int32_t vx = (tx << 7) + obj->rx;
+    int32_t vy = (ty << 7) + obj->ry;
 
     // Now that vx and vy are the world's absolute world positions,
     // all we need to do is subtrack the camera position from it
@@ -421,6 +516,66 @@ _render_obj(ObjectState *obj, ObjectTableEntry *typedata,
 
 extern int player_hitbox_shown;
 
+// Chunks surrounding the camera which may hold objects. Gathered once per
+// frame on the scratchpad and shared by object update and render.
+#define OBJ_WINDOW_SIDE 5
+
+typedef struct {
+    int32_t chunk_pos;
+    int16_t tx, ty;
+} ObjWindowCell;
+
+typedef struct {
+    uint32_t      frame;
+    int32_t       bx, by;
+    uint8_t       num_cells;
+    ObjWindowCell cells[OBJ_WINDOW_SIDE * OBJ_WINDOW_SIDE];
+} ObjWindow;
+
+static ObjWindow *_obj_window = NULL;
+
+static ObjWindow *
+_get_obj_window(int32_t cx, int32_t cy)
+{
+    // Top left chunk of the window
+    int32_t bx = (cx - 256) >> 7;
+    int32_t by = (cy - 256) >> 7;
+
+    if(_obj_window
+       && (_obj_window->frame == fastalloc_get_frame())
+       && (_obj_window->bx == bx)
+       && (_obj_window->by == by))
+        return _obj_window;
+
+    int32_t w = leveldata->layers[0].width;
+    int32_t h = leveldata->layers[0].height;
+
+    ObjWindow *window = fastalloc_malloc(sizeof(ObjWindow));
+    window->frame = fastalloc_get_frame();
+    window->bx = bx;
+    window->by = by;
+    window->num_cells = 0;
+
+    for(int32_t i = 0; i < OBJ_WINDOW_SIDE; i++) {
+        int32_t tx = bx + i;
+        if((tx < 0) || (tx >= w)) continue;
+        for(int32_t j = 0; j < OBJ_WINDOW_SIDE; j++) {
+            int32_t ty = by + j;
+            if((ty < 0) || (ty >= h)) continue;
+            int32_t chunk_pos = (ty * w) + tx;
+            if(chunk_pos > 0) {
+                ObjWindowCell *cell = &window->cells[window->num_cells++];
+                cell->chunk_pos = chunk_pos;
+                cell->tx = tx;
+                cell->ty = ty;
+            }
+        }
+    }
+
+    _obj_window = window;
+    return window;
+}
+
 void
 update_obj_window(int32_t cam_x, int32_t cam_y, uint8_t round)
 {
@@ -430,38 +585,24 @@ update_obj_window(int32_t cam_x, int32_t cam_y, uint8_t round)
     cam_x = cam_x >> 12;
     cam_y = cam_y >> 12;
     player_hitbox_shown = 0;
-    
-    for(int32_t i = 0; i < 5; i++) {
-        int32_t new_cam_x = cam_x - 256 + (i * 128);
-
-        for(int32_t j = 0; j < 5; j++) {
-            int32_t new_cam_y = cam_y - 256 + (j * 128);
 
-            int32_t cx = new_cam_x >> 7;
-            int32_t cy = new_cam_y >> 7;
-            int32_t chunk_pos;
-            if((cx < 0) || (cx >= leveldata->layers[0].width)) chunk_pos = -1;
-            else if((cy < 0) || (cy >= leveldata->layers[0].height)) chunk_pos = -1;
-            else chunk_pos = (cy * leveldata->layers[0].width) + cx;
-
-            if(chunk_pos > 0) {
-                ChunkObjectData *objdata = leveldata->objects[chunk_pos];
-                if(objdata) {
-                    for(uint8_t k = 0; k < objdata->num_objects; k++) {
-                        ObjectState *obj = &objdata->objects[k];
-                        ObjectTableEntry *typedata =
-                            (obj->id >= MIN_LEVEL_OBJ_GID)
-                            ? &obj_table_level->entries[obj->id - MIN_LEVEL_OBJ_GID]
-                            : &obj_table_common->entries[obj->id];
-                        VECTOR pos = {
-                            .vx = (int32_t)(cx << 7) + (int32_t)obj->rx,
-                            .vy = (int32_t)(cy << 7) + (int32_t)obj->ry,
-                            .vz = 0
-                        };
-                        object_update(obj, typedata, &pos, round);
-                    }
-                }
-            }
+    ObjWindow *window = _get_obj_window(cam_x, cam_y);
+    for(uint8_t c = 0; c < window->num_cells; c++) {
+        ObjWindowCell *cell = &window->cells[c];
+        ChunkObjectData *objdata = leveldata->objects[cell->chunk_pos];
+        if(!objdata) continue;
+        for(uint8_t k = 0; k < objdata->num_objects; k++) {
+            ObjectState *obj = &objdata->objects[k];
+            ObjectTableEntry *typedata =
+                (obj->id >= MIN_LEVEL_OBJ_GID)
+                ? &obj_table_level->entries[obj->id - MIN_LEVEL_OBJ_GID]
+                : &obj_table_common->entries[obj->id];
+            VECTOR pos = {
+                .vx = (int32_t)(cell->tx << 7) + (int32_t)obj->rx,
+                .vy = (int32_t)(cell->ty << 7) + (int32_t)obj->ry,
+                .vz = 0
+            };
+            object_update(obj, typedata, &pos, round);
         }
     }
 }
@@ -471,31 +612,18 @@ _render_obj_window(int32_t cx, int32_t cy)
 {
     if(leveldata->num_layers < 1) return;
 
-    int32_t chunk;
-    int32_t w = leveldata->layers[0].width;
-    int32_t h = leveldata->layers[0].height;
-
-#define _DO_RENDER(x, y)                                                 \
-    chunk = get_chunk_pos(x, y, w, h);                                   \
-    if(chunk > 0) {                                                      \
-        ChunkObjectData *objdata = leveldata->objects[chunk];            \
-        if(objdata) {                                                    \
-            for(uint8_t i = 0; i < objdata->num_objects; i++) {         \
-                ObjectState *obj = &objdata->objects[i];                \
-                ObjectTableEntry *typedata = (obj->id >= MIN_LEVEL_OBJ_GID) \
-                    ? &obj_table_level->entries[obj->id - MIN_LEVEL_OBJ_GID] \
-                    : &obj_table_common->entries[obj->id];               \
-                _render_obj(obj, typedata, cx, cy, (x) >> 7, (y) >> 7); \
-            }                                                           \
-        }                                                               \
-    }
-
     // Render a 5x5 grid of objects.
-    for(int32_t i = 0; i < 5; i++) {
-        int32_t new_cx = cx - 256 + (i * 128);
-        for(int32_t j = 0; j < 5; j++) {
-            int32_t new_cy = cy - 256 + (j * 128);
-            _DO_RENDER(new_cx, new_cy);
+    ObjWindow *window = _get_obj_window(cx, cy);
+    for(uint8_t c = 0; c < window->num_cells; c++) {
+        ObjWindowCell *cell = &window->cells[c];
+        ChunkObjectData *objdata = leveldata->objects[cell->chunk_pos];
+        if(!objdata) continue;
+        for(uint8_t i = 0; i < objdata->num_objects; i++) {
+            ObjectState *obj = &objdata->objects[i];
+            ObjectTableEntry *typedata = (obj->id >= MIN_LEVEL_OBJ_GID)
+                ? &obj_table_level->entries[obj->id - MIN_LEVEL_OBJ_GID]
+                : &obj_table_common->entries[obj->id];
+            _render_obj(obj, typedata, cx, cy, cell->tx, cell->ty);
         }
     }
 }
@@ -506,16 +634,23 @@ render_lvl(
     uint8_t front)
 {
     _numsprites = 0;
+    _numdropped = 0;
     _current_spritebuf = !_current_spritebuf;
     uint32_t layer =
         front ? OTZ_LAYER_LEVEL_FG_BACK_M1 : OTZ_LAYER_LEVEL_FG_BACK;
 
-    int16_t
+    int32_t
         cx = (cam_x >> 12),
         cy = (cam_y >> 12);
 
+    // Tiles are split between palettes at the water surface
+    _clut_dry = getClut(leveldata->crectx, leveldata->crecty);
+    _clut_wet = getClut(leveldata->crectx, water_clut_row(leveldata->crecty));
+    _water_line = water_line();
+
     if(leveldata->num_layers > 0)
         _render_layer(cx, cy, 0, layer);
+    budget_count(BUDGET_TILES, _numsprites + _numdropped);
 
 
     // Texture TPAGE info for level foreground (back tiles)
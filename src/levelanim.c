@@ -0,0 +1,224 @@
+#include "levelanim.h"
+#include <stdio.h>
+#include <strings.h>
+#include <psxgpu.h>
+#include "vram.h"
+#include "cache.h"
+#include "screen.h"
+#include "water.h"
+
+// Runtime state of a palette animation. Colors are rotated from a copy
+// of the original range, read back from VRAM once the level is uploaded
+typedef struct {
+    uint8_t  counter;
+    uint8_t  shift;
+    uint8_t  dirty;
+    uint16_t *base;
+    uint16_t *colors;
+    uint16_t *wet;
+} PaletteState;
+
+typedef struct {
+    uint8_t counter;
+    uint8_t frame;
+    uint8_t dirty;
+} TileState;
+
+static struct {
+    uint8_t       active;
+    uint8_t       *bytes;
+    LevelAnimFile *file;
+    PaletteAnim   *palettes;
+    TileAnim      *tiles;
+    PaletteState  *palette_state;
+    TileState     *tile_state;
+} _anim = { 0 };
+
+static const VramAreaId _areas[] = {
+    VRAM_AREA_TILES,
+    VRAM_AREA_BG,
+    VRAM_AREA_OBJ_LEVEL,
+};
+
+static void *
+_alloc_anim(uint32_t size)
+{
+    return screen_alloc_tagged(size, ARENA_TAG_TILES);
+}
+
+void
+levelanim_load(const char *filename)
+{
+    uint32_t length;
+
+    levelanim_unload();
+    _anim.bytes = file_read_asset(filename, &length, _alloc_anim,
+                                  LEVELANIM_MAGIC, LEVELANIM_VERSION);
+    if(!_anim.bytes) return;
+
+    _anim.file = (LevelAnimFile *)_anim.bytes;
+    _anim.palettes = (PaletteAnim *)(_anim.bytes + _anim.file->palettes_offset);
+    _anim.tiles = (TileAnim *)(_anim.bytes + _anim.file->tiles_offset);
+
+    _anim.palette_state = _alloc_anim(
+        sizeof(PaletteState) * _anim.file->num_palettes);
+    _anim.tile_state = _alloc_anim(
+        sizeof(TileState) * _anim.file->num_tiles);
+    bzero(_anim.palette_state, sizeof(PaletteState) * _anim.file->num_palettes);
+    bzero(_anim.tile_state, sizeof(TileState) * _anim.file->num_tiles);
+
+    for(uint16_t i = 0; i < _anim.file->num_palettes; i++) {
+        PaletteState *state = &_anim.palette_state[i];
+        // VRAM transfers are made of whole words
+        uint16_t count = (_anim.palettes[i].count + 1) & ~1;
+        state->base = _alloc_anim(sizeof(uint16_t) * count);
+        state->colors = _alloc_anim(sizeof(uint16_t) * count);
+        state->wet = _alloc_anim(sizeof(uint16_t) * count);
+    }
+
+    printf("Level animations: %d palettes, %d tiles\n",
+           _anim.file->num_palettes, _anim.file->num_tiles);
+}
+
+static uint8_t
+_palette_rect(PaletteAnim *anim, RECT *rect)
+{
+    VramArea *area = vram_get(_areas[anim->area]);
+    if(!area || (anim->row >= area->crect.h)) return 0;
+    setRECT(rect, area->crect.x + anim->first, area->crect.y + anim->row,
+            anim->count, 1);
+    return 1;
+}
+
+static uint8_t
+_tile_rect(TileAnim *anim, RECT *rect)
+{
+    VramArea *area = vram_get(_areas[anim->area]);
+    if(!area) return 0;
+    setRECT(rect, area->prect.x + anim->x, area->prect.y + anim->y,
+            anim->w, anim->h);
+    return 1;
+}
+
+static void
+_written(RECT *rect)
+{
+    cache_vram_written(rect);
+    vram_written(rect);
+}
+
+void
+levelanim_start()
+{
+    if(!_anim.bytes) return;
+
+    // Palettes are read back from VRAM, so everything must be uploaded
+    DrawSync(0);
+    for(uint16_t i = 0; i < _anim.file->num_palettes; i++) {
+        RECT rect;
+        PaletteState *state = &_anim.palette_state[i];
+        if(!_palette_rect(&_anim.palettes[i], &rect)) {
+            printf("Warning: Palette animation %d has no CLUT\n", i);
+            state->base = NULL;
+            continue;
+        }
+        StoreImage(&rect, (uint32_t *)state->base);
+        DrawSync(0);
+
+        // What is on VRAM will no longer match what was loaded there
+        _written(&rect);
+        uint16_t wet_row = water_clut_row(rect.y);
+        if(wet_row != rect.y) {
+            rect.y = wet_row;
+            _written(&rect);
+        }
+    }
+
+    for(uint16_t i = 0; i < _anim.file->num_tiles; i++) {
+        RECT rect;
+        if(_tile_rect(&_anim.tiles[i], &rect)) _written(&rect);
+    }
+    _anim.active = 1;
+}
+
+void
+levelanim_update()
+{
+    if(!_anim.active) return;
+
+    for(uint16_t i = 0; i < _anim.file->num_palettes; i++) {
+        PaletteAnim *anim = &_anim.palettes[i];
+        PaletteState *state = &_anim.palette_state[i];
+        if(!state->base || (++state->counter < anim->period)) continue;
+        state->counter = 0;
+        state->shift = (anim->direction > 0)
+            ? ((state->shift + 1 == anim->count) ? 0 : state->shift + 1)
+            : ((state->shift == 0) ? anim->count - 1 : state->shift - 1);
+        state->dirty = 1;
+    }
+
+    for(uint16_t i = 0; i < _anim.file->num_tiles; i++) {
+        TileAnim *anim = &_anim.tiles[i];
+        TileState *state = &_anim.tile_state[i];
+        if(++state->counter < anim->period) continue;
+        state->counter = 0;
+        state->frame = (state->frame + 1 == anim->num_frames)
+            ? 0
+            : state->frame + 1;
+        state->dirty = 1;
+    }
+}
+
+void
+levelanim_flush()
+{
+    if(!_anim.active) return;
+
+    // Uploads are queued behind the frame the GPU is drawing, so they only
+    // take effect between frames. Their sources stay untouched until the
+    // next flush, by which time the GPU is done with them
+    for(uint16_t i = 0; i < _anim.file->num_palettes; i++) {
+        PaletteAnim *anim = &_anim.palettes[i];
+        PaletteState *state = &_anim.palette_state[i];
+        if(!state->dirty) continue;
+        state->dirty = 0;
+
+        for(uint8_t c = 0, src = anim->count - state->shift; c < anim->count; c++) {
+            if(src == anim->count) src = 0;
+            state->colors[c] = state->base[src++];
+        }
+
+        RECT rect;
+        _palette_rect(anim, &rect);
+        LoadImage(&rect, (uint32_t *)state->colors);
+
+        // Keep the underwater copy of this palette in step
+        uint16_t wet_row = water_clut_row(rect.y);
+        if(wet_row != rect.y) {
+            water_tint(state->wet, state->colors, anim->count);
+            rect.y = wet_row;
+            LoadImage(&rect, (uint32_t *)state->wet);
+        }
+    }
+
+    for(uint16_t i = 0; i < _anim.file->num_tiles; i++) {
+        TileAnim *anim = &_anim.tiles[i];
+        TileState *state = &_anim.tile_state[i];
+        if(!state->dirty) continue;
+        state->dirty = 0;
+
+        RECT rect;
+        if(!_tile_rect(anim, &rect)) continue;
+        // Frames are padded to whole words
+        uint16_t *frames = (uint16_t *)(_anim.bytes + anim->frames_offset);
+        uint32_t stride = (anim->w * anim->h + 1) & ~1;
+        LoadImage(&rect, (uint32_t *)&frames[state->frame * stride]);
+    }
+}
+
+void
+levelanim_unload()
+{
+    _anim.active = 0;
+    _anim.bytes = NULL;
+}
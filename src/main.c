@@ -19,38 +19,51 @@
 #include "timer.h"
 #include "camera.h"
 #include "memalloc.h"
+#include "cache.h"
+#include "vram.h"
 #include "screen.h"
 #include "basic_font.h"
 
 /*
-  Locations of common textures on frame buffer:
+  Locations of textures on frame buffer:
   ================================================
-  Title screen:   320x0      No CLUT
-  Player 1:       320x0;     CLUT: 0x480
-  Common objects: 576x0;     CLUT: 0x481 (8-bit only)
-  Level tiles:    448x0;     CLUT: 0x482 (4 or 8-bit CLUT)
-  Level BG0:      448x256;   CLUT: 0x483 (4-bit only)
-  Level BG1:      512x256;   CLUT: 0x484 (4-bit only)
-  Level objects:  704x0;     CLUT: 0x485 (8-bit only)
-  Level boss:     704x256;   CLUT: 0x486 (8-bit only, loaded over level objects)
+  Framebuffers:   0x0 to 319x511 (reserved)
+  Character offscreen renderer: 960x0, 16-bit (reserved)
+  Basic fonts:    960x256;   CLUT: 0x490 (4-bit always, reserved)
+
+  Level textures are placed by the VRAM allocator (see vram.h), in
+  cells of 64x256 and CLUT rows from 0x480 on. Areas are allocated on
+  first-fit order as the level loads (rows of cells are filled top to
+  bottom, so 128x512 areas go past every 128x256 one), which ends up as:
+  Player 1:       320x0;     CLUT: 0x480 (persistent, 128x512)
+  Level tiles:    448x0;     CLUT: 0x481 (4 or 8-bit CLUT)
+  Level BG0/BG1:  576x0;     CLUT: 0x482/0x483 (4-bit only, 64 apart)
+  Common objects: 704x0;     CLUT: 0x484 (8-bit only, persistent, 128x512)
+  Level objects:  832x0;     CLUT: 0x485 (8-bit only, 128x512)
+  Level boss:     832x256;   CLUT: 0x486 (8-bit only, within level objects)
                              CLUT: 0x487 (8-bit only, alt palette when hit)
+  Water palettes take the CLUT rows right after these. 448x256 and
+  576x256 are left free.
 
-  Character offscreen renderer: 960x0, 16-bit (do not upload textures here)
-  Basic fonts:    960x256;   CLUT: 0x490 (4-bit always)
+  Other screens (title, menus, slides) upload TIMs at their own embedded
+  coordinates, typically 320x0 and onwards. These still invalidate
+  whatever allocated areas they overwrite.
  */
 
 /*
   General depth for elements in ordering table
-  (Ordering table depths act like sprite planes)
+  (Ordering table depths act like sprite planes, see OTZ_LAYER_* on render.h)
+  2D scenes use an OT of OT_LENGTH_2D; 3D scenes request OT_LENGTH on load
   ================================================
         0       | Highest plane (debug information, etc)
         1       | Heads-up display and text layer
-        2       | Level tile (SPRT_8 + DR_TPAGE) layer (front) -- UNUSED
-        3       | Object sprite layer (upper objects such as rings, and hitboxes)
-        4       | Player sprite layer (most objects, player is atop)
-       ...      | ...
-  OT_LENGTH - 3 | Level tile (SPRT_8 + DR_TPAGE) layer (back)
-  OT_LENGTH - 2 | Level background (parallax)
+        2       | Level tile (SPRT_8 + DR_TPAGE) layer (front)
+        3       | Level tile layer (front, behind the above)
+        4       | Object sprite layer (upper objects such as rings, and hitboxes)
+        5       | Player sprite layer (most objects, player is atop)
+        6       | Objects under the player
+        7       | Level tile (SPRT_8 + DR_TPAGE) layer (back)
+        8       | Level background (parallax)
  */
 
 int debug_mode = 0;
@@ -64,10 +77,13 @@ main(void)
     // Engine initialization
     setup_context();
     CdInit();
+    file_index_init();
     sound_init();
     pad_init();
     timer_init();
     fastalloc_init();
+    cache_init();
+    vram_init();
     font_init();
     scene_init();
 
@@ -82,11 +98,16 @@ main(void)
     /* screen_level_setlevel(5); */
     /* scene_change(SCREEN_LEVEL); */
 
+    timer_reset_steps();
     while(1) {
-        // Update systems
-        pad_update();
-        scene_update();
-        timer_update();
+        // Update systems at a fixed rate, once per 60Hz step due
+        uint8_t steps = timer_steps();
+        for(uint8_t i = 0; i < steps; i++) {
+            pad_update();
+            scene_update();
+            timer_update();
+            if(scene_was_changed()) break;
+        }
 
         // Draw scene
         scene_draw();
@@ -1,44 +1,127 @@
 #include "memalloc.h"
 #include <assert.h>
+#include <string.h>
 
 ArenaAllocator scratchpad_arena;
+ArenaAllocator frame_arena;
 
 #define SCRATCHPAD_START 0x1f800000
 #define SCRATCHPAD_SIZE  1024
+#define FRAME_SPILL_SIZE 8192
+
+// Main RAM area used by per-frame allocations when the scratchpad is full
+static uint8_t        frame_spill[FRAME_SPILL_SIZE];
+static FastAllocStats fastalloc_stats;
+static FastAllocStats fastalloc_last_stats;
+static uint32_t       fastalloc_frame = 0;
+
+#define ALIGN_UP(x) (((x) + (ARENA_ALIGNMENT - 1)) & ~(ARENA_ALIGNMENT - 1))
+
+static const char *arena_tag_names[ARENA_TAG_MAX] = {
+    "MISC",
+    "TILES",
+    "COLLISION",
+    "OBJECTS",
+    "PARALLAX",
+    "MODELS",
+};
+
+static const char *arena_scope_names[ARENA_SCOPE_MAX] = {
+    "PERSISTENT",
+    "SCENE",
+    "LEVEL",
+    "ACT",
+};
 
 void
 alloc_arena_init(ArenaAllocator *arena, void *start, size_t size)
 {
-    uintptr_t st = (uintptr_t)start;
+    // Make sure the first allocation is already aligned. Whatever
+    // is lost from the beginning of the buffer is lost for good
+    uintptr_t st = ALIGN_UP((uintptr_t)start);
     arena->start = st;
-    arena->ptr   = arena->start;
-    arena->size  = size;
+    arena->size  = size - (st - (uintptr_t)start);
+    alloc_arena_free(arena);
 }
 
 void
 alloc_arena_free(ArenaAllocator *arena)
 {
-    arena->ptr = arena->start;
+    arena->ptr   = arena->start;
+    arena->scope = ARENA_SCOPE_PERSISTENT;
+    memset(arena->tag_bytes, 0, sizeof(arena->tag_bytes));
+    for(int i = 0; i < ARENA_SCOPE_MAX; i++) {
+        arena->markers[i] = (ArenaMarker){ 0 };
+        arena->markers[i].ptr = arena->start;
+    }
 }
 
 void *
-alloc_arena_malloc(ArenaAllocator *arena, size_t size)
+alloc_arena_malloc_tagged(ArenaAllocator *arena, size_t size, ArenaTag tag)
 {
     if(size == 0) return NULL;
 
-    // ALIGN SIZE so we don't get unaligned memory access
-    size += 8 - (size % 8);
+    // ALIGN SIZE so we don't get unaligned memory access.
+    // The pointer itself is always kept aligned, so we only need to pad
+    // sizes that are not a multiple of the alignment
+    size = ALIGN_UP(size);
 
-    uintptr_t p = (uintptr_t)arena->ptr;
-    uintptr_t align_diff = p % 8;
+    uintptr_t p = arena->ptr;
     /* printf("Alotted size so far: %d / %d, requested: %lu\n", */
     /*        alloc_arena_bytes_used(arena), alloc_arena_bytes_free(arena), */
     /*        size); */
-    assert((arena->ptr + size) < (arena->start + arena->size));
-    arena->ptr += size + align_diff;
+    assert((p + size) <= (arena->start + arena->size));
+    arena->ptr = p + size;
+    arena->tag_bytes[tag] += size;
     return (void *)p;
 }
 
+void *
+alloc_arena_malloc(ArenaAllocator *arena, size_t size)
+{
+    return alloc_arena_malloc_tagged(arena, size, ARENA_TAG_MISC);
+}
+
+void
+alloc_arena_push(ArenaAllocator *arena, ArenaScope scope)
+{
+    // Scopes can only be nested inwards
+    assert(scope > arena->scope);
+    ArenaMarker *marker = &arena->markers[scope];
+    marker->ptr = arena->ptr;
+    marker->parent = arena->scope;
+    memcpy(marker->tag_bytes, arena->tag_bytes, sizeof(arena->tag_bytes));
+    arena->scope = scope;
+}
+
+void
+alloc_arena_pop(ArenaAllocator *arena, ArenaScope scope)
+{
+    // Popping a scope that is not active is a no-op, so that callers
+    // can always pop their scope on unload regardless of load order
+    if(scope == ARENA_SCOPE_PERSISTENT) {
+        alloc_arena_free(arena);
+        return;
+    }
+    if(scope > arena->scope) return;
+
+    // Walk up the scope chain so we know the scope was really pushed
+    uint8_t s = arena->scope;
+    while(s > scope) s = arena->markers[s].parent;
+    if(s != scope) return;
+
+    ArenaMarker *marker = &arena->markers[scope];
+    arena->ptr = marker->ptr;
+    arena->scope = marker->parent;
+    memcpy(arena->tag_bytes, marker->tag_bytes, sizeof(arena->tag_bytes));
+}
+
+void *
+alloc_arena_scope_start(ArenaAllocator *arena, ArenaScope scope)
+{
+    return (void *)arena->markers[scope].ptr;
+}
+
 uint32_t
 alloc_arena_bytes_used(ArenaAllocator *arena)
 {
@@ -51,20 +134,103 @@ alloc_arena_bytes_free(ArenaAllocator *arena)
     return arena->size - alloc_arena_bytes_used(arena);
 }
 
+uint32_t
+alloc_arena_bytes_tagged(ArenaAllocator *arena, ArenaTag tag)
+{
+    return arena->tag_bytes[tag];
+}
+
+uint32_t
+alloc_arena_bytes_scope(ArenaAllocator *arena, ArenaScope scope)
+{
+    // Bytes owned by a scope are everything between its marker and the
+    // next inner active scope (or the allocation pointer)
+    if(scope > arena->scope) return 0;
+    uintptr_t end = arena->ptr;
+    uint8_t s = arena->scope;
+    while(s > scope) {
+        end = arena->markers[s].ptr;
+        s = arena->markers[s].parent;
+    }
+    if(s != scope) return 0;
+    return end - arena->markers[scope].ptr;
+}
+
+const char *
+alloc_arena_tag_name(ArenaTag tag)
+{
+    return (tag < ARENA_TAG_MAX) ? arena_tag_names[tag] : "?";
+}
+
+const char *
+alloc_arena_scope_name(ArenaScope scope)
+{
+    return (scope < ARENA_SCOPE_MAX) ? arena_scope_names[scope] : "?";
+}
+
 void
 fastalloc_init()
 {
     alloc_arena_init(&scratchpad_arena, (void*)SCRATCHPAD_START, SCRATCHPAD_SIZE);
+    alloc_arena_init(&frame_arena, frame_spill, FRAME_SPILL_SIZE);
+    fastalloc_stats = (FastAllocStats){ 0 };
+    fastalloc_last_stats = (FastAllocStats){ 0 };
+    fastalloc_frame = 0;
 }
 
 void
 fastalloc_free()
 {
+    // Keep a copy of this frame's numbers so they can be inspected
+    // while the next frame is being built
+    fastalloc_stats.scratch_peak = fastalloc_last_stats.scratch_peak;
+    fastalloc_stats.spill_peak = fastalloc_last_stats.spill_peak;
+    if(fastalloc_stats.scratch_bytes > fastalloc_stats.scratch_peak)
+        fastalloc_stats.scratch_peak = fastalloc_stats.scratch_bytes;
+    if(fastalloc_stats.spill_bytes > fastalloc_stats.spill_peak)
+        fastalloc_stats.spill_peak = fastalloc_stats.spill_bytes;
+    fastalloc_last_stats = fastalloc_stats;
+    fastalloc_stats = (FastAllocStats){ 0 };
+
     alloc_arena_free(&scratchpad_arena);
+    alloc_arena_free(&frame_arena);
+    fastalloc_frame++;
 }
 
 void *
 fastalloc_malloc(size_t size)
 {
-    return alloc_arena_malloc(&scratchpad_arena, size);
+    if(size == 0) return NULL;
+    size = ALIGN_UP(size);
+
+    // Prefer the scratchpad; spill to main RAM when it is full
+    if(alloc_arena_bytes_free(&scratchpad_arena) >= size) {
+        fastalloc_stats.hits++;
+        fastalloc_stats.scratch_bytes += size;
+        return alloc_arena_malloc(&scratchpad_arena, size);
+    }
+
+    fastalloc_stats.spills++;
+    fastalloc_stats.spill_bytes += size;
+    return alloc_arena_malloc(&frame_arena, size);
+}
+
+uint32_t
+fastalloc_get_frame()
+{
+    return fastalloc_frame;
+}
+
+void
+fastalloc_get_stats(FastAllocStats *stats)
+{
+    *stats = fastalloc_last_stats;
+}
+
+uint32_t
+fastalloc_hit_rate()
+{
+    uint32_t total = fastalloc_last_stats.hits + fastalloc_last_stats.spills;
+    if(total == 0) return 100;
+    return (fastalloc_last_stats.hits * 100) / total;
 }
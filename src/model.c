@@ -82,28 +82,28 @@ load_polygon(ObjPolygon *p, uint8_t *bytes, uint32_t *b)
     p->ftype = get_byte(bytes, b);
     switch(p->ftype) {
     case TYPE_F3: {
-        OBJF3 *info = screen_alloc(sizeof(OBJF3));
+        OBJF3 *info = screen_alloc_tagged(sizeof(OBJF3), ARENA_TAG_MODELS);
         PolyLoadColor1(info, bytes, b);
         PolyLoadIV3(info, bytes, b);
         PolyLoadIN1(info, bytes, b);
         p->info = (uint8_t *)info;
     } break;
     case TYPE_G3: {
-        OBJG3 *info = screen_alloc(sizeof(OBJG3));
+        OBJG3 *info = screen_alloc_tagged(sizeof(OBJG3), ARENA_TAG_MODELS);
         PolyLoadColor3(info, bytes, b);
         PolyLoadIV3(info, bytes, b);
         PolyLoadIN3(info, bytes, b);
         p->info = (uint8_t *)info;
     } break;
     case TYPE_F4: {
-        OBJF4 *info = screen_alloc(sizeof(OBJF4));
+        OBJF4 *info = screen_alloc_tagged(sizeof(OBJF4), ARENA_TAG_MODELS);
         PolyLoadColor1(info, bytes, b);
         PolyLoadIV4(info, bytes, b);
         PolyLoadIN1(info, bytes, b);
         p->info = (uint8_t *)info;
     } break;
     case TYPE_G4: {
-        OBJG4 *info = screen_alloc(sizeof(OBJG4));
+        OBJG4 *info = screen_alloc_tagged(sizeof(OBJG4), ARENA_TAG_MODELS);
         PolyLoadColor4(info, bytes, b);
         PolyLoadIV4(info, bytes, b);
         PolyLoadIN4(info, bytes, b);
@@ -144,9 +144,12 @@ load_model(Model *m, const char *filename)
     m->num_normals  = get_short_be(bytes, &b);
     m->num_polygons = get_short_be(bytes, &b);
 
-    m->vertices = screen_alloc(sizeof(VECTOR) * m->num_vertices);
-    m->normals  = screen_alloc(sizeof(VECTOR) * m->num_normals);
-    m->polygons = screen_alloc(sizeof(ObjPolygon) * m->num_polygons);
+    m->vertices = screen_alloc_tagged(
+        sizeof(VECTOR) * m->num_vertices, ARENA_TAG_MODELS);
+    m->normals  = screen_alloc_tagged(
+        sizeof(VECTOR) * m->num_normals, ARENA_TAG_MODELS);
+    m->polygons = screen_alloc_tagged(
+        sizeof(ObjPolygon) * m->num_polygons, ARENA_TAG_MODELS);
 
     for(uint16_t i = 0; i < m->num_vertices; i++) {
         SVECTOR *v = &m->vertices[i];
@@ -197,7 +200,7 @@ render_model(Model *m)
                 (uint32_t *)&poly->x1,
                 (uint32_t *)&poly->x2,
                 &otz);
-            if((nclip < 0) || (otz < 0) || (otz >= OT_LENGTH))
+            if((nclip < 0) || (otz < 0) || (otz >= render_get_ot_length()))
                 continue;
 
             setRGB0(poly, info->r0, info->g0, info->b0);
@@ -216,7 +219,7 @@ render_model(Model *m)
                 (uint32_t *)&poly->x1,
                 (uint32_t *)&poly->x2,
                 &otz);
-            if((nclip < 0) || (otz < 0) || (otz >= OT_LENGTH))
+            if((nclip < 0) || (otz < 0) || (otz >= render_get_ot_length()))
                 continue;
 
             setRGB0(poly, info->r0, info->g0, info->b0);
@@ -239,7 +242,7 @@ render_model(Model *m)
                 (uint32_t *)&poly->x2,
                 (uint32_t *)&poly->x3,
                 &otz);
-            if((nclip < 0) || (otz < 0) || (otz >= OT_LENGTH))
+            if((nclip < 0) || (otz < 0) || (otz >= render_get_ot_length()))
                 continue;
 
             setRGB0(poly, info->r0, info->g0, info->b0);
@@ -260,7 +263,7 @@ render_model(Model *m)
                 (uint32_t *)&poly->x2,
                 (uint32_t *)&poly->x3,
                 &otz);
-            if((nclip < 0) || (otz < 0) || (otz >= OT_LENGTH))
+            if((nclip < 0) || (otz < 0) || (otz >= render_get_ot_length()))
                 continue;
 
             setRGB0(poly, info->r0, info->g0, info->b0);
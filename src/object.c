@@ -5,6 +5,24 @@
 #include "memalloc.h"
 #include "util.h"
 #include "screen.h"
+#include "cache.h"
+
+// When set, object tables are allocated on the persistent asset cache
+// instead of the scene arena. Should the cache fill up halfway, the rest
+// of the table goes on the scene arena and the table is not cached
+static uint8_t _load_persistent = 0;
+static uint8_t _load_spilled = 0;
+
+static void *
+_table_alloc(uint32_t size)
+{
+    if(_load_persistent) {
+        void *ptr = cache_alloc(size);
+        if(ptr) return ptr;
+        _load_spilled = 1;
+    }
+    return screen_alloc_tagged(size, ARENA_TAG_OBJECTS);
+}
 
 void
 _load_animation(ObjectAnim *animation, uint8_t *bytes, uint32_t *b)
@@ -14,7 +32,7 @@ _load_animation(ObjectAnim *animation, uint8_t *bytes, uint32_t *b)
     animation->loopback   = get_byte(bytes, b);
     animation->duration   = get_byte(bytes, b);
     if(animation->num_frames > 0) {
-        animation->frames = screen_alloc(
+        animation->frames = _table_alloc(
             sizeof(ObjectAnimFrame) * animation->num_frames);
 
         for(uint16_t i = 0; i < animation->num_frames; i++) {
@@ -35,7 +53,7 @@ load_object_table(const char *filename, ObjectTable *tbl)
     uint8_t *bytes;
     uint32_t b, length;
 
-    bytes = file_read(filename, &length);
+    bytes = file_read_view(filename, &length);
     if(bytes == NULL) {
         printf("Error reading OTD file %s from the CD.\n", filename);
         return;
@@ -48,7 +66,7 @@ load_object_table(const char *filename, ObjectTable *tbl)
 
     if(tbl->num_entries == 0) goto end;
 
-    tbl->entries = screen_alloc(sizeof(ObjectTableEntry) * tbl->num_entries);
+    tbl->entries = _table_alloc(sizeof(ObjectTableEntry) * tbl->num_entries);
 
     for(uint16_t i = 0; i < tbl->num_entries; i++) {
         ObjectTableEntry *entry = &tbl->entries[i];
@@ -64,7 +82,7 @@ load_object_table(const char *filename, ObjectTable *tbl)
         entry->num_animations = get_short_be(bytes, &b);
 
         if(entry->num_animations > 0) {
-            entry->animations = screen_alloc(
+            entry->animations = _table_alloc(
                 sizeof(ObjectAnim) * entry->num_animations);
 
             for(uint16_t j = 0; j < entry->num_animations; j++) {
@@ -74,13 +92,13 @@ load_object_table(const char *filename, ObjectTable *tbl)
         }
 
         if(entry->has_fragment) {
-            ObjectFrag *fragment = screen_alloc(sizeof(ObjectFrag));
+            ObjectFrag *fragment = _table_alloc(sizeof(ObjectFrag));
             entry->fragment = fragment;
 
             fragment->offsetx = get_short_be(bytes, &b);
             fragment->offsety = get_short_be(bytes, &b);
             fragment->num_animations = get_short_be(bytes, &b);
-            fragment->animations = screen_alloc(
+            fragment->animations = _table_alloc(
                 sizeof(ObjectAnim) * fragment->num_animations);
             
             for(uint16_t j = 0; j < fragment->num_animations; j++) {
@@ -91,6 +109,25 @@ load_object_table(const char *filename, ObjectTable *tbl)
     }
 
 end:
-    free(bytes);
+    file_release(bytes);
     printf("Loaded %d object types.\n", tbl->num_entries);
 }
+
+void
+load_object_table_cached(const char *filename, ObjectTable *tbl)
+{
+    ObjectTable *cached = cache_get(filename);
+    if(!cached) {
+        cached = cache_alloc(sizeof(ObjectTable));
+        if(!cached) {
+            load_object_table(filename, tbl);
+            return;
+        }
+        _load_persistent = 1;
+        _load_spilled = 0;
+        load_object_table(filename, cached);
+        _load_persistent = 0;
+        if(!_load_spilled) cache_put(filename, cached);
+    } else printf("Object table %s already cached\n", filename);
+    *tbl = *cached;
+}
@@ -14,6 +14,9 @@
 #include "camera.h"
 #include "boss.h"
 #include "screen.h"
+#include "vram.h"
+#include "water.h"
+#include "budget.h"
 
 extern uint8_t        paused;
 extern Player         *player;
@@ -167,7 +170,8 @@ _emplace_object(
     // Initialize animation state if this object
     // has a fragment
     if(has_fragment) {
-        state->frag_anim_state = screen_alloc(sizeof(ObjectAnimState));
+        state->frag_anim_state = screen_alloc_tagged(
+            sizeof(ObjectAnimState), ARENA_TAG_OBJECTS);
         *state->frag_anim_state = (ObjectAnimState){ 0 };
     }
 
@@ -219,7 +223,7 @@ load_object_placement(const char *filename, void *lvl_data, uint8_t has_started)
     uint32_t b, length;
 
     // Slurp object placement file
-    bytes = file_read(filename, &length);
+    bytes = file_read_view(filename, &length);
     if(bytes == NULL) {
         printf("Error reading OTD file %s from the CD.\n", filename);
         return;
@@ -246,11 +250,11 @@ load_object_placement(const char *filename, void *lvl_data, uint8_t has_started)
         switch(type) {
         default: break;
         case OBJ_MONITOR:
-            extra = screen_alloc(sizeof(MonitorExtra));
+            extra = screen_alloc_tagged(sizeof(MonitorExtra), ARENA_TAG_OBJECTS);
             ((MonitorExtra *)extra)->kind = get_byte(bytes, &b);
             break;
         case OBJ_BUBBLE_PATCH:
-            extra = screen_alloc(sizeof(BubblePatchExtra));
+            extra = screen_alloc_tagged(sizeof(BubblePatchExtra), ARENA_TAG_OBJECTS);
             ((BubblePatchExtra *)extra)->frequency = get_byte(bytes, &b);
 
             // Start timer at a low timer so we start with idle instead of producing
@@ -268,7 +272,7 @@ load_object_placement(const char *filename, void *lvl_data, uint8_t has_started)
 
         ChunkObjectData *data = lvl->objects[chunk_pos];
         if(!data) {
-            data = screen_alloc(sizeof(ChunkObjectData));
+            data = screen_alloc_tagged(sizeof(ChunkObjectData), ARENA_TAG_OBJECTS);
             lvl->objects[chunk_pos] = data;
             *data = (ChunkObjectData){ 0 };
         }
@@ -325,7 +329,7 @@ load_object_placement(const char *filename, void *lvl_data, uint8_t has_started)
     placement_idx = NULL;
 
     // Free slurped file
-    free(bytes);
+    file_release(bytes);
 }
 
 void
@@ -333,9 +337,8 @@ unload_object_placements(void *lvl_data)
 {
     LevelData *lvl = (LevelData *)lvl_data;
 
-    // Levels are 255 x 31, so we have this amount of objects
-    // to unload
-    for(uint32_t i = 0; i < LEVEL_MAX_X_CHUNKS * LEVEL_MAX_Y_CHUNKS; i++) {
+    // Go through every chunk that may hold objects
+    for(uint32_t i = 0; i < lvl->num_chunks; i++) {
         ChunkObjectData *cnk = lvl->objects[i];
         if(cnk != NULL) {
             if(cnk->num_objects == 0) continue;
@@ -377,7 +380,7 @@ count_emplaced_rings(void *lvl_data)
 {
     uint16_t result = 0;
     LevelData *lvl = (LevelData *)lvl_data;
-    for(uint32_t i = 0; i < LEVEL_MAX_X_CHUNKS * LEVEL_MAX_Y_CHUNKS; i++) {
+    for(uint32_t i = 0; i < lvl->num_chunks; i++) {
         ChunkObjectData *cnk = lvl->objects[i];
         if(cnk != NULL) {
             for(uint8_t j = 0; j < cnk->num_objects; j++) {
@@ -476,6 +479,14 @@ begin_render_routine:
     if((state->id == OBJ_SHIELD) && ((anim->counter >> 1) % 2))
         goto after_render;
 
+    // Purely decorative objects are the first ones to go when the level
+    // is over its primitive budget. They still animate while hidden
+    if((budget_level() >= BUDGET_LEVEL_NO_DECOR)
+       && ((state->id == OBJ_EXPLOSION)
+           || (state->id == OBJ_ANIMAL)
+           || (state->id == OBJ_AMY_HEART)))
+        goto after_render;
+
     POLY_FT4 *poly = (POLY_FT4 *)get_next_prim();
     increment_prim(sizeof(POLY_FT4));
     setPolyFT4(poly);
@@ -522,22 +533,27 @@ begin_render_routine:
     }
 
     if(!typedata->is_level_specific) {
-        // COMMON OBJECTS have the following VRAM coords:
-        // Sprites: 576x0
-        // CLUT: 0x481
-        poly->tpage = getTPage(1, 0, 576, frame->tpage ? 256 : 0);
-        poly->clut = getClut(0, 481);
+        // COMMON OBJECTS use both texture pages of their area
+        VramArea *area = vram_get(VRAM_AREA_OBJ_COMMON);
+        poly->tpage = getTPage(1, 0, area->prect.x,
+                               area->prect.y + (frame->tpage ? 256 : 0));
+        poly->clut = getClut(area->crect.x,
+                             water_clut_row_at(area->crect.y, ovy));
     } else {
-        // LEVEL OBJECTS have these VRAM coords:
-        // Sprites: 704x0
-        // CLUT: 0x485
-        // Boss CLUT: 0x486 (normal); 0x487 (when hit)
-        poly->tpage = getTPage(1, 0, 704, frame->tpage ? 256 : 0);
+        // LEVEL OBJECTS use their area's first CLUT row.
+        // The boss uses the lower page, with its palette on the second
+        // row (normal) and on the third row (when hit)
+        VramArea *area = vram_get(VRAM_AREA_OBJ_LEVEL);
+        poly->tpage = getTPage(1, 0, area->prect.x,
+                               area->prect.y + (frame->tpage ? 256 : 0));
+        // Objects below the water surface use their underwater palette
         poly->clut = getClut(
-            0,
-            (frame->tpage && level_has_boss)
-            ? (boss_hit_glowing() ? 487 : 486)
-            : 485);
+            area->crect.x,
+            water_clut_row_at(
+                area->crect.y + ((frame->tpage && level_has_boss)
+                                 ? (boss_hit_glowing() ? 2 : 1)
+                                 : 0),
+                ovy));
     }
 
     uint32_t layer = ((state->id == OBJ_RING)
@@ -557,6 +573,7 @@ begin_render_routine:
         layer = OTZ_LAYER_HUD;
 
     sort_prim(poly, layer);
+    budget_count(BUDGET_OBJECTS, 1);
 
 after_render:
 
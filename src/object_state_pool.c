@@ -10,6 +10,13 @@
 static PoolObject *_object_pool;
 static uint32_t   _pool_count = 0;
 
+// Indices of live pool objects for the current frame, kept on the
+// scratchpad. Built during update so that render skips free slots
+static uint8_t  *_pool_active = NULL;
+static uint32_t  _pool_active_count = 0;
+static uint32_t  _pool_active_frame = 0;
+static uint32_t  _pool_scan_pos = 0;
+
 extern ObjectTable *obj_table_common;
 extern ObjectTable *obj_table_level;
 
@@ -21,7 +28,8 @@ extern void _render_obj(
 void
 object_pool_init()
 {
-    _object_pool = screen_alloc(sizeof(PoolObject) * OBJECT_POOL_SIZE);
+    _object_pool = screen_alloc_tagged(
+        sizeof(PoolObject) * OBJECT_POOL_SIZE, ARENA_TAG_OBJECTS);
 
     // Zero-initialize all objects and set them as free, destroyed objects.
     for(uint32_t i = 0; i < OBJECT_POOL_SIZE; i++) {
@@ -30,6 +38,7 @@ object_pool_init()
     }
 
     _pool_count = 0;
+    _pool_active = NULL;
     printf("Initialized object pool\n");
 }
 
@@ -37,8 +46,12 @@ void
 object_pool_update(uint8_t round)
 {
     _pool_count = 0;
+    _pool_active = fastalloc_malloc(sizeof(uint8_t) * OBJECT_POOL_SIZE);
+    _pool_active_count = 0;
+    _pool_active_frame = fastalloc_get_frame();
     for(uint32_t i = 0; i < OBJECT_POOL_SIZE; i++) {
         PoolObject *obj = &_object_pool[i];
+        _pool_scan_pos = i + 1;
         if(!(obj->props & OBJ_FLAG_DESTROYED)) {
             VECTOR pos = { obj->freepos.vx >> 12, obj->freepos.vy >> 12, 0 };
             object_update((ObjectState *)&obj->state,
@@ -47,7 +60,10 @@ object_pool_update(uint8_t round)
                           : &obj_table_common->entries[obj->state.id],
                           &pos,
                           round);
-            _pool_count += !(obj->props & OBJ_FLAG_DESTROYED);
+            if(!(obj->props & OBJ_FLAG_DESTROYED)) {
+                _pool_count++;
+                _pool_active[_pool_active_count++] = i;
+            }
         }
     }
 }
@@ -58,8 +74,14 @@ object_pool_render(int32_t camera_x, int32_t camera_y)
     camera_x = (camera_x >> 12) - CENTERX;
     camera_y = (camera_y >> 12) - CENTERY;
 
-    for(uint32_t i = 0; i < OBJECT_POOL_SIZE; i++) {
-        PoolObject *obj = &_object_pool[i];
+    // Use the active list if it was built this frame; otherwise (e.g. when
+    // paused) fall back to scanning the whole pool
+    uint8_t use_active =
+        _pool_active && (_pool_active_frame == fastalloc_get_frame());
+    uint32_t count = use_active ? _pool_active_count : OBJECT_POOL_SIZE;
+
+    for(uint32_t n = 0; n < count; n++) {
+        PoolObject *obj = &_object_pool[use_active ? _pool_active[n] : n];
 
         // Inactive objects are discarded
         if(obj->props & OBJ_FLAG_DESTROYED) continue;
@@ -93,6 +115,14 @@ object_pool_create(ObjectType t)
 
             // A little pointer for the actual object position in the world
             _object_pool[i].state.freepos = (ObjectFreePos *)&_object_pool[i].freepos;
+
+            // Slots already passed by this frame's update would otherwise
+            // be missing from the active list
+            if(_pool_active
+               && (_pool_active_frame == fastalloc_get_frame())
+               && (i < _pool_scan_pos)
+               && (_pool_active_count < OBJECT_POOL_SIZE))
+                _pool_active[_pool_active_count++] = i;
             return (PoolObject *) &_object_pool[i];
         }
     }
@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <assert.h>
+#include <psxgte.h>
 
 #include "parallax.h"
 #include "util.h"
@@ -7,6 +8,8 @@
 #include "camera.h"
 #include "render.h"
 #include "screen.h"
+#include "water.h"
+#include "budget.h"
 
 #include "screens/level.h"
 
@@ -36,19 +39,21 @@ load_parallax(Parallax *parallax, const char *filename,
     parallax->strips = NULL;
 
     b = 0;
-    bytes = file_read(filename, &length);
+    bytes = file_read_view(filename, &length);
     if(bytes == NULL) {
         printf("Error reading PRL file %s from the CD. Using defaults\n", filename);
         return;
     }
 
     parallax->num_strips = get_byte(bytes, &b);
-    parallax->strips = screen_alloc(
-        sizeof(ParallaxStrip) * parallax->num_strips);
+    parallax->strips = screen_alloc_tagged(
+        sizeof(ParallaxStrip) * parallax->num_strips, ARENA_TAG_PARALLAX);
 
     // Prepare polygon lists
-    prl_pols[0] = screen_alloc(sizeof(POLY_FT4 **) * parallax->num_strips);
-    prl_pols[1] = screen_alloc(sizeof(POLY_FT4 **) * parallax->num_strips);
+    prl_pols[0] = screen_alloc_tagged(
+        sizeof(POLY_FT4 **) * parallax->num_strips, ARENA_TAG_PARALLAX);
+    prl_pols[1] = screen_alloc_tagged(
+        sizeof(POLY_FT4 **) * parallax->num_strips, ARENA_TAG_PARALLAX);
     
     for(uint8_t i = 0; i < parallax->num_strips; i++) {
         ParallaxStrip *strip = &parallax->strips[i];
@@ -64,41 +69,180 @@ load_parallax(Parallax *parallax, const char *filename,
 
         strip->rposx     = 0;
 
+        // Line scroll bands, if any
+        strip->band_height    = get_byte(bytes, &b);
+        strip->num_bands      = 1;
+        strip->band_scrollx   = NULL;
+        strip->wave_amplitude = 0;
+        strip->wave_step      = 0;
+        strip->wave_speed     = 0;
+        strip->wave_phase     = 0;
+        strip->built_vy[0] = strip->built_vy[1] = INT16_MAX;
+        if(strip->band_height > 0) {
+            strip->wave_amplitude = get_byte(bytes, &b);
+            strip->wave_step      = get_short_be(bytes, &b);
+            strip->wave_speed     = get_short_be(bytes, &b);
+            strip->num_bands = (strip->height + strip->band_height - 1)
+                / strip->band_height;
+            assert(strip->num_bands <= PRL_MAX_BANDS);
+            strip->band_scrollx = screen_alloc_tagged(
+                sizeof(int32_t) * strip->num_bands, ARENA_TAG_PARALLAX);
+            for(uint8_t bi = 0; bi < strip->num_bands; bi++)
+                strip->band_scrollx[bi] = get_long_be(bytes, &b);
+        }
+
         /* RENDERING OPTIMIZATION */
-        // 1. Calculate number of polygons needed for this strip, round up
-        uint32_t polygons_per_strip = (SCREEN_XRES / strip->width) + 3;
-        
+        // 1. Calculate number of polygons needed for this strip. Drawing
+        // starts at most one strip width left of the screen, so this is
+        // how many repetitions can ever be seen at once. Banded strips
+        // hold that many polygons for each of their bands
+        strip->polys_per_band = strip->is_single
+            ? 1
+            : (SCREEN_XRES / strip->width) + 2;
+        uint32_t polygons_per_strip = strip->polys_per_band * strip->num_bands;
+
         // 2. Allocate polygons for this strip
-        prl_pols[0][i] = screen_alloc(sizeof(POLY_FT4) * polygons_per_strip);
-        prl_pols[1][i] = screen_alloc(sizeof(POLY_FT4) * polygons_per_strip);
+        prl_pols[0][i] = screen_alloc_tagged(
+            sizeof(POLY_FT4) * polygons_per_strip, ARENA_TAG_PARALLAX);
+        prl_pols[1][i] = screen_alloc_tagged(
+            sizeof(POLY_FT4) * polygons_per_strip, ARENA_TAG_PARALLAX);
 
         // 3. Preload and prepare polygons for this strip
         // TODO: 6 or 8 Depends on CLUT!!!
         uint16_t curr_px = (uint16_t)(px + ((uint32_t)bgindex << 6));
         uint16_t curr_cy = (uint16_t)(cy + bgindex);
+        strip->clut_x = cx;
+        strip->clut_y = curr_cy;
 
         for(uint32_t p = 0; p < polygons_per_strip; p++) {
             POLY_FT4 *poly0 = &prl_pols[0][i][p];
             POLY_FT4 *poly1 = &prl_pols[1][i][p];
+
+            // Each band samples its own lines of the strip's texture
+            uint8_t  band = p / strip->polys_per_band;
+            uint8_t  bv0 = v0;
+            uint16_t bh = strip->height;
+            if(strip->band_height > 0) {
+                bv0 += band * strip->band_height;
+                bh = MIN(strip->band_height,
+                         strip->height - band * strip->band_height);
+            }
             
             setPolyFT4(poly0);
             setRGB0(poly0, 0, 0, 0);
             poly0->tpage = getTPage(tx_mode & 0x3, 0, curr_px, py);
             poly0->clut = getClut(cx, curr_cy);
             //setXYWH(poly0, 0, strip->y0, strip->width, strip->height);
-            setUVWH(poly0, u0, v0, strip->width - 1, strip->height - 1);
+            setUVWH(poly0, u0, bv0, strip->width - 1, bh - 1);
             
             setPolyFT4(poly1);
             setRGB0(poly1, 0, 0, 0);
             poly1->tpage = getTPage(tx_mode & 0x3, 0, curr_px, py);
             poly1->clut = getClut(cx, curr_cy);
             //setXYWH(poly1, 0, strip->y0, strip->width, strip->height);
-            setUVWH(poly1, u0, v0, strip->width - 1, strip->height - 1);
+            setUVWH(poly1, u0, bv0, strip->width - 1, bh - 1);
         }
         
     }
 
-    free(bytes);
+    file_release(bytes);
+}
+
+static int32_t
+_first_repetition(ParallaxStrip *strip, int32_t vx)
+{
+    int32_t width = strip->width;
+    // Single strips are only drawn once, from the first of their
+    // positions at or past one strip width left of the screen
+    if(strip->is_single) {
+        if(vx < -width) {
+            vx %= width;
+            if(vx == 0) vx = -width;
+        }
+        return vx + (SCREEN_XRES >> 1);
+    }
+    // Leftmost repetition which still touches the left edge of the screen
+    vx %= width;
+    return (vx > 0) ? vx - width : vx;
+}
+
+static uint16_t
+_parallax_draw_strip(ParallaxStrip *strip, POLY_FT4 *polys,
+                     int32_t camera_vx, int32_t vy)
+{
+    uint16_t band_height = strip->band_height
+        ? strip->band_height
+        : strip->height;
+
+    // Polygons keep their Y across frames, and are only moved vertically
+    // when the strip itself moves
+    if(strip->built_vy[prl_current_buffer] != vy) {
+        for(uint8_t bi = 0; bi < strip->num_bands; bi++) {
+            int16_t y0 = vy + bi * band_height;
+            int16_t y1 = y0 + MIN(band_height, strip->height - bi * band_height);
+            POLY_FT4 *poly = &polys[bi * strip->polys_per_band];
+            for(uint8_t p = 0; p < strip->polys_per_band; p++, poly++) {
+                poly->y0 = poly->y1 = y0;
+                poly->y2 = poly->y3 = y1;
+            }
+        }
+        strip->built_vy[prl_current_buffer] = vy;
+    }
+
+    uint16_t drawn = 0;
+    for(uint8_t bi = 0; bi < strip->num_bands; bi++) {
+        int32_t by = vy + bi * band_height;
+        if((by + band_height <= 0) || (by >= SCREEN_YRES))
+            continue;
+
+        // Cast multiplication to avoid sign extension on bit shift
+        // This gets the mult. result but also removes the decimal part
+        int32_t scrollx = strip->band_scrollx
+            ? strip->band_scrollx[bi]
+            : strip->scrollx;
+        int32_t bandx = (uint32_t)(camera_vx * -scrollx) >> 24;
+
+        // Coordinates currently start drawing at screen center, so
+        // push them back one screem
+        bandx -= SCREEN_XRES + SCREEN_XRES;
+        bandx += strip->rposx >> 12;
+        if(strip->wave_amplitude > 0) {
+            uint16_t angle = strip->wave_phase + bi * strip->wave_step;
+            bandx += (rsin(angle) * strip->wave_amplitude) >> 12;
+        }
+
+        // Given that each part is a horizontal piece of a strip, we assume
+        // that these parts repeat at every (strip width), so just draw
+        // all equal parts now at once, until we exhaust the screen width
+        int32_t wx = _first_repetition(strip, bandx);
+        uint16_t clut = getClut(strip->clut_x,
+                                water_clut_row_at(strip->clut_y, by));
+        POLY_FT4 *poly = &polys[bi * strip->polys_per_band];
+        for(uint8_t p = 0;
+            (p < strip->polys_per_band) && (wx < SCREEN_XRES);
+            p++, poly++, wx += strip->width)
+        {
+            setRGB0(poly, level_fade, level_fade, level_fade);
+            poly->clut = clut;
+            poly->x0 = poly->x2 = wx;
+            poly->x1 = poly->x3 = wx + strip->width;
+            sort_prim(poly, OTZ_LAYER_LEVEL_BG);
+            drawn++;
+        }
+    }
+    return drawn;
+}
+
+// Strips move on their own once per simulation step, whether they are
+// drawn or not
+void
+parallax_update(Parallax *prl)
+{
+    for(uint8_t si = 0; si < prl->num_strips; si++) {
+        ParallaxStrip *strip = &prl->strips[si];
+        strip->rposx -= strip->speedx;
+        strip->wave_phase += strip->wave_speed;
+    }
 }
 
 void
@@ -126,53 +270,27 @@ parallax_draw(Parallax *prl, Camera *camera)
     
     // Camera left boundary (fixed 20.12 format)
     int32_t camera_vx = (camera->pos.vx - (CENTERX << 12));
+    uint8_t skip_far = (budget_level() >= BUDGET_LEVEL_NO_FAR_STRIPS);
+    uint16_t drawn = 0;
 
     // Strips are draw bottom to top so we can have further stuff
     // (e.g. clouds) drawn on back
     for(int8_t si = prl->num_strips - 1; si >= 0; si--) {
         ParallaxStrip *strip = &prl->strips[si];
-        // Cast multiplication to avoid sign extension on bit shift
-        // This gets the mult. result but also removes the decimal part
-        int32_t stripx = (uint32_t)(camera_vx * -strip->scrollx) >> 24;
-
-        // Coordinates currently start drawing at screen center, so
-        // push them back one screem
-        stripx -= SCREEN_XRES + SCREEN_XRES;
-
-        // Update strip relative position when there's speed involved
-        strip->rposx -= strip->speedx;
 
-        // Calculate part X position based on factor and camera (int format)
-        int32_t vx = stripx + (strip->rposx >> 12);
+        // Strips are placed relative to the water surface where there is
+        // one, so this also culls strips pushed away by it. Strips behind
+        // the (translucent) water overlay are still visible
         int32_t vy = strip->y0 + start_y;
-
-        if((vy + strip->height < 0) || (vy > SCREEN_YRES))
+        if((vy + strip->height <= 0) || (vy >= SCREEN_YRES))
+            continue;
+        if(skip_far && (strip->scrollx < PRL_FAR_SCROLLX))
             continue;
 
-        // Given that each part is a horizontal piece of a strip, we assume
-        // that these parts repeat at every (strip width), so just draw
-        // all equal parts now at once, until we exhaust the screen width
-        uint32_t poly_n = 0;
-        for(int32_t wx = vx;
-            wx < (int32_t)(SCREEN_XRES + strip->width);
-            wx += strip->width)
-        {
-            // Don't draw if strip is outside screen
-            if((wx + strip->width) < 0) continue;
-
-            // If this is a single strip, adjust it and move it forward a bit
-            if(strip->is_single) wx += SCREEN_XRES >> 1;
-
-            POLY_FT4 *poly = &prl_pols[prl_current_buffer][si][poly_n];
-            setRGB0(poly, level_fade, level_fade, level_fade);
-            setXYWH(poly, wx, vy, strip->width, strip->height);
-            sort_prim(poly, OTZ_LAYER_LEVEL_BG);
-
-            poly_n++;
-            // If drawing a single time, stop now
-            if(strip->is_single) break;
-        }
+        drawn += _parallax_draw_strip(strip, prl_pols[prl_current_buffer][si],
+                                      camera_vx, vy);
     }
 
+    budget_count(BUDGET_PARALLAX, drawn);
     prl_current_buffer ^= 1;
 }
@@ -4,6 +4,7 @@
 
 #include "player.h"
 #include "util.h"
+#include "cache.h"
 #include "input.h"
 #include "render.h"
 #include "sound.h"
@@ -11,6 +12,7 @@
 #include "collision.h"
 #include "basic_font.h"
 #include "player_constants.h"
+#include "water.h"
 #include "screens/level.h"
 #include "timer.h"
 
@@ -126,6 +128,9 @@ extern int32_t    level_water_y;
 #define LANDING_ANGLE_SLOPE_LEFT  0x0e0b // 316
 #define LANDING_ANGLE_SLOPE_RIGHT 0x0200 // 45
 
+// Character data loaded while the asset cache was full
+static Chara _uncached_chara = { 0 };
+
 /* Forward declarations */
 void player_do_pikospin(Player *);
 
@@ -137,7 +142,21 @@ load_player(Player *player,
 {
     player->character = character;
     player->input = (InputState){ 0 };
-    load_chara(&player->chara, chara_filename, sprites);
+    // Character data never changes between scenes, so keep it around
+    Chara *cached = cache_get(chara_filename);
+    if(!cached) {
+        cached = cache_alloc(sizeof(Chara));
+        if(cached) {
+            load_chara(cached, chara_filename, sprites);
+            cache_put(chara_filename, cached);
+        } else {
+            // Asset cache is full; only the latest uncached copy is kept
+            free_chara(&_uncached_chara);
+            cached = &_uncached_chara;
+            load_chara(cached, chara_filename, sprites);
+        }
+    }
+    player->chara = *cached;
     player->cur_anim = NULL;
     player->tail_cur_anim = NULL;
     player->cnst  = getconstants(character, PC_DEFAULT);
@@ -185,7 +204,8 @@ load_player(Player *player,
 void
 free_player(Player *player)
 {
-    free_chara(&player->chara);
+    // Character data is owned by the asset cache, so only drop the reference
+    player->chara = (Chara){ 0 };
 }
 
 uint32_t
@@ -315,11 +335,12 @@ player_set_frame_duration(Player *player, uint8_t duration)
 }
 
 void
-_draw_sensor(uint16_t anchorx, uint16_t anchory, LinecastDirection dir,
+_draw_sensor(int32_t anchorx, int32_t anchory, LinecastDirection dir,
              uint16_t mag, uint8_t r, uint8_t g, uint8_t b)
 {
-    // Calculate ending point according to direction and magnitude
-    uint16_t endx = anchorx, endy = anchory;
+    // Calculate ending point according to direction and magnitude.
+    // World coordinates go past 16 bits on long acts
+    int32_t endx = anchorx, endy = anchory;
     switch(dir) {
     case CDIR_RWALL:
         endx += mag;
@@ -361,9 +382,9 @@ _player_update_collision_lr(Player *player)
         return;
 
     /* Collider linecasts */
-    uint16_t
+    int32_t
         anchorx = (player->pos.vx >> 12),
-        anchory = (player->pos.vy >> 12) - 8;
+        anchory = (player->pos.vy >> 12) - PUSH_SENSOR_Y;
 
 
     // SPECIAL HORIZONTAL COLLISION: KNUCKLES CLIMB DROP / CLAMBERING
@@ -374,8 +395,8 @@ _player_update_collision_lr(Player *player)
         LinecastDirection dir =
             (player->anim_dir > 0) ? CDIR_RWALL : CDIR_LWALL;
         uint16_t radius = PUSH_RADIUS + ((player->anim_dir < 0) ? 1 : 0);
-        int16_t drop_anchory = anchory + HEIGHT_RADIUS_CLIMB;
-        int16_t clamber_anchory = anchory - HEIGHT_RADIUS_CLIMB;
+        int32_t drop_anchory = anchory + HEIGHT_RADIUS_CLIMB;
+        int32_t clamber_anchory = anchory - HEIGHT_RADIUS_CLIMB;
 
         player->ev_climbdrop = linecast(anchorx, drop_anchory,
                                         dir, radius, CDIR_FLOOR);
@@ -391,9 +412,9 @@ _player_update_collision_lr(Player *player)
         return;
     }
 
-    // Adjust y anchor to y + 8 when on totally flat ground
+    // Adjust y anchor back to the centre when on totally flat ground
     int32_t push_anchory = anchory
-        + ((player->grnd && player->angle == 0) ? 8 : 0);
+        + ((player->grnd && player->angle == 0) ? PUSH_SENSOR_Y : 0);
 
     uint16_t left_mag  = PUSH_RADIUS;
     uint16_t right_mag = PUSH_RADIUS;
@@ -432,6 +453,13 @@ _player_update_collision_lr(Player *player)
 
     int32_t vel_x = player->grnd ? player->vel.vz : player->vel.vx;
 
+    // Stretch push sensors along fast movement, so that thin walls are not
+    // skipped over. Only horizontal pushing is resolved, see below
+    if(player->psmode == CDIR_FLOOR) {
+        if(vel_x < 0) left_mag = linecast_sweep_magnitude(left_mag, player->vel.vx);
+        else if(vel_x > 0) right_mag = linecast_sweep_magnitude(right_mag, player->vel.vx);
+    }
+
     if(is_push_active) {
         // "E" sensor
         if(!player->ev_left.collided) {
@@ -512,14 +540,14 @@ _player_update_collision_lr(Player *player)
         if(player->ev_right.collided && vel_x > 0) {
             if(player->grnd) player->vel.vz = 0;
             else player->vel.vx = 0;
-            player->pos.vx = (player->ev_right.coord - 10) << 12;
+            player->pos.vx = (player->ev_right.coord - PUSH_SNAP_RIGHT) << 12;
             if(player->grnd) player->push = 1;
         }
 
         if(player->ev_left.collided && vel_x < 0) {
             if(player->grnd) player->vel.vz = 0;
             else player->vel.vx = 0;
-            player->pos.vx = (player->ev_left.coord + 25) << 12;
+            player->pos.vx = (player->ev_left.coord + PUSH_SNAP_LEFT) << 12;
             if(player->grnd) player->push = 1;
         }
         break;
@@ -532,7 +560,7 @@ void
 _player_update_collision_tb(Player *player)
 {
     /* Collider linecasts */
-    uint16_t
+    int32_t
         anchorx = (player->pos.vx >> 12),
         anchory = (player->pos.vy >> 12);
 
@@ -545,9 +573,9 @@ _player_update_collision_tb(Player *player)
         grn_mag = ceil_mag = HEIGHT_RADIUS_ROLLING;
     }
 
-    ceil_mag = ceil_mag >> 1; // Halve ceiling sensor magnitude
+    ceil_mag = CEILING_MAGNITUDE(ceil_mag);
 
-    uint16_t anchorx_left = anchorx,
+    int32_t anchorx_left = anchorx,
         anchorx_right = anchorx,
         anchory_left = anchory,
         anchory_right = anchory;
@@ -583,7 +611,7 @@ _player_update_collision_tb(Player *player)
     };
 
     // Recalculate ceiling sensor anchors
-    uint16_t anchorx_top_left = anchorx_left,
+    int32_t anchorx_top_left = anchorx_left,
         anchorx_top_right = anchorx_right,
         anchory_top_left = anchory,
         anchory_top_right = anchory;
@@ -608,6 +636,14 @@ _player_update_collision_tb(Player *player)
         break;
     };
 
+    // Stretch sensors along fast vertical movement while airborne
+    if(!player->grnd) {
+        if(player->vel.vy > 0)
+            grn_mag = linecast_sweep_magnitude(grn_mag, player->vel.vy);
+        else if(player->vel.vy < 0)
+            ceil_mag = linecast_sweep_magnitude(ceil_mag, player->vel.vy);
+    }
+
     // Ground sensors
     if(!player->ev_grnd1.collided) {
         player->ev_grnd1 = linecast(anchorx_left, anchory_left,
@@ -708,7 +744,7 @@ _player_update_collision_tb(Player *player)
                || (new_coord == 0))
                 new_coord = player->ev_grnd2.coord;
 
-            player->pos.vy = ((new_coord - 16) << 12);
+            player->pos.vy = ((new_coord - GROUND_SNAP) << 12);
 
             // When gliding, apply friction
             player->sliding = 0;
@@ -770,7 +806,7 @@ _player_update_collision_tb(Player *player)
                || (new_coord == 0))
                 new_coord = player->ev_ceil2.coord;
             
-            player->pos.vy = (new_coord + 32) << 12;
+            player->pos.vy = (new_coord + CEILING_SNAP) << 12;
             player->ceil = 1;
         } else player->ceil = 0;
 
@@ -813,21 +849,21 @@ _player_update_collision_tb(Player *player)
                 if((player->ev_grnd2.collided && (player->ev_grnd2.coord < new_coord))
                    || (new_coord == 0))
                     new_coord = player->ev_grnd2.coord;
-                player->pos.vx = (new_coord - 16) << 12;
+                player->pos.vx = (new_coord - GROUND_SNAP) << 12;
                 break;
             case CDIR_LWALL:
                 if(player->ev_grnd1.collided) new_coord = player->ev_grnd1.coord;
                 if((player->ev_grnd2.collided && (player->ev_grnd2.coord > new_coord))
                    || (new_coord == 0))
                     new_coord = player->ev_grnd2.coord;
-                player->pos.vx = (new_coord + 16) << 12;
+                player->pos.vx = (new_coord + GROUND_SNAP) << 12;
                 break;
             case CDIR_CEILING:
                 if(player->ev_grnd1.collided) new_coord = player->ev_grnd1.coord;
                 if((player->ev_grnd2.collided && (player->ev_grnd2.coord > new_coord))
                    || (new_coord == 0))
                     new_coord = player->ev_grnd2.coord;
-                player->pos.vy = (new_coord + 16) << 12;
+                player->pos.vy = (new_coord + GROUND_SNAP) << 12;
                 break;
             case CDIR_FLOOR:
             default:
@@ -835,7 +871,7 @@ _player_update_collision_tb(Player *player)
                 if((player->ev_grnd2.collided && (player->ev_grnd2.coord < new_coord))
                    || (new_coord == 0))
                     new_coord = player->ev_grnd2.coord;
-                player->pos.vy = (new_coord - 16) << 12;
+                player->pos.vy = (new_coord - GROUND_SNAP) << 12;
                 break;
             };
         }
@@ -1881,6 +1917,10 @@ player_draw(Player *player, VECTOR *pos)
     int32_t anim_angle = -_snap_angle(player->angle);
     uint8_t show_character = (((player->iframes >> 2) % 2) == 0);
     uint8_t facing_left = (player->anim_dir < 0);
+
+    // Below the water surface, the character uses its underwater palette
+    uint16_t crecty = player->chara.crecty;
+    player->chara.crecty = water_clut_row_at(crecty, pos->vy >> 12);
     
     // if iframes, do not show for every 4 frames
     if(player->cur_anim && show_character) {
@@ -1960,6 +2000,7 @@ player_draw(Player *player, VECTOR *pos)
         /*                tail_angle); */
     }
 
+    player->chara.crecty = crecty;
     chara_draw_end(0);
 }
 
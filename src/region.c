@@ -0,0 +1,270 @@
+#include "region.h"
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include "util.h"
+#include "cdload.h"
+#include "memalloc.h"
+#include "screen.h"
+#include "sound.h"
+
+// Native format written by buildrgn.py. The header and region table always
+// fit within the first sector of the file
+typedef struct {
+    AssetHeader header;
+    uint16_t    num_regions;
+    uint16_t    region_width;   // In chunks
+    uint16_t    num_chunks;     // Chunks on the whole MAP128
+    uint16_t    max_chunks;     // Most chunks used by a single region
+    uint32_t    regions_offset; // RegionEntry[num_regions]
+} RegionFile;
+
+// Each region holds uint16_t ids[num_chunks] (padded to 4 bytes), followed
+// by the Frame128 data of each of these chunks
+typedef struct {
+    uint32_t offset;            // Sector-aligned
+    uint16_t num_chunks;
+    uint16_t _unused;
+} RegionEntry;
+
+typedef struct {
+    int16_t  region;            // -1 if empty
+    uint8_t  loaded;
+    uint8_t  *data;
+} RegionSlot;
+
+static struct {
+    uint8_t     active;
+    char        filename[64];
+    TileMap128  *map;
+    uint16_t    num_regions;
+    uint16_t    region_width;
+    uint32_t    slot_size;
+    RegionEntry *entries;
+    RegionSlot  slots[REGION_SLOTS];
+} _rgn = { 0 };
+
+static uint32_t
+_region_size(RegionEntry *entry)
+{
+    return ((entry->num_chunks * sizeof(uint16_t) + 3) & ~3)
+        + (entry->num_chunks * 64 * sizeof(Frame128));
+}
+
+static void
+_slot_apply(RegionSlot *slot)
+{
+    RegionEntry *entry = &_rgn.entries[slot->region];
+    uint16_t *ids = (uint16_t *)slot->data;
+    Frame128 *frames = (Frame128 *)(slot->data
+                                    + ((entry->num_chunks * 2 + 3) & ~3));
+    for(uint16_t i = 0; i < entry->num_chunks; i++)
+        _rgn.map->chunks[ids[i]] = &frames[i << 6];
+}
+
+static void
+_slot_evict(RegionSlot *slot)
+{
+    if(slot->loaded) {
+        RegionEntry *entry = &_rgn.entries[slot->region];
+        uint16_t *ids = (uint16_t *)slot->data;
+        uint8_t *end = slot->data + _rgn.slot_size;
+        for(uint16_t i = 0; i < entry->num_chunks; i++) {
+            uint8_t *ptr = (uint8_t *)_rgn.map->chunks[ids[i]];
+            if((ptr >= slot->data) && (ptr < end))
+                _rgn.map->chunks[ids[i]] = NULL;
+        }
+
+        // Chunks shared with other regions must remain visible
+        for(uint8_t i = 0; i < REGION_SLOTS; i++) {
+            RegionSlot *other = &_rgn.slots[i];
+            if((other != slot) && other->loaded) _slot_apply(other);
+        }
+    }
+    slot->region = -1;
+    slot->loaded = 0;
+}
+
+static void
+_region_chunk(uint8_t *data, uint32_t offset, uint32_t length,
+              uint8_t last, void *userdata)
+{
+    RegionSlot *slot = (RegionSlot *)userdata;
+    if(!data) {
+        // Leave the slot empty so that it is requested again
+        slot->region = -1;
+        return;
+    }
+
+    if(offset + length > _rgn.slot_size) length = _rgn.slot_size - offset;
+    memcpy(slot->data + offset, data, length);
+    if(last) {
+        slot->loaded = 1;
+        _slot_apply(slot);
+    }
+}
+
+static void
+_header_chunk(uint8_t *data, uint32_t offset, uint32_t length,
+              uint8_t last, void *userdata)
+{
+    (void)(last);
+    if(!data || (offset > 0)) return;
+    memcpy(userdata, data, MIN(length, 2048));
+}
+
+uint8_t
+region_init(TileMap128 *mapping, const char *filename)
+{
+    CdlFILE filepos;
+
+    region_unload();
+    if(!file_locate(filename, &filepos)) return 0;
+
+    // Every region crossing would pause CD-DA music for a read
+    if(sound_cdda_is_playing()) {
+        printf("CD-DA music is playing, not streaming %s\n", filename);
+        return 0;
+    }
+
+    // Only the first sector is needed to know how to stream the rest
+    uint8_t *bytes = screen_alloc_tagged(2048, ARENA_TAG_TILES);
+    bzero(bytes, 2048);
+    cdload_request_range(filename, 0, 2048, _header_chunk, bytes);
+    cdload_sync(NULL);
+
+    RegionFile *file = (RegionFile *)bytes;
+    if((strncmp(file->header.magic, REGION_MAGIC, 4) != 0)
+       || (file->header.version != REGION_VERSION)) {
+        printf("File %s is not a valid region file, ignoring\n", filename);
+        return 0;
+    }
+
+    strncpy(_rgn.filename, filename, sizeof(_rgn.filename) - 1);
+    _rgn.filename[sizeof(_rgn.filename) - 1] = '\0';
+    _rgn.map = mapping;
+    _rgn.num_regions = file->num_regions;
+    _rgn.region_width = file->region_width;
+    _rgn.entries = (RegionEntry *)(bytes + file->regions_offset);
+    _rgn.slot_size = ((file->max_chunks * sizeof(uint16_t) + 3) & ~3)
+        + (file->max_chunks * 64 * sizeof(Frame128));
+
+    // Chunks only become visible once the region holding them is loaded
+    mapping->tile_width = 128;
+    mapping->num_tiles = file->num_chunks;
+    mapping->frame_side = 8;
+    mapping->frames = NULL;
+    mapping->chunks = screen_alloc_tagged(
+        file->num_chunks * sizeof(Frame128 *), ARENA_TAG_TILES);
+    bzero(mapping->chunks, file->num_chunks * sizeof(Frame128 *));
+
+    for(uint8_t i = 0; i < REGION_SLOTS; i++) {
+        _rgn.slots[i].region = -1;
+        _rgn.slots[i].loaded = 0;
+        _rgn.slots[i].data = screen_alloc_tagged(_rgn.slot_size, ARENA_TAG_TILES);
+    }
+
+    printf("Streaming %d regions of %d chunks (%d bytes resident)\n",
+           _rgn.num_regions, _rgn.region_width,
+           _rgn.slot_size * REGION_SLOTS);
+    _rgn.active = 1;
+    sound_cdda_set_blocked(1);
+    return 1;
+}
+
+static RegionSlot *
+_find_slot(int16_t region)
+{
+    for(uint8_t i = 0; i < REGION_SLOTS; i++)
+        if(_rgn.slots[i].region == region) return &_rgn.slots[i];
+    return NULL;
+}
+
+static RegionSlot *
+_free_slot(int16_t *wanted)
+{
+    RegionSlot *slot = _find_slot(-1);
+    if(slot) return slot;
+
+    // Evict a loaded region which is no longer wanted. Regions still being
+    // read are never evicted, since their data is yet to arrive
+    for(uint8_t i = 0; i < REGION_SLOTS; i++) {
+        slot = &_rgn.slots[i];
+        if(!slot->loaded) continue;
+        uint8_t keep = 0;
+        for(uint8_t w = 0; w < REGION_SLOTS; w++)
+            if(wanted[w] == slot->region) keep = 1;
+        if(!keep) return slot;
+    }
+    return NULL;
+}
+
+static RegionSlot *
+_request_region(int16_t region, int16_t *wanted)
+{
+    RegionSlot *slot = _free_slot(wanted);
+    if(!slot) return NULL;
+    _slot_evict(slot);
+
+    RegionEntry *entry = &_rgn.entries[region];
+    slot->region = region;
+    if(!cdload_request_range(_rgn.filename, entry->offset,
+                             _region_size(entry), _region_chunk, slot)) {
+        slot->region = -1;
+        return NULL;
+    }
+    return slot;
+}
+
+void
+region_update(int32_t cam_x, uint8_t wait)
+{
+    if(!_rgn.active) return;
+
+    int32_t cur = (cam_x >> 7) / _rgn.region_width;
+    cur = CLAMP(cur, 0, _rgn.num_regions - 1);
+
+    // Regions around the camera, in order of priority
+    int16_t wanted[REGION_SLOTS] = { cur, cur + 1, cur - 1 };
+    for(uint8_t w = 0; w < REGION_SLOTS; w++) {
+        int16_t region = wanted[w];
+        if((region < 0) || (region >= _rgn.num_regions)) continue;
+        if(_find_slot(region)) continue;
+        if(!_request_region(region, wanted)) break;
+    }
+
+    if(wait) {
+        cdload_sync(NULL);
+        return;
+    }
+
+    // The camera's own region must be there before anything uses it.
+    // If streaming could not keep up, stall until that region arrives.
+    // Whatever was queued after it is left for later frames
+    RegionSlot *slot = _find_slot(cur);
+    if(slot && slot->loaded) {
+        cdload_process();
+        return;
+    }
+    uint8_t retried = 0;
+    while(cdload_process()) {
+        slot = _find_slot(cur);
+        // A failed read leaves the slot empty, so ask for it once more
+        if(!slot && !retried) {
+            slot = _request_region(cur, wanted);
+            retried = 1;
+        }
+        if(slot && slot->loaded) break;
+    }
+}
+
+void
+region_unload()
+{
+    if(_rgn.active) {
+        // Pending reads would otherwise land on freed scene memory
+        cdload_sync(NULL);
+        sound_cdda_set_blocked(0);
+    }
+    _rgn.active = 0;
+}
@@ -1,10 +1,18 @@
 #include "render.h"
+#include "memalloc.h"
+#include "screen.h"
 #include <assert.h>
 #include <psxgte.h>
 #include <inline_c.h>
 
 RenderContext ctx;
 
+static uint32_t _ot_2d[2][OT_LENGTH_2D];
+
+#ifdef RENDER_PIPELINED
+static void _vblank_present();
+#endif
+
 void
 setup_context()
 {
@@ -32,7 +40,10 @@ setup_context()
     // drawing.
     ctx.active_buffer = 0;
     ctx.next_packet   = ctx.buffers[0].buffer;
-    ClearOTagR(ctx.buffers[0].ot, OT_LENGTH);
+    ctx.buffers[0].ot = _ot_2d[0];
+    ctx.buffers[1].ot = _ot_2d[1];
+    ctx.ot_length     = OT_LENGTH_2D;
+    ClearOTagR(ctx.buffers[0].ot, ctx.ot_length);
 
     // Initialize and setup the GTE geometry offsets
     InitGeom();
@@ -44,11 +55,18 @@ setup_context()
 
     // Clear the screen with a black rectangle so we don't see the PSX logo!
     force_clear();
+
+#ifdef RENDER_PIPELINED
+    // Frames are presented from now on as soon as vblank comes
+    VSyncCallback(_vblank_present);
+#endif
 }
 
 void
 force_clear()
 {
+    // Nothing may be pending presentation while this draws synchronously
+    render_sync();
     for(int i = 0; i < 2; i++) {
         POLY_F4 *poly = (POLY_F4 *)get_next_prim();
         setPolyF4(poly);
@@ -59,7 +77,7 @@ force_clear()
 
         /* DrawOTagEnv(&ctx.buffers[ctx.active_buffer].ot[OT_LENGTH - 1], */
         /*             &ctx.buffers[ctx.active_buffer].draw_env); */
-        DrawOTag(&ctx.buffers[ctx.active_buffer].ot[OT_LENGTH - 1]);
+        DrawOTag(&ctx.buffers[ctx.active_buffer].ot[ctx.ot_length - 1]);
         PutDrawEnv(&ctx.buffers[ctx.active_buffer].draw_env);
         PutDispEnv(&ctx.buffers[ctx.active_buffer].disp_env);
 
@@ -68,7 +86,7 @@ force_clear()
 
         ctx.active_buffer ^= 1;
         ctx.next_packet    = ctx.buffers[ctx.active_buffer].buffer;
-        ClearOTagR(ctx.buffers[ctx.active_buffer].ot, OT_LENGTH);
+        ClearOTagR(ctx.buffers[ctx.active_buffer].ot, ctx.ot_length);
         ClearOTagR(ctx.buffers[ctx.active_buffer].sub_ot, SUB_OT_LENGTH);
     }
 }
@@ -80,25 +98,93 @@ set_clear_color(uint8_t r, uint8_t g, uint8_t b)
     setRGB0(&(ctx.buffers[1].draw_env), r, g, b);
 }
 
+#ifdef RENDER_PIPELINED
+// Buffer whose frame is waiting for the next vblank to be presented, or -1
+static volatile int8_t _present_buffer = -1;
+
+static void
+_vblank_present()
+{
+    if(_present_buffer < 0) return;
+    // The frame before it must be done drawing before it can be displayed
+    if(DrawSync(1) > 0) return;
+
+    RenderBuffer *draw_buffer = &ctx.buffers[_present_buffer];
+    RenderBuffer *disp_buffer = &ctx.buffers[_present_buffer ^ 1];
+    PutDrawEnv(&draw_buffer->draw_env);
+    PutDispEnv(&disp_buffer->disp_env);
+    DrawOTag(&draw_buffer->ot[ctx.ot_length - 1]);
+    _present_buffer = -1;
+}
+#endif
+
+void
+render_sync()
+{
+#ifdef RENDER_PIPELINED
+    // Wait for the handed over frame to be presented
+    while(_present_buffer >= 0);
+#endif
+    DrawSync(0);
+}
+
+void
+render_set_ot_length(uint16_t length)
+{
+    // Neither OT may be in use by the GPU while they are replaced
+    render_sync();
+    if(length <= OT_LENGTH_2D) {
+        length = OT_LENGTH_2D;
+        ctx.buffers[0].ot = _ot_2d[0];
+        ctx.buffers[1].ot = _ot_2d[1];
+    } else {
+        // Only valid until the scene is disposed of
+        ctx.buffers[0].ot = screen_alloc(length * sizeof(uint32_t));
+        ctx.buffers[1].ot = screen_alloc(length * sizeof(uint32_t));
+    }
+    ctx.ot_length = length;
+    ClearOTagR(ctx.buffers[ctx.active_buffer].ot, length);
+}
+
+int
+render_get_buffer_index()
+{
+    return ctx.active_buffer;
+}
+
+uint16_t
+render_get_ot_length()
+{
+    return ctx.ot_length;
+}
+
 void
 swap_buffers()
 {
+    RenderBuffer *disp_buffer = &ctx.buffers[ctx.active_buffer ^ 1];
+    sort_sub_ot();
+
+#ifdef RENDER_PIPELINED
+    // The other buffer is about to be reused, so the frame built on it
+    // must have been presented and drawn. Then hand this one over, and
+    // leave it to the vblank handler to display and draw it
+    render_sync();
+    _present_buffer = ctx.active_buffer;
+#else
     // Wait for the GPU to finish drawing, then wait for vblank in order to
     // prevent screen tearing.
     DrawSync(0);
 
     VSync(0);
 
-    RenderBuffer *draw_buffer = &ctx.buffers[ctx.active_buffer];
-    RenderBuffer *disp_buffer = &ctx.buffers[ctx.active_buffer ^ 1];
-
     // Display the framebuffer the GPU has just finished drawing and start
     // rendering the display list that was filled up in the main loop.
+    RenderBuffer *draw_buffer = &ctx.buffers[ctx.active_buffer];
     PutDrawEnv(&draw_buffer->draw_env);
     PutDispEnv(&disp_buffer->disp_env);
     /* DrawOTagEnv(&draw_buffer->ot[OT_LENGTH - 1], &draw_buffer->draw_env); */
-    sort_sub_ot();
-    DrawOTag(&draw_buffer->ot[OT_LENGTH - 1]);
+    DrawOTag(&draw_buffer->ot[ctx.ot_length - 1]);
+#endif
 
     SetDispMask(1);
 
@@ -107,8 +193,11 @@ swap_buffers()
     ctx.active_buffer ^= 1;
     ctx.next_packet    = disp_buffer->buffer;
 
-    ClearOTagR(disp_buffer->ot, OT_LENGTH);
+    ClearOTagR(disp_buffer->ot, ctx.ot_length);
     ClearOTagR(disp_buffer->sub_ot, SUB_OT_LENGTH);
+
+    // Per-frame scratch data does not survive past this point
+    fastalloc_free();
 }
 
 void *
@@ -123,11 +212,18 @@ increment_prim(uint32_t size)
     ctx.next_packet += size;
 }
 
+uint32_t
+render_get_packet_usage()
+{
+    return ctx.next_packet - ctx.buffers[ctx.active_buffer].buffer;
+}
+
 void
 sort_prim(void *prim, uint32_t otz)
 {
     // Place the primitive after all previously allocated primitives, then
     // insert it into the OT and bump the allocation pointer.
+    assert(otz < ctx.ot_length);
     AddPrim(get_ot_at(otz), (uint8_t *) prim);
 
     // Make sure we haven't yet run out of space for future primitives.
@@ -145,7 +241,7 @@ void
 sort_sub_ot()
 {
     RenderBuffer *buffer = &ctx.buffers[ctx.active_buffer];
-    addPrims(&buffer->ot, &buffer->sub_ot[SUB_OT_LENGTH-1], &buffer->sub_ot);
+    addPrims(buffer->ot, &buffer->sub_ot[SUB_OT_LENGTH-1], &buffer->sub_ot);
 }
 
 uint32_t *
@@ -8,7 +8,10 @@
 
 #include "render.h"
 #include "memalloc.h"
+#include "cache.h"
+#include "vram.h"
 #include "util.h"
+#include "timer.h"
 
 #include "screens/disclaimer.h"
 #include "screens/levelselect.h"
@@ -25,8 +28,12 @@
 //#define SCREEN_BUFFER_LEN 122880
 #define SCREEN_BUFFER_LEN 319488
 
+extern int debug_mode;
+
 static int8_t current_scene = -1;
-static uint8_t *scene_data[SCREEN_BUFFER_LEN] = { 0 };
+static uint8_t scene_has_data = 0;
+static uint8_t scene_changed = 0;
+static uint8_t scene_data[SCREEN_BUFFER_LEN] = { 0 };
 static ArenaAllocator screen_arena;
 static uint8_t loading_logo[9050] = { 0 };// Image has 9034 bytes, should be enough
 
@@ -35,6 +42,7 @@ scene_init()
 {
     uint32_t length;
     alloc_arena_init(&screen_arena, scene_data, SCREEN_BUFFER_LEN);
+    alloc_arena_push(&screen_arena, ARENA_SCOPE_SCENE);
     uint8_t *file = file_read("\\MISC\\LOAD.TIM;1", &length);
     assert(length < 9050);
     memcpy(loading_logo, file, length);
@@ -68,6 +76,20 @@ scene_change(ScreenIndex scr)
         scene_unload();
     current_scene = scr;
     scene_load();
+
+    // Time spent loading should not be caught up with
+    timer_reset_steps();
+    scene_changed = 1;
+}
+
+// Tells whether a scene change happened since the last call. Steps left
+// over from the previous scene must not be run on the new one
+uint8_t
+scene_was_changed()
+{
+    uint8_t changed = scene_changed;
+    scene_changed = 0;
+    return changed;
 }
 
 void
@@ -92,16 +114,16 @@ void
 scene_unload()
 {
     switch(current_scene) {
-    case SCREEN_DISCLAIMER:  screen_disclaimer_unload(scene_data);  break;
-    case SCREEN_LEVELSELECT: screen_levelselect_unload(scene_data); break;
-    case SCREEN_LEVEL:       screen_level_unload(scene_data);       break;
-    case SCREEN_TITLE:       screen_title_unload(scene_data);       break;
-    case SCREEN_MODELTEST:   screen_modeltest_unload(scene_data);   break;
-    case SCREEN_SLIDE:       screen_slide_unload(scene_data);       break;
-    case SCREEN_CREDITS:     screen_credits_unload(scene_data);     break;
-    case SCREEN_SPRITETEST:  screen_sprite_test_unload(scene_data); break;
-    case SCREEN_CHARSELECT:  screen_charselect_unload(scene_data);  break;
-    case SCREEN_OPTIONS:     screen_options_unload(scene_data);     break;
+    case SCREEN_DISCLAIMER:  screen_disclaimer_unload(screen_get_data());  break;
+    case SCREEN_LEVELSELECT: screen_levelselect_unload(screen_get_data()); break;
+    case SCREEN_LEVEL:       screen_level_unload(screen_get_data());       break;
+    case SCREEN_TITLE:       screen_title_unload(screen_get_data());       break;
+    case SCREEN_MODELTEST:   screen_modeltest_unload(screen_get_data());   break;
+    case SCREEN_SLIDE:       screen_slide_unload(screen_get_data());       break;
+    case SCREEN_CREDITS:     screen_credits_unload(screen_get_data());     break;
+    case SCREEN_SPRITETEST:  screen_sprite_test_unload(screen_get_data()); break;
+    case SCREEN_CHARSELECT:  screen_charselect_unload(screen_get_data());  break;
+    case SCREEN_OPTIONS:     screen_options_unload(screen_get_data());     break;
     default: break; // Unknown scene???
     }
 }
@@ -110,16 +132,16 @@ void
 scene_update()
 {
     switch(current_scene) {
-    case SCREEN_DISCLAIMER:  screen_disclaimer_update(scene_data);  break;
-    case SCREEN_LEVELSELECT: screen_levelselect_update(scene_data); break;
-    case SCREEN_LEVEL:       screen_level_update(scene_data);       break;
-    case SCREEN_TITLE:       screen_title_update(scene_data);       break;
-    case SCREEN_MODELTEST:   screen_modeltest_update(scene_data);   break;
-    case SCREEN_SLIDE:       screen_slide_update(scene_data);       break;
-    case SCREEN_CREDITS:     screen_credits_update(scene_data);     break;
-    case SCREEN_SPRITETEST:  screen_sprite_test_update(scene_data); break;
-    case SCREEN_CHARSELECT:  screen_charselect_update(scene_data);  break;
-    case SCREEN_OPTIONS:     screen_options_update(scene_data);     break;
+    case SCREEN_DISCLAIMER:  screen_disclaimer_update(screen_get_data());  break;
+    case SCREEN_LEVELSELECT: screen_levelselect_update(screen_get_data()); break;
+    case SCREEN_LEVEL:       screen_level_update(screen_get_data());       break;
+    case SCREEN_TITLE:       screen_title_update(screen_get_data());       break;
+    case SCREEN_MODELTEST:   screen_modeltest_update(screen_get_data());   break;
+    case SCREEN_SLIDE:       screen_slide_update(screen_get_data());       break;
+    case SCREEN_CREDITS:     screen_credits_update(screen_get_data());     break;
+    case SCREEN_SPRITETEST:  screen_sprite_test_update(screen_get_data()); break;
+    case SCREEN_CHARSELECT:  screen_charselect_update(screen_get_data());  break;
+    case SCREEN_OPTIONS:     screen_options_update(screen_get_data());     break;
     default: break; // Unknown scene???
     }
 }
@@ -129,16 +151,16 @@ void
 scene_draw()
 {
     switch(current_scene) {
-    case SCREEN_DISCLAIMER:  screen_disclaimer_draw(scene_data);  break;
-    case SCREEN_LEVELSELECT: screen_levelselect_draw(scene_data); break;
-    case SCREEN_LEVEL:       screen_level_draw(scene_data);       break;
-    case SCREEN_TITLE:       screen_title_draw(scene_data);       break;
-    case SCREEN_MODELTEST:   screen_modeltest_draw(scene_data);   break;
-    case SCREEN_SLIDE:       screen_slide_draw(scene_data);       break;
-    case SCREEN_CREDITS:     screen_credits_draw(scene_data);     break;
-    case SCREEN_SPRITETEST:  screen_sprite_test_draw(scene_data); break;
-    case SCREEN_CHARSELECT:  screen_charselect_draw(scene_data);  break;
-    case SCREEN_OPTIONS:     screen_options_draw(scene_data);     break;
+    case SCREEN_DISCLAIMER:  screen_disclaimer_draw(screen_get_data());  break;
+    case SCREEN_LEVELSELECT: screen_levelselect_draw(screen_get_data()); break;
+    case SCREEN_LEVEL:       screen_level_draw(screen_get_data());       break;
+    case SCREEN_TITLE:       screen_title_draw(screen_get_data());       break;
+    case SCREEN_MODELTEST:   screen_modeltest_draw(screen_get_data());   break;
+    case SCREEN_SLIDE:       screen_slide_draw(screen_get_data());       break;
+    case SCREEN_CREDITS:     screen_credits_draw(screen_get_data());     break;
+    case SCREEN_SPRITETEST:  screen_sprite_test_draw(screen_get_data()); break;
+    case SCREEN_CHARSELECT:  screen_charselect_draw(screen_get_data());  break;
+    case SCREEN_OPTIONS:     screen_options_draw(screen_get_data());     break;
     default: break; // Unknown scene???
     }
 }
@@ -147,18 +169,57 @@ scene_draw()
 void *
 screen_alloc(uint32_t size)
 {
-    void *ptr = alloc_arena_malloc(&screen_arena, size);
+    return screen_alloc_tagged(size, ARENA_TAG_MISC);
+}
+
+// screen_get_data finds the scene data at the start of the scene scope, so
+// it must be the very first allocation of every scene
+void *
+screen_alloc_data(uint32_t size)
+{
+    assert(screen_arena.scope == ARENA_SCOPE_SCENE);
+    assert(alloc_arena_bytes_scope(&screen_arena, ARENA_SCOPE_SCENE) == 0);
+    scene_has_data = 1;
+    return screen_alloc(size);
+}
+
+void *
+screen_alloc_tagged(uint32_t size, ArenaTag tag)
+{
+    void *ptr = alloc_arena_malloc_tagged(&screen_arena, size, tag);
     bzero(ptr, size);
     return ptr;
 }
 
+void
+screen_push_scope(ArenaScope scope)
+{
+    alloc_arena_push(&screen_arena, scope);
+}
+
+void
+screen_pop_scope(ArenaScope scope)
+{
+    alloc_arena_pop(&screen_arena, scope);
+}
+
 void
 screen_free()
 {
     printf("Scene: Disposing of %u / %u bytes\n",
            alloc_arena_bytes_used(&screen_arena),
            alloc_arena_bytes_free(&screen_arena));
-    alloc_arena_free(&screen_arena);
+    if(debug_mode) screen_debrief();
+    // The OT may have been taken from the scene arena
+    render_set_ot_length(OT_LENGTH_2D);
+    // Scenes pop any inner scopes they pushed before getting here. Discard
+    // the scene scope, then reopen it for the next scene
+    assert(screen_arena.scope == ARENA_SCOPE_SCENE);
+    alloc_arena_pop(&screen_arena, ARENA_SCOPE_SCENE);
+    alloc_arena_push(&screen_arena, ARENA_SCOPE_SCENE);
+    scene_has_data = 0;
+    // Persistent VRAM areas stay put, so cached textures may be reused
+    vram_free_scene();
 }
 
 void
@@ -174,10 +235,24 @@ screen_debrief()
            screen_arena.size,
            alloc_arena_bytes_used(&screen_arena),
            alloc_arena_bytes_free(&screen_arena));
+    for(int i = 0; i < ARENA_TAG_MAX; i++) {
+        printf("  Tag %-10s %7u bytes\n",
+               alloc_arena_tag_name(i),
+               alloc_arena_bytes_tagged(&screen_arena, i));
+    }
+    for(int i = 0; i < ARENA_SCOPE_MAX; i++) {
+        printf("  Scope %-10s %7u bytes\n",
+               alloc_arena_scope_name(i),
+               alloc_arena_bytes_scope(&screen_arena, i));
+    }
+    cache_debrief();
+    vram_debrief();
 }
 
 void *
 screen_get_data()
 {
-    return scene_data;
+    // Scene data is always the first allocation within the scene scope
+    assert(scene_has_data);
+    return alloc_arena_scope_start(&screen_arena, ARENA_SCOPE_SCENE);
 }
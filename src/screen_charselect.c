@@ -60,7 +60,7 @@ _calculate_positions(screen_charselect_data *data)
 void
 screen_charselect_load()
 {
-    screen_charselect_data *data = screen_alloc(sizeof(screen_charselect_data));
+    screen_charselect_data *data = screen_alloc_data(sizeof(screen_charselect_data));
     data->character = screen_level_getcharacter();
     data->alpha_speed = 0;
     data->char_angles[0] = 0x0000;
@@ -72,16 +72,18 @@ screen_charselect_load()
 
     uint32_t length;
     TIM_IMAGE tim;
+    texture_batch_begin();
     uint8_t *img = file_read("\\MISC\\LVLSEL.TIM;1", &length);
     load_texture(img, &tim);
     data->bg_mode = tim.mode;
     data->bg_prect_x = tim.prect->x;
     data->bg_prect_y = tim.prect->y;
-    free(img);
+    texture_batch_free(img);
 
     img = file_read("\\MISC\\CHARAS.TIM;1", &length);
     load_texture(img, &tim);
-    free(img);
+    texture_batch_free(img);
+    texture_batch_end();
 
     data->bg_frame = 0;
     data->bg_state = 0;
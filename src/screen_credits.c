@@ -192,24 +192,32 @@ static const char *creditstxt[] = {
 
 #define SLIDE_FRAMES 128
 #define FADE_FRAMES   64
+#define PAGE_LINES    12
 
 typedef struct {
     uint8_t entry;
     uint8_t fade;
     int16_t countdown;
     uint8_t state;
+
+    // Lines of the current page, baked once when the page changes
+    int16_t  baked_entry;
+    uint8_t  num_lines;
+    FontText lines[PAGE_LINES];
 } screen_credits_data;
 
 void
 screen_credits_load()
 {
-    screen_credits_data *data = screen_alloc(sizeof(screen_credits_data));
+    screen_credits_data *data = screen_alloc_data(sizeof(screen_credits_data));
     set_clear_color(0, 0, 0);
 
     data->entry = 0;
     data->fade = 0;
     data->countdown = FADE_FRAMES;
     data->state = 0;
+    data->baked_entry = -1;
+    data->num_lines = 0;
 
     sound_bgm_play(BGM_CREDITS);
 }
@@ -293,39 +301,26 @@ screen_credits_draw(void *d)
 
     // Get current text
     const char **window = &creditstxt[data->entry];
-    if(*window != NULL) {
-        // Calculate height and vy
-        const char **cursor = window;
-        uint16_t height = 0;
-        while((*cursor)[0] != '\r') {
-            cursor++;
-            height += GLYPH_WHITE_HEIGHT + GLYPH_GAP;
-        }
+    if(*window == NULL) return;
 
-        int16_t vy = CENTERY - (height >> 1);
-
-        // Render text line by line
-        cursor = window;
-        uint8_t is_first = 1;
-        while((*cursor)[0] != '\r') {
-            uint16_t width = font_measurew_big(*cursor);
-            int16_t vx = CENTERX - (width >> 1);
-            if(is_first) {
-                font_set_color(
-                    LERPC(data->fade, 128),
-                    LERPC(data->fade, 128),
-                    LERPC(data->fade, 0));
-            } else {
-                font_set_color(
-                    LERPC(data->fade, 128),
-                    LERPC(data->fade, 128),
-                    LERPC(data->fade, 128));
-            }
-            font_draw_big(*cursor, vx, vy);
+    if(data->baked_entry != data->entry) {
+        data->num_lines = 0;
+        while(((*window)[0] != '\r') && (data->num_lines < PAGE_LINES))
+            font_text_bake(&data->lines[data->num_lines++], FONT_BIG, *window++);
+        data->baked_entry = data->entry;
+    }
 
-            if(is_first) is_first = 0;
-            cursor++;
-            vy += GLYPH_WHITE_HEIGHT + GLYPH_GAP;
-        }
+    uint16_t height = data->num_lines * (GLYPH_WHITE_HEIGHT + GLYPH_GAP);
+    int16_t vy = CENTERY - (height >> 1);
+
+    // Render text line by line; first line is the page's title
+    for(uint8_t i = 0; i < data->num_lines; i++) {
+        FontText *line = &data->lines[i];
+        font_set_color(
+            LERPC(data->fade, 128),
+            LERPC(data->fade, 128),
+            LERPC(data->fade, (i == 0) ? 0 : 128));
+        font_text_draw(line, CENTERX - (line->width >> 1), vy);
+        vy += GLYPH_WHITE_HEIGHT + GLYPH_GAP;
     }
 }
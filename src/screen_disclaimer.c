@@ -24,7 +24,7 @@ typedef struct {
 void
 screen_disclaimer_load()
 {
-    screen_disclaimer_data *data = screen_alloc(sizeof(screen_disclaimer_data));
+    screen_disclaimer_data *data = screen_alloc_data(sizeof(screen_disclaimer_data));
     uint32_t length; // 153624 B
     data->disclaimer_bg = file_read("\\MISC\\DISK.TIM;1", &length);
     data->disclaimer_timer = 0;
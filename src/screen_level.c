@@ -13,12 +13,20 @@
 #include "sound.h"
 #include "input.h"
 #include "screen.h"
+#include "cache.h"
+#include "cdload.h"
+#include "vram.h"
+#include "region.h"
+#include "water.h"
+#include "levelanim.h"
+#include "budget.h"
 #include "level.h"
 #include "timer.h"
 #include "model.h"
 #include "object.h"
 #include "parallax.h"
 #include "basic_font.h"
+#include "textfmt.h"
 #include "demo.h"
 #include "boss.h"
 
@@ -33,6 +41,10 @@ extern SoundEffect sfx_event;
 static uint8_t level = 0;
 static PlayerCharacter level_character = CHARA_SONIC;
 
+// Set when the level could not be placed on VRAM. Nothing else is loaded,
+// and the level select is brought back on the first update
+static uint8_t level_load_failed = 0;
+
 #define LEVEL_BONUS_SPD 12
 #define ANIM_IDLE_TIMER_MAX 180 // Also defined in player.c
 #define ANIM_STOPPED 0x08cd0220 // Also defined in player.c
@@ -71,6 +83,7 @@ typedef struct {
     uint16_t   level_counter;
     uint8_t    boss_lock;
     uint8_t    ring_1up_mask;
+    uint8_t    next_prefetched;
 
     // Title card / End count variables
     uint8_t has_started;
@@ -90,16 +103,46 @@ typedef struct {
     uint8_t is_perfect;
     int16_t bonus_distance_threshold;
 
-    // Water overlay primitives
-    TILE     waterquad[2]; // Flat-shaded option
-    /* POLY_G4  waterquad[2]; // Gouraud-shaded option */
+    // Water surface primitives. What is below the surface is drawn with
+    // underwater palettes instead of being covered by an overlay
     POLY_FT4 wavequad[2][5];
     uint8_t  waterbuffer;
-    uint8_t  water_last_fade[2];
+
+    // Heads-up display. Values are only formatted again when they change
+    FontRun  hud_score_label;
+    FontRun  hud_time_label;
+    FontRun  hud_rings_label;
+    FontRun  hud_score;
+    FontRun  hud_time;
+    FontRun  hud_rings;
+    uint32_t hud_last_score;
+    uint32_t hud_last_seconds;
+    uint16_t hud_last_rings;
+
+    // Static texts, prebaked when the level (or title card) is prepared
+    FontText txt_paused[4];
+    FontText txt_tc_name;
+    FontText txt_tc_zone;
+    FontText txt_tc_act;
+    FontText txt_tc_game;
+    FontText txt_score_got;
+    FontText txt_score_through;
+    FontText txt_score_labels[4];
 } screen_level_data;
 
 // Forward function declarations
+typedef struct {
+    const char *name;
+    uint8_t    round;
+    uint8_t    act;
+    int32_t    water_y;
+} LevelInfo;
+
 static void level_load_player(PlayerCharacter character);
+static VramArea *level_vram_alloc(VramAreaId id, uint16_t w, uint16_t h,
+                                  uint8_t clut_rows, VramScope scope);
+static void level_get_info(uint8_t lvl, LevelInfo *info);
+static void level_prefetch_next();
 static void level_load_level(screen_level_data *);
 static void level_set_clearcolor();
 static void prepare_titlecard(screen_level_data *data);
@@ -107,7 +150,7 @@ static void prepare_titlecard(screen_level_data *data);
 void
 screen_level_load()
 {
-    screen_level_data *data = screen_alloc(sizeof(screen_level_data));
+    screen_level_data *data = screen_alloc_data(sizeof(screen_level_data));
     player = screen_alloc(sizeof(Player));
     camera = screen_alloc(sizeof(Camera));
     map16 = screen_alloc(sizeof(TileMap16));
@@ -122,15 +165,20 @@ screen_level_load()
     data->boss_lock = 0;
     data->ring_1up_mask = 0;
     data->has_started = 0;
+    data->next_prefetched = 0;
 
     camera_init(camera);
 
+    level_load_failed = 0;
     level_load_player(level_character);
+    if(level_load_failed) return;
 
     level_ring_max = 0;
     level_load_level(data);
+    if(level_load_failed) return;
 
     camera_set(camera, player->pos.vx, player->pos.vy);
+    region_update(camera->pos.vx >> 12, 1);
 
     reset_elapsed_frames();
     pause_elapsed_frames();
@@ -147,39 +195,40 @@ screen_level_load()
     data->is_perfect = 0;
     data->bonus_distance_threshold = SCREEN_XRES + CENTERX;
 
-    // Init water quads
+    // Init water quads. Waves are drawn from the common objects texture
+    VramArea *objarea = vram_get(VRAM_AREA_OBJ_COMMON);
     for(int i = 0; i < 2; i++) {
-        // Flat-shaded option
-        TILE *poly = &data->waterquad[i];
-        setTile(poly);
-        setSemiTrans(poly, 1);
-        setRGB0(poly, 0, 0, 0);
-        setXY0(poly, 0, 0);
-        setWH(poly, SCREEN_XRES, 0);
-
-        // Gouraud-shaded option
-        /* POLY_G4 *poly = &data->waterquad[i]; */
-        /* setPolyG4(poly); */
-        /* setSemiTrans(poly, 1); */
-        /* setRGB0(poly, 0, 0, 0); */
-        /* setRGB1(poly, 0, 0, 0); */
-        /* setRGB2(poly, 0, 0, 0); */
-        /* setRGB3(poly, 0, 0, 0); */
-        /* setXYWH(poly, 0, 0, SCREEN_XRES, 0); */
-
         for(int j = 0; j < 5; j++) {
             POLY_FT4 *tx = &data->wavequad[i][j];
             setPolyFT4(tx);
             setSemiTrans(tx, 1);
-            tx->tpage = getTPage(1, 0, 576, 0);
-            tx->clut = getClut(0, 481);
+            tx->tpage = getTPage(1, 0, objarea->prect.x, objarea->prect.y);
+            tx->clut = getClut(objarea->crect.x, objarea->crect.y);
             setRGB0(tx, 0, 0, 0);
             setXYWH(tx, j * 64, 0, 64, 9);
         }
     }
     data->waterbuffer = 0;
-    data->water_last_fade[0] = 0;
-    data->water_last_fade[1] = 0;
+
+    // Init HUD. Values start out invalid so they are formatted right away
+    font_run_init(&data->hud_score_label, 10, 10);
+    font_run_init(&data->hud_time_label,  10, 24);
+    font_run_init(&data->hud_rings_label, 10, 38);
+    font_run_set_text(&data->hud_score_label, "SCORE");
+    font_run_set_text(&data->hud_time_label,  "TIME");
+    font_run_set_text(&data->hud_rings_label, "RINGS");
+    font_run_init(&data->hud_score, 60, 10);
+    font_run_init(&data->hud_time,  54, 24);
+    font_run_init(&data->hud_rings, 60, 38);
+    data->hud_last_score = 0xffffffff;
+    data->hud_last_seconds = 0xffffffff;
+    data->hud_last_rings = 0xffff;
+
+    // Pause menu texts never change
+    font_text_bake(&data->txt_paused[0], FONT_BIG, "\awPaused\r");
+    font_text_bake(&data->txt_paused[1], FONT_SM,  "Continue\r");
+    font_text_bake(&data->txt_paused[2], FONT_SM,  "Restart\r");
+    font_text_bake(&data->txt_paused[3], FONT_SM,  "Quit\r");
 
     demo_init();
 
@@ -203,8 +252,12 @@ screen_level_unload(void *d)
 {
     (void)(d);
     level_fade = 0;
+    region_unload();
+    levelanim_unload();
     sound_cdda_stop();
     sound_reset_mem();
+    screen_pop_scope(ARENA_SCOPE_ACT);
+    screen_pop_scope(ARENA_SCOPE_LEVEL);
     screen_free();
 }
 
@@ -234,9 +287,33 @@ _calculate_level_bonus(screen_level_data *data)
 static void
 prepare_titlecard(screen_level_data *data)
 {
+    // Bake title card and score tally texts for this act
+    char buffer[20];
+    uint8_t act_number = (level == 3) ? 2 : level_act;
+    font_text_bake(&data->txt_tc_name, FONT_HG, data->level_name);
+    font_text_bake(&data->txt_tc_zone, FONT_HG, "ZONE");
+    snprintf(buffer, 5, "*%d", act_number + 1);
+    font_text_bake(&data->txt_tc_act, FONT_HG, buffer);
+    font_text_bake(&data->txt_tc_game, FONT_SM, "SONIC XA");
+
+    const char *ctxt = "";
+    switch(screen_level_getcharacter()) {
+    default:             ctxt = "\asSONIC\r";    break;
+    case CHARA_MILES:    ctxt = "\atTAILS\r";    break;
+    case CHARA_KNUCKLES: ctxt = "\akKNUCKLES\r"; break;
+    case CHARA_AMY:      ctxt = "\aaAMY\r"; break;
+    }
+    snprintf(buffer, 20, "%s GOT", ctxt);
+    font_text_bake(&data->txt_score_got, FONT_MD, buffer);
+    font_text_bake(&data->txt_score_through, FONT_MD, "THROUGH");
+    font_text_bake(&data->txt_score_labels[0], FONT_BIG, "\ayTIME BONUS\r");
+    font_text_bake(&data->txt_score_labels[1], FONT_BIG, "\ayRING BONUS\r");
+    font_text_bake(&data->txt_score_labels[2], FONT_BIG, "\ayPERFECT BONUS\r");
+    font_text_bake(&data->txt_score_labels[3], FONT_BIG, "\ayTOTAL\r");
+
     // Pre-calculate title card target X and Y positions
-    uint16_t wt = font_measurew_hg(data->level_name);
-    uint16_t wz = font_measurew_hg("ZONE");
+    uint16_t wt = data->txt_tc_name.width;
+    uint16_t wz = data->txt_tc_zone.width;
     uint16_t vx = CENTERX - (wt >> 1) + 20;
 
     data->tc_ribbon_tgt_y = 0;
@@ -272,6 +349,7 @@ screen_level_player_respawn()
     // Restore player
     player->pos = player->respawnpos;
     camera->pos = camera->realpos = player->respawnpos;
+    region_update(camera->pos.vx >> 12, 1);
     player->grnd = 0;
     player->anim_dir = 1;
     player->vel.vx = player->vel.vy = player->vel.vz = 0;
@@ -338,6 +416,12 @@ screen_level_update(void *d)
 {
     screen_level_data *data = (screen_level_data *)d;
 
+    if(level_load_failed) {
+        printf("Error: Level could not be loaded\n");
+        scene_change(SCREEN_LEVELSELECT);
+        return;
+    }
+
     // Debug mode cycling
 #ifdef ALLOW_DEBUG
     {
@@ -377,9 +461,8 @@ screen_level_update(void *d)
             MAX(data->bonus_distance_threshold - LEVEL_BONUS_SPD, 0);
 
         data->level_counter--;
-        if(data->level_counter == 0) {
+        if(data->level_counter == 0)
             data->level_transition = LEVEL_TRANS_SCORE_COUNT;
-        }
     } else if(data->level_transition == LEVEL_TRANS_SCORE_COUNT) {
         // If all counters are zero, move along
         if((data->time_bonus | data->ring_bonus | data->perfect_bonus) == 0) {
@@ -460,6 +543,17 @@ screen_level_update(void *d)
         }
     }
 
+    // Prefetch the next act while the tally runs. Reading pauses CD-DA, so
+    // it only starts once the level clear jingle has finished playing
+    if((data->level_transition >= LEVEL_TRANS_SCORE_COUNT)
+       && (data->level_transition <= LEVEL_TRANS_FADEOUT)) {
+        if(!data->next_prefetched && !sound_cdda_is_playing()) {
+            data->next_prefetched = 1;
+            level_prefetch_next();
+        }
+        cdload_process();
+    }
+
     // Manage title card depending on level transition
     {
         const uint16_t speed = 16;
@@ -587,6 +681,10 @@ screen_level_update(void *d)
         return;
     }
 
+    // Level art animations and parallax scrolling stop while paused
+    levelanim_update();
+    parallax_update(&data->parallax);
+
     if(debug_mode > 0) {
         // Create a little falling ring
         if(pad_pressed(PAD_TRIANGLE)) {
@@ -635,6 +733,8 @@ screen_level_update(void *d)
     }
 
     camera_update(camera, player);
+    region_update(camera->pos.vx >> 12, 0);
+    level_prefetch(camera->lookahead.vx, camera->lookahead.vy);
     update_obj_window(camera->pos.vx, camera->pos.vy, level_round);
     object_pool_update(level_round);
 
@@ -698,78 +798,7 @@ _screen_level_draw_water(screen_level_data *data)
         int32_t camera_bottom = camera->pos.vy + (CENTERY << 12);
 
         if(camera_bottom > level_water_y) {
-            int32_t water_vh = camera_bottom - level_water_y;
-            uint16_t water_rh = water_vh >> 12;
-            uint16_t water_h = MIN(water_rh, SCREEN_YRES);
-            int16_t water_y = MAX(0, SCREEN_YRES - water_h);
-            int16_t water_ry = SCREEN_YRES - water_rh;
-
-            // Draw water overlay
-            {
-                /* GOURAUD SHADE */
-                /* POLY_G4 *poly = get_next_prim(); */
-                /* increment_prim(sizeof(POLY_G4)); */
-                /* setPolyG4(poly); */
-                /* setXYWH(poly, 0, water_y, SCREEN_XRES, water_h); */
-                /* setSemiTrans(poly, 1); */
-                /* setRGB0(poly, */
-                /*         LERPC(level_fade, 0), */
-                /*         LERPC(level_fade, 0), */
-                /*         LERPC(level_fade, 0xb8)); */
-                /* setRGB1(poly, */
-                /*         LERPC(level_fade, 0), */
-                /*         LERPC(level_fade, 0), */
-                /*         LERPC(level_fade, 0xb8)); */
-                /* setRGB2(poly, */
-                /*         LERPC(level_fade, 0), */
-                /*         LERPC(level_fade, 0), */
-                /*         LERPC(level_fade, 0x18)); */
-                /* setRGB3(poly, */
-                /*         LERPC(level_fade, 0), */
-                /*         LERPC(level_fade, 0), */
-                /*         LERPC(level_fade, 0x18)); */
-                /* sort_prim(poly, OTZ_LAYER_LEVEL_FG_FRONT); */
-
-                /* GOURAUD SHADE, STATIC BUFFERS */
-                /* POLY_G4 *poly = &data->waterquad[data->waterbuffer]; */
-                /* setXYWH(poly, 0, water_y, SCREEN_XRES, water_h); */
-                /* if(data->water_last_fade[data->waterbuffer] != level_fade) { */
-                /*     setRGB0(poly, */
-                /*             LERPC(level_fade, 0), */
-                /*             LERPC(level_fade, 0), */
-                /*             LERPC(level_fade, 0xb8)); */
-                /*     setRGB1(poly, */
-                /*             LERPC(level_fade, 0), */
-                /*             LERPC(level_fade, 0), */
-                /*             LERPC(level_fade, 0xb8)); */
-                /*     setRGB2(poly, */
-                /*             LERPC(level_fade, 0), */
-                /*             LERPC(level_fade, 0), */
-                /*             LERPC(level_fade, 0x18)); */
-                /*     setRGB3(poly, */
-                /*             LERPC(level_fade, 0), */
-                /*             LERPC(level_fade, 0), */
-                /*             LERPC(level_fade, 0x18)); */
-                /* } */
-                /* sort_prim(poly, OTZ_LAYER_LEVEL_FG_FRONT); */
-
-                /* FLAT SHADE, STATIC BUFFERS */
-                TILE *poly = &data->waterquad[data->waterbuffer];
-                poly->y0 = water_y;
-                poly->h = water_h;
-                if(data->water_last_fade[data->waterbuffer] != level_fade) {
-                    data->water_last_fade[data->waterbuffer] = level_fade;
-                    setRGB0(poly,
-                            LERPC(level_fade, 0),
-                            LERPC(level_fade, 0),
-                            LERPC(level_fade, 0x68));
-                    setRGB0(&data->waterquad[data->waterbuffer ^ 1],
-                            LERPC(level_fade, 0),
-                            LERPC(level_fade, 0),
-                            LERPC(level_fade, 0x68));
-                }
-                sort_prim(poly, OTZ_LAYER_LEVEL_FG_FRONT);
-            }
+            int16_t water_ry = water_line();
 
             // Draw water waves
             {
@@ -799,6 +828,7 @@ _screen_level_draw_water(screen_level_data *data)
                     poly->y2 = poly->y3 = water_ry - 6 + 9;
                     sort_prim(poly, OTZ_LAYER_LEVEL_FG_FRONT);
                 }
+                budget_count(BUDGET_WATER, 5);
             }
 
             // Flip buffers
@@ -808,16 +838,32 @@ _screen_level_draw_water(screen_level_data *data)
     }
 }
 
+static const char *
+_debug_cdir(CollMode dir)
+{
+    switch(dir) {
+    case CDIR_FLOOR:   return "FL";
+    case CDIR_RWALL:   return "RW";
+    case CDIR_LWALL:   return "LW";
+    case CDIR_CEILING: return "CE";
+    default:           return "  ";
+    }
+}
+
 void
 screen_level_draw(void *d)
 {
     screen_level_data *data = (screen_level_data *)d;
-    char buffer[120] = { 0 };
+    char buffer[120];
+
+    if(level_load_failed) return;
 
     // As a rule of thumb, things are drawn in specific otz's.
     // When things are drawn on the same otz, anything drawn first
     // is shown on front, as the ordering table is drawn backwards.
 
+    water_update(camera->pos.vy);
+    levelanim_flush();
     _screen_level_draw_water(data);
 
     // Draw player
@@ -838,8 +884,8 @@ screen_level_draw(void *d)
     render_lvl(camera->pos.vx, camera->pos.vy,
                level_round == 4); // Dawn Canyon: Draw in front
 
-    // Draw background and parallax
-    if(level_get_num_sprites() < 1312)
+    // Draw background and parallax, unless the level is over budget
+    if(budget_level() < BUDGET_LEVEL_NO_BACKGROUND)
         parallax_draw(&data->parallax, camera);
 
     // If we're in R4, draw a gradient on the background.
@@ -884,45 +930,30 @@ screen_level_draw(void *d)
 
     // Pause text
     if(paused && !debug_mode) {
-        const char *line1 = "\awPaused\r";
-        int16_t x = CENTERX - (font_measurew_big(line1) >> 1);
-        font_draw_big(line1, x, CENTERY - 28);
-
-        if(paused_selection == 0) font_set_color_yellow();
-        else                      font_reset_color();
-        line1 = "Continue\r";
-        x = CENTERX - (font_measurew_sm(line1) >> 1);
-        font_draw_sm(line1, x, CENTERY - 4);
-
-        if(paused_selection == 1) font_set_color_yellow();
-        else                      font_reset_color();
-        line1 = "Restart\r";
-        x = CENTERX - (font_measurew_sm(line1) >> 1);
-        font_draw_sm(line1, x, CENTERY + 4);
-
-        if(paused_selection == 2) font_set_color_yellow();
-        else font_reset_color();
-        line1 = "Quit\r";
-        x = CENTERX - (font_measurew_sm(line1) >> 1);
-        font_draw_sm(line1, x, CENTERY + 12);
+        FontText *txt = &data->txt_paused[0];
+        font_text_draw(txt, CENTERX - (txt->width >> 1), CENTERY - 28);
+
+        for(uint8_t i = 0; i < 3; i++) {
+            if(paused_selection == i) font_set_color_yellow();
+            else                      font_reset_color();
+            txt = &data->txt_paused[i + 1];
+            font_text_draw(txt, CENTERX - (txt->width >> 1), CENTERY - 4 + (i << 3));
+        }
     }
 
     // Title card
     if(data->level_transition <= LEVEL_TRANS_FADEIN) {
         font_reset_color();
-        font_draw_hg(data->level_name, data->tc_title_x, 70);
-        font_draw_hg("ZONE", data->tc_zone_x, 70 + GLYPH_HG_WHITE_HEIGHT + 5);
+        font_text_draw(&data->txt_tc_name, data->tc_title_x, 70);
+        font_text_draw(&data->txt_tc_zone, data->tc_zone_x, 70 + GLYPH_HG_WHITE_HEIGHT + 5);
 
         // ACT card
-        char buffer[5];
-        uint8_t act_number = (level == 3) ? 2 : level_act;
-        snprintf(buffer, 5, "*%d", act_number + 1);
-        font_draw_hg(buffer, data->tc_act_x, 70 + GLYPH_HG_WHITE_HEIGHT + 40);
+        font_text_draw(&data->txt_tc_act, data->tc_act_x, 70 + GLYPH_HG_WHITE_HEIGHT + 40);
 
         // Game text
         //font_set_color(0xc8, 0xc8, 0x00);
-        uint16_t wt = font_measurew_sm("SONIC XA");
-        font_draw_sm("SONIC XA", 50 + ((80 - wt) >> 1), data->tc_ribbon_y + 180);
+        uint16_t wt = data->txt_tc_game.width;
+        font_text_draw(&data->txt_tc_game, 50 + ((80 - wt) >> 1), data->tc_ribbon_y + 180);
         font_reset_color();
 
         // Title card ribbon background
@@ -971,31 +1002,23 @@ screen_level_draw(void *d)
         int16_t thrsh = data->bonus_distance_threshold;
 
         // TODO: Don't just display this! We gotta have a transition
+        // Labels were baked with the title card; only values are formatted
         char buffer[20];
-        const char *ctxt = "";
-        switch(screen_level_getcharacter()) {
-        default:             ctxt = "\asSONIC\r";    break;
-        case CHARA_MILES:    ctxt = "\atTAILS\r";    break;
-        case CHARA_KNUCKLES: ctxt = "\akKNUCKLES\r"; break;
-        case CHARA_AMY:      ctxt = "\aaAMY\r"; break;
-        }
-        snprintf(buffer, 20, "%s GOT", ctxt);
-
         const uint16_t text_base_y = 50;
 
-        // Measure first part
-        uint16_t textlen = font_measurew_md(buffer) >> 1;
-        font_draw_md(buffer, CENTERX - textlen - thrsh, text_base_y);
+        // First part
+        FontText *txt = &data->txt_score_got;
+        font_text_draw(txt, CENTERX - (txt->width >> 1) - thrsh, text_base_y);
 
-        // Measure second part
-        ctxt = "THROUGH";
-        textlen = font_measurew_md(ctxt) >> 1;
-        font_draw_md(ctxt, CENTERX - textlen + thrsh, text_base_y + GLYPH_MD_WHITE_HEIGHT);
+        // Second part
+        txt = &data->txt_score_through;
+        uint16_t textlen = txt->width >> 1;
+        font_text_draw(txt, CENTERX - textlen + thrsh, text_base_y + GLYPH_MD_WHITE_HEIGHT);
 
-        // Measure act
-        uint8_t act_number = (level == 3) ? 2 : level_act;
-        snprintf(buffer, 5, "*%d", act_number + 1);
-        font_draw_hg(buffer, CENTERX + textlen - (GLYPH_HG_WHITE_WIDTH >> 1) + thrsh, text_base_y + 20);
+        // Act
+        font_text_draw(&data->txt_tc_act,
+                       CENTERX + textlen - (GLYPH_HG_WHITE_WIDTH >> 1) + thrsh,
+                       text_base_y + 20);
 
         const uint16_t counters_base_y = CENTERY;
 
@@ -1003,39 +1026,26 @@ screen_level_draw(void *d)
         uint16_t cty = counters_base_y;
         uint16_t txtx = (CENTERX >> 1) + (CENTERX >> 3);
         uint16_t ctx = SCREEN_XRES - (CENTERX >> 1);
+        uint32_t values[] = {
+            data->time_bonus,
+            data->ring_bonus,
+            data->perfect_bonus,
+            data->total_bonus,
+        };
 
-        ctxt = "\ayTIME BONUS\r";
-        textlen = font_measurew_big(ctxt) >> 1;
-        font_draw_big(ctxt, txtx - textlen - thrsh, cty);
-        snprintf(buffer, 20, "\aw%d\r", data->time_bonus);
-        textlen = font_measurew_big(buffer);
-        font_draw_big(buffer, ctx - textlen + thrsh, cty);
-        cty += GLYPH_WHITE_HEIGHT + 2;
-
-        ctxt = "\ayRING BONUS\r";
-        textlen = font_measurew_big(ctxt) >> 1;
-        font_draw_big(ctxt, txtx - textlen - thrsh, cty);
-        snprintf(buffer, 20, "\aw%d\r", data->ring_bonus);
-        textlen = font_measurew_big(buffer);
-        font_draw_big(buffer, ctx - textlen + thrsh, cty);
-        cty += GLYPH_WHITE_HEIGHT + 2;
-
-        if(data->is_perfect) {
-            ctxt = "\ayPERFECT BONUS\r";
-            textlen = font_measurew_big(ctxt) >> 1;
-            font_draw_big(ctxt, txtx - textlen - thrsh, cty);
-            snprintf(buffer, 20, "\aw%d\r", data->perfect_bonus);
-            textlen = font_measurew_big(buffer);
-            font_draw_big(buffer, ctx - textlen + thrsh, cty);
+        for(uint8_t i = 0; i < 4; i++) {
+            // Perfect bonus keeps its line, even when not shown
+            if((i != 2) || data->is_perfect) {
+                txt = &data->txt_score_labels[i];
+                font_text_draw(txt, txtx - (txt->width >> 1) - thrsh, cty);
+                textfmt_str(textfmt_dec(textfmt_str(buffer, "\aw"),
+                                        values[i], 0, TEXTFMT_PAD_SPACE),
+                            "\r");
+                textlen = font_measurew_big(buffer);
+                font_draw_big(buffer, ctx - textlen + thrsh, cty);
+            }
+            cty += GLYPH_WHITE_HEIGHT + ((i == 2) ? 4 : 2);
         }
-        cty += GLYPH_WHITE_HEIGHT + 4;
-
-        ctxt = "\ayTOTAL\r";
-        textlen = font_measurew_big(ctxt) >> 1;
-        font_draw_big(ctxt, txtx - textlen - thrsh, cty);
-        snprintf(buffer, 20, "\aw%d\r", data->total_bonus);
-        textlen = font_measurew_big(buffer);
-        font_draw_big(buffer, ctx - textlen + thrsh, cty);
     }
 
     // Demo HUD. Only when playing AutoDemo!
@@ -1044,121 +1054,144 @@ screen_level_draw(void *d)
     /*     font_draw_logo(20, SCREEN_YRES - 65, 120, 45); */
     /* } */
 
-    // Heads-up display
+    // Heads-up display.
+    // Its sprites are retained across frames, and are only rebuilt when
+    // the text or color of each element changes
     if((debug_mode <= 1) && (level_mode != LEVEL_MODE_DEMO)) {
-        font_set_color(
-            LERPC(level_fade, 0xc8),
-            LERPC(level_fade, 0xc8),
-            0);
-        font_draw_big("SCORE", 10, 10);
-        font_draw_big("TIME",  10, 24);
+        uint8_t c = LERPC(level_fade, 0xc8);
+        font_run_set_color(&data->hud_score_label, c, c, 0);
+        font_run_set_color(&data->hud_time_label,  c, c, 0);
 
         // Flash red every 8 frames
         if(!elapsed_frames_paused()
            && (level_ring_count == 0)
            && ((get_elapsed_frames() >> 3) % 2 == 1)) {
-            font_set_color(
-                LERPC(level_fade, 0xc8),
-                0,
-                0);
-        } else {
-            font_set_color(
-                LERPC(level_fade, 0xc8),
-                LERPC(level_fade, 0xc8),
-                0);
-        }
-        font_draw_big("RINGS", 10, 38);
-        font_set_color(
-            LERPC(level_fade, 0xc8),
-            LERPC(level_fade, 0xc8),
-            LERPC(level_fade, 0xc8));
+            font_run_set_color(&data->hud_rings_label, c, 0, 0);
+        } else font_run_set_color(&data->hud_rings_label, c, c, 0);
 
-        snprintf(buffer, 120, "%8d", level_score_count);
-        font_draw_big(buffer, 60, 10);
+        font_run_set_color(&data->hud_score, c, c, c);
+        font_run_set_color(&data->hud_time,  c, c, c);
+        font_run_set_color(&data->hud_rings, c, c, c);
 
-        {
-            uint32_t seconds = get_elapsed_frames() / 60;
-            snprintf(buffer, 120, "%2d:%02d", seconds / 60, seconds % 60);
-            font_draw_big(buffer, 54, 24);
+        if(level_score_count != data->hud_last_score) {
+            data->hud_last_score = level_score_count;
+            textfmt_dec(data->hud_score.text, level_score_count,
+                        8, TEXTFMT_PAD_SPACE);
         }
 
-        snprintf(buffer, 120, "%3d", level_ring_count);
-        font_draw_big(buffer, 60, 38);
+        uint32_t seconds = get_elapsed_frames() / 60;
+        if(seconds != data->hud_last_seconds) {
+            data->hud_last_seconds = seconds;
+            textfmt_time(data->hud_time.text, seconds);
+        }
 
-        font_reset_color();
+        if(level_ring_count != data->hud_last_rings) {
+            data->hud_last_rings = level_ring_count;
+            textfmt_dec(data->hud_rings.text, level_ring_count,
+                        3, TEXTFMT_PAD_SPACE);
+        }
+
+        font_run_draw(&data->hud_score_label);
+        font_run_draw(&data->hud_time_label);
+        font_run_draw(&data->hud_rings_label);
+        font_run_draw(&data->hud_score);
+        font_run_draw(&data->hud_time);
+        font_run_draw(&data->hud_rings);
     }
 
     if(debug_mode) {
         font_set_color(0xc8, 0xc8, 0xc8);
 
+        // Formatted without snprintf, so that the overlay can be left on
+        // while profiling without skewing what is being measured
+
         // Video debug
-        snprintf(buffer, 120,
-                 "%4s %3d",
-                 GetVideoMode() == MODE_PAL ? "PAL" : "NTSC", get_frame_rate());
+        textfmt_dec(textfmt_str(buffer,
+                                GetVideoMode() == MODE_PAL ? " PAL " : "NTSC "),
+                    get_frame_rate(), 3, TEXTFMT_PAD_SPACE);
         font_draw_sm(buffer, 248, 12);
 
         // Free object debug
-        snprintf(buffer, 120, "SPR  %3d", object_pool_get_count());
+        textfmt_dec(textfmt_str(buffer, "SPR  "),
+                    object_pool_get_count(), 3, TEXTFMT_PAD_SPACE);
         font_draw_sm(buffer, 248, 20);
 
         // Rings, time and air for convenience
-        snprintf(buffer, 120, "RING %03d", level_ring_count);
+        textfmt_dec(textfmt_str(buffer, "RING "),
+                    level_ring_count, 3, TEXTFMT_PAD_ZERO);
         font_draw_sm(buffer, 248, 28);
 
-        snprintf(buffer, 120, "TIME %03d", (get_elapsed_frames() / 60));
+        textfmt_dec(textfmt_str(buffer, "TIME "),
+                    get_elapsed_frames() / 60, 3, TEXTFMT_PAD_ZERO);
         font_draw_sm(buffer, 248, 36);
 
-        snprintf(buffer, 120, "AIR   %02d", player->remaining_air_frames / 60);
+        textfmt_dec(textfmt_str(buffer, "AIR   "),
+                    player->remaining_air_frames / 60, 2, TEXTFMT_PAD_ZERO);
         font_draw_sm(buffer, 248, 44);
 
-        snprintf(buffer, 120, "TILE%4d", level_get_num_sprites());
+        textfmt_dec(textfmt_str(buffer, "TILE"),
+                    level_get_num_sprites(), 4, TEXTFMT_PAD_SPACE);
         font_draw_sm(buffer, 248, 52);
 
-        snprintf(buffer, 120, "FRA%5d", player->framecount);
+        textfmt_dec(textfmt_str(buffer, "FRA"),
+                    player->framecount, 5, TEXTFMT_PAD_SPACE);
         font_draw_sm(buffer, 248, 60);
 
-        snprintf(buffer, 120, "PFT %4d", level_ring_max);
+        textfmt_dec(textfmt_str(buffer, "PFT "),
+                    level_ring_max, 4, TEXTFMT_PAD_SPACE);
         font_draw_sm(buffer, 248, 68);
 
-        // Player debug
+        // Scratchpad hit rate for last frame's per-frame allocations
+        textfmt_dec(textfmt_str(buffer, "SCR "),
+                    fastalloc_hit_rate(), 3, TEXTFMT_PAD_SPACE);
+        font_draw_sm(buffer, 248, 76);
+
+        // Primitive budget load for last frame, and detail dropped
+        textfmt_dec(textfmt_str(buffer, "BGT "),
+                    budget_load(), 3, TEXTFMT_PAD_SPACE);
+        font_draw_sm(buffer, 248, 84);
+
+        textfmt_dec(textfmt_str(buffer, "LOD   "),
+                    budget_level(), 1, TEXTFMT_PAD_SPACE);
+        font_draw_sm(buffer, 248, 92);
+
+        // Player debug. Speeds are shown in pixels per step
         if(debug_mode > 1) {
-            snprintf(buffer, 255,
-                     "GSP %08x\n"
-                     "SPD %08x %08x\n"
-                     "ANG %08x G.P %s %s %3d\n"
-                     "POS %08x %08x\n"
-                     "ACT %02u\n"
-                     "GRN CEI %01u %01u\n"
-                     ,
-                     player->vel.vz,
-                     player->vel.vx, player->vel.vy,
-                     player->angle,
-                     (player->gsmode == CDIR_FLOOR)
-                     ? "FL"
-                     : (player->gsmode == CDIR_RWALL)
-                     ? "RW"
-                     : (player->gsmode == CDIR_LWALL)
-                     ? "LW"
-                     : (player->gsmode == CDIR_CEILING)
-                     ? "CE"
-                     : "  ",
-                     (player->psmode == CDIR_FLOOR)
-                     ? "FL"
-                     : (player->psmode == CDIR_RWALL)
-                     ? "RW"
-                     : (player->psmode == CDIR_LWALL)
-                     ? "LW"
-                     : (player->psmode == CDIR_CEILING)
-                     ? "CE"
-                     : "  ",
-                     (int32_t)(((int32_t)player->angle * (int32_t)(360 << 12)) >> 24), // angle in deg
-                     player->pos.vx, player->pos.vy,
-                     player->action,
-                     player->grnd, player->ceil
-                );
+            char *cur = buffer;
+            cur = textfmt_str(cur, "GSP ");
+            cur = textfmt_fixed(cur, player->vel.vz, 3, 9);
+            cur = textfmt_str(cur, "\nSPD ");
+            cur = textfmt_fixed(cur, player->vel.vx, 3, 9);
+            cur = textfmt_str(cur, " ");
+            cur = textfmt_fixed(cur, player->vel.vy, 3, 9);
+            cur = textfmt_str(cur, "\nANG ");
+            cur = textfmt_hex(cur, player->angle, 8);
+            cur = textfmt_str(cur, " G.P ");
+            cur = textfmt_str(cur, _debug_cdir(player->gsmode));
+            cur = textfmt_str(cur, " ");
+            cur = textfmt_str(cur, _debug_cdir(player->psmode));
+            cur = textfmt_str(cur, " ");
+            // Angle in degrees
+            cur = textfmt_dec(cur,
+                              ((int32_t)player->angle * (int32_t)(360 << 12)) >> 24,
+                              3, TEXTFMT_PAD_SPACE);
+            cur = textfmt_str(cur, "\nPOS ");
+            cur = textfmt_hex(cur, player->pos.vx, 8);
+            cur = textfmt_str(cur, " ");
+            cur = textfmt_hex(cur, player->pos.vy, 8);
+            cur = textfmt_str(cur, "\nACT ");
+            cur = textfmt_dec(cur, player->action, 2, TEXTFMT_PAD_ZERO);
+            cur = textfmt_str(cur, "\nGRN CEI ");
+            cur = textfmt_dec(cur, player->grnd, 1, TEXTFMT_PAD_ZERO);
+            cur = textfmt_str(cur, " ");
+            cur = textfmt_dec(cur, player->ceil, 1, TEXTFMT_PAD_ZERO);
+            textfmt_str(cur, "\n");
             font_draw_sm(buffer, 8, 12);
         }
     }
+
+    // Everything for this frame is on the packet buffer by now
+    budget_end_frame();
 }
 
 /* ============================== */
@@ -1201,87 +1234,107 @@ level_load_player(PlayerCharacter character)
     default: break;
     }
     
-    uint32_t filelength;
+    // Player sprites are kept in VRAM across scenes, unless overwritten
     TIM_IMAGE tim;
-    uint8_t *timfile = file_read(tim_file, &filelength);
-    if(timfile) {
-        load_texture(timfile, &tim);
-        free(timfile);
-    }
+    VramArea *area = level_vram_alloc(VRAM_AREA_PLAYER, 128, 512, 1,
+                                      VRAM_SCOPE_PERSISTENT);
+    if(!area) return;
+    cache_load_texture(tim_file, &tim, area);
 
     load_player(player, character, chara_file, &tim);
     player->startpos = (VECTOR){ 250 << 12, CENTERY << 12, 0 };
     player->pos = player->startpos;
 }
 
-static void
-level_load_level(screen_level_data *data)
+// Every area allocated for a level is drawn from unchecked afterwards, so
+// running out of VRAM must stop loading right away
+static VramArea *
+level_vram_alloc(VramAreaId id, uint16_t w, uint16_t h,
+                 uint8_t clut_rows, VramScope scope)
 {
-    paused = 0;
-    level_has_boss = 0;
+    VramArea *area = vram_alloc(id, w, h, clut_rows, scope);
+    if(!area) level_load_failed = 1;
+    return area;
+}
 
+static void
+level_get_info(uint8_t lvl, LevelInfo *info)
+{
+    info->name = "PLACEHOLDER";
     // Negative water means no water
-    level_water_y = -1;
+    info->water_y = -1;
 
-    data->level_name = "PLACEHOLDER";
-
-    switch(level) {
+    switch(lvl) {
     case 0: case 1: case 2: case 3: // Test level
-        data->level_name = "TEST LEVEL";
-        level_round = 0;
+        info->name = "TEST LEVEL";
+        info->round = 0;
         // Act 4 is Knuckles act 3
-        level_act = level;
-        if(level == 2) {
-            level_water_y = 0x00c43401;
+        info->act = lvl;
+        if(lvl == 2) {
+            info->water_y = 0x00c43401;
         }
         break;
     case 4: case 5:
-        data->level_name = "GREEN HILL";
-        level_round = 2;
-        level_act = level - 4;
+        info->name = "GREEN HILL";
+        info->round = 2;
+        info->act = lvl - 4;
         break;
     case 6: case 7:
-        data->level_name = "SURELY WOOD";
-        level_round = 3;
-        level_act = level - 6;
+        info->name = "SURELY WOOD";
+        info->round = 3;
+        info->act = lvl - 6;
         break;
     case 8: case 9:
-        data->level_name = "DAWN CANYON";
-        level_round = 4;
-        level_act = level - 8;
+        info->name = "DAWN CANYON";
+        info->round = 4;
+        info->act = lvl - 8;
         break;
     case 10: case 11:
-        data->level_name = "AMAZING OCEAN";
-        level_round = 5;
-        level_act = level - 10;
-        level_water_y = 0x002c0000;
+        info->name = "AMAZING OCEAN";
+        info->round = 5;
+        info->act = lvl - 10;
+        info->water_y = 0x002c0000;
         break;
     case 12: case 13:
-        /* data->level_name = "R6"; */
-        level_round = 6;
-        level_act = level - 12;
+        /* info->name = "R6"; */
+        info->round = 6;
+        info->act = lvl - 12;
         break;
     case 14: case 15:
-        /* data->level_name = "R7"; */
-        level_round = 7;
-        level_act = level - 14;
+        /* info->name = "R7"; */
+        info->round = 7;
+        info->act = lvl - 14;
         break;
     case 16: case 17: case 18:
-        data->level_name = "EGGMANLAND";
-        level_round = 8;
-        level_act = level - 16;
+        info->name = "EGGMANLAND";
+        info->round = 8;
+        info->act = lvl - 16;
         break;
     case 19:
-        data->level_name = "WINDMILL ISLE";
-        level_round = 9;
-        level_act = level - 19;
+        info->name = "WINDMILL ISLE";
+        info->round = 9;
+        info->act = lvl - 19;
         break;
     default:
-        data->level_name = "TEST LEVEL";
-        level_round = 0xff;
-        level_act = 0;
+        info->name = "TEST LEVEL";
+        info->round = 0xff;
+        info->act = 0;
         break;
     }
+}
+
+static void
+level_load_level(screen_level_data *data)
+{
+    paused = 0;
+    level_has_boss = 0;
+
+    LevelInfo info;
+    level_get_info(level, &info);
+    data->level_name = info.name;
+    level_round = info.round;
+    level_act = info.act;
+    level_water_y = info.water_y;
 
     char basepath[255];
     char filename0[255], filename1[255];
@@ -1293,67 +1346,65 @@ level_load_level(screen_level_data *data)
     TIM_IMAGE tim;
     uint32_t filelength;
 
+    // Read every file of this act in one go, if a pack is available
+    snprintf(filename0, 255, "%s\\Z%1u.PAK;1", basepath, level_act + 1);
+    printf("Loading %s...\n", filename0);
+    file_pack_mount(filename0);
+
 
 
-    /* === LEVEL TILES === */
-    // Load level tiles
+    /* === LEVEL TILES AND PARALLAX TEXTURES === */
+    // These are streamed straight into VRAM while the next chunk is read.
+    // Both backgrounds share an area, one texture page apart horizontally
+    // and with their CLUTs on consecutive rows
+    VramArea *area_tiles = level_vram_alloc(VRAM_AREA_TILES, 128, 256, 1,
+                                            VRAM_SCOPE_SCENE);
+    VramArea *area_bg = level_vram_alloc(VRAM_AREA_BG, 128, 256, 2,
+                                         VRAM_SCOPE_SCENE);
+    if(level_load_failed) return;
+    CdLoadTexture tex_tiles, tex_bg0, tex_bg1;
     snprintf(filename0, 255, "%s\\TILES.TIM;1", basepath);
     printf("Loading %s...\n", filename0);
-    uint8_t *timfile = file_read(filename0, &filelength);
-    if(timfile) {
-        load_texture(timfile, &tim);
-        leveldata->clutmode = tim.mode;
-        free(timfile);
+    cdload_texture_at(filename0, &tex_tiles, area_tiles, 0, 0, 0);
+    snprintf(filename0, 255, "%s\\BG0.TIM;1", basepath);
+    printf("Loading %s...\n", filename0);
+    cdload_texture_at(filename0, &tex_bg0, area_bg, 0, 0, 0);
+    snprintf(filename0, 255, "%s\\BG1.TIM;1", basepath);
+    printf("Loading %s...\n", filename0);
+    cdload_texture_at(filename0, &tex_bg1, area_bg, 64, 0, 1);
+    cdload_sync(NULL);
+
+    if(tex_tiles.loaded) {
+        leveldata->clutmode = tex_tiles.mode;
     } else {
         // If not single "TILES.TIM" was found, then perharps try a
         // "TILES0.TIM" and a "TILES1.TIM".
+        CdLoadTexture tex_tiles1;
         snprintf(filename0, 255, "%s\\TILES0.TIM;1", basepath);
         printf("Loading %s...\n", filename0);
-        timfile = file_read(filename0, &filelength);
-        if(timfile) {
-            load_texture(timfile, &tim);
-            leveldata->clutmode = tim.mode; // Use CLUT mode from 1st texture
-            free(timfile);
-        }
-
+        cdload_texture_at(filename0, &tex_tiles, area_tiles, 0, 0, 0);
         snprintf(filename0, 255, "%s\\TILES1.TIM;1", basepath);
         printf("Loading %s...\n", filename0);
-        timfile = file_read(filename0, &filelength);
-        if(timfile) {
-            load_texture(timfile, &tim);
-            free(timfile);
-        }
+        cdload_texture_at(filename0, &tex_tiles1, area_tiles, 64, 0, 0);
+        cdload_sync(NULL);
+        // Use CLUT mode from 1st texture
+        if(tex_tiles.loaded) leveldata->clutmode = tex_tiles.mode;
     }
 
-
-
-    /* === PARALLAX === */
-    // Load level parallax textures
-    snprintf(filename0, 255, "%s\\BG0.TIM;1", basepath);
-    printf("Loading %s...\n", filename0);
-    timfile = file_read(filename0, &filelength);
-    if(timfile) {
-        load_texture(timfile, &tim);
-
+    if(tex_bg0.loaded) {
         // Background compression must be the same for both background
-        // images. Also, they must be one texture page apart (64 bytes)
-        // horizontally, and their clut must be vertically aligned
-        data->parallax_tx_mode = tim.mode;
-        data->parallax_px = 448;
-        data->parallax_py = 256;
-        data->parallax_cx = 0;
-        data->parallax_cy = 483;
-        
-        free(timfile);
+        // images, since they are drawn from the same area
+        data->parallax_tx_mode = tex_bg0.mode;
+        data->parallax_px = area_bg->prect.x;
+        data->parallax_py = area_bg->prect.y;
+        data->parallax_cx = area_bg->crect.x;
+        data->parallax_cy = area_bg->crect.y;
     } else printf("Warning: Level BG0 not found, ignoring\n");
 
-    snprintf(filename0, 255, "%s\\BG1.TIM;1", basepath);
-    printf("Loading %s...\n", filename0);
-    timfile = file_read(filename0, &filelength);
-    if(timfile) {
-        load_texture(timfile, &tim);
-        free(timfile);
-    } else printf("Warning: Level BG1 not found, ignoring\n");
+    if(!tex_bg1.loaded) printf("Warning: Level BG1 not found, ignoring\n");
+
+    // Everything from here on belongs to the level (round) scope
+    screen_push_scope(ARENA_SCOPE_LEVEL);
 
     // Load level parallax data
     snprintf(filename0, 255, "%s\\PRL.PRL;1", basepath);
@@ -1364,19 +1415,30 @@ level_load_level(screen_level_data *data)
                   data->parallax_cx, data->parallax_cy);
     printf("Loaded parallax strips: %d\n", data->parallax.num_strips);
 
+    // Load level art animations, if any. Only started once every texture
+    // they may touch is on VRAM
+    snprintf(filename0, 255, "%s\\ANIM.ANM;1", basepath);
+    levelanim_load(filename0);
+
 
     /* === TILE MAPPINGS === */
     snprintf(filename0, 255, "%s\\MAP16.MAP;1", basepath);
     snprintf(filename1, 255, "%s\\MAP16.COL;1", basepath);
     printf("Loading %s and %s...\n", filename0, filename1);
     load_map16(map16, filename0, filename1);
-    snprintf(filename0, 255, "%s\\MAP128.MAP;1", basepath);
-    printf("Loading %s...\n", filename0);
-    load_map128(map128, filename0);
+    // Long acts stream their chunks by region instead
+    snprintf(filename0, 255, "%s\\Z%1u.RGN;1", basepath, level_act + 1);
+    if(!region_init(map128, filename0)) {
+        snprintf(filename0, 255, "%s\\MAP128.MAP;1", basepath);
+        printf("Loading %s...\n", filename0);
+        load_map128(map128, filename0);
+    }
 
 
 
     /* === LEVEL LAYOUT === */
+    // Layout and object placement are specific to this act
+    screen_push_scope(ARENA_SCOPE_ACT);
     snprintf(filename0, 255, "%s\\Z%1u.LVL;1", basepath, level_act + 1);
     printf("Loading %s...\n", filename0);
     load_lvl(leveldata, filename0);
@@ -1385,23 +1447,37 @@ level_load_level(screen_level_data *data)
 
     /* === OBJECTS === */
     // Load common objects
+    // These are kept on the asset cache and only reloaded when evicted
+    // Object textures are only waited for once all of them are uploaded
+    texture_batch_begin();
     printf("Loading common object texture...\n");
-    timfile = file_read("\\LEVELS\\COMMON\\OBJ.TIM;1", &filelength);
-    if(timfile) {
-        load_texture(timfile, &tim);
-        free(timfile);
+    VramArea *area_obj = level_vram_alloc(VRAM_AREA_OBJ_COMMON, 128, 512, 1,
+                                          VRAM_SCOPE_PERSISTENT);
+    if(!area_obj) {
+        texture_batch_end();
+        return;
     }
+    cache_load_texture("\\LEVELS\\COMMON\\OBJ.TIM;1", &tim, area_obj);
     printf("Loading common object table...\n");
-    load_object_table("\\LEVELS\\COMMON\\OBJ.OTD;1", obj_table_common);
+    load_object_table_cached("\\LEVELS\\COMMON\\OBJ.OTD;1", obj_table_common);
 
     // Load level objects
     snprintf(filename0, 255, "%s\\OBJ.TIM;1", basepath);
     printf("Loading level object texture...\n");
-    timfile = file_read(filename0, &filelength);
-    if(timfile) {
-        load_texture(timfile, &tim);
-        free(timfile);
-    } else printf("Warning: No level object texture found, skipping\n");
+    // Level objects take the upper half of their area, and a boss takes
+    // the lower half, with its normal and glowing palettes on the rows
+    // right below the level objects palette
+    area_obj = level_vram_alloc(VRAM_AREA_OBJ_LEVEL, 128, 512, 3,
+                                VRAM_SCOPE_SCENE);
+    if(!area_obj) {
+        texture_batch_end();
+        return;
+    }
+    CdLoadTexture tex_obj;
+    cdload_texture_at(filename0, &tex_obj, area_obj, 0, 0, 0);
+    cdload_sync(NULL);
+    if(!tex_obj.loaded)
+        printf("Warning: No level object texture found, skipping\n");
 
     // Load level boss object, if existing.
     // Warning: This supersedes the second half of level object textures!
@@ -1409,23 +1485,27 @@ level_load_level(screen_level_data *data)
        || (level_act >= 1)) {
         printf("Loading level boss...\n");
         snprintf(filename0, 255, "%s\\BOSS.TIM;1", basepath);
-        timfile = file_read(filename0, &filelength);
+        uint8_t *timfile = file_read(filename0, &filelength);
         if(timfile) {
-            level_has_boss = 1;
-            load_texture(timfile, &tim);
-            /* clut_print_all_colors(&tim); */
-            // Setup glowing color palette and reupload it right below
-            // the original boss palette
-            tim.crect->y += 1;
-            clut_set_glow_color(&tim, 0xd3, 0xd3, 0xd3);
-            load_clut_only(&tim);
-
-            free(timfile);
+            if(load_texture_at(timfile, &tim, area_obj, 0, 256, 1)) {
+                level_has_boss = 1;
+                /* clut_print_all_colors(&tim); */
+                // Setup glowing color palette and reupload it right below
+                // the original boss palette. The original palette is dyed
+                // in place, so it must be done uploading first
+                DrawSync(0);
+                tim.crect->y += 1;
+                clut_set_glow_color(&tim, 0xd3, 0xd3, 0xd3);
+                load_clut_only(&tim);
+            } else printf("Warning: Level boss texture skipped\n");
+
+            texture_batch_free(timfile);
         } else printf("Warning: No level boss texture found, skipping\n");
 
         // Init boss structure
         boss = screen_alloc(sizeof(BossState));
     }
+    texture_batch_end();
 
     printf("Loading level object table...\n");
     snprintf(filename0, 255, "%s\\OBJ.OTD;1", basepath);
@@ -1440,13 +1520,21 @@ level_load_level(screen_level_data *data)
     level_ring_max = count_emplaced_rings(leveldata);
 
 
+    file_pack_unmount();
+
+
     /* === OBJECT POOL / FREE OBJECTS === */
     object_pool_init();
 
 
     /* === RENDERING PREPARATION === */
+    // Underwater palettes are built from what was just uploaded
+    water_init(level_water_y);
+    levelanim_start();
+
     // Pre-allocate and initialize level primitive buffer
     prepare_renderer();
+    budget_reset();
 
     screen_debrief();
 
@@ -1553,32 +1641,48 @@ screen_level_play_music(uint8_t round, uint8_t act)
 
 #include <screens/slide.h>
 
-void
-screen_level_transition_to_next()
+// Level which follows the current one, or -1 if the game moves on to
+// another screen instead
+static int16_t
+level_get_next()
 {
-    // WARNING: WHEN CALLING THIS, RETURN IMMEDIATELY SO YOU DON'T
-    // OVERWRITE THE NEXT SCREEN WITH JUNK.
     uint8_t lvl = screen_level_getlevel();
     if(lvl == 2 || lvl == 3) {
         // Finished engine test
-        scene_change(SCREEN_TITLE);
+        return -1;
     } else if(lvl != 5) {
         // If on test level 2 and our character is Knuckles...
         // Go to test level 4 (also an act 3)
         if(lvl == 1) {
             if(screen_level_getcharacter() == CHARA_KNUCKLES) {
-                screen_level_setlevel(3);
-            } else screen_level_setlevel(2);
+                return 3;
+            } else return 2;
         } else if(lvl == 6) {
             // Transition from SWZ1 to AOZ1
             // TODO: THIS IS TEMPORARY
-            screen_level_setlevel(10);
+            return 10;
         } else if(lvl == 10) {
             // Transition from AOZ1 to GHZ1
             // TODO: THIS IS TEMPORARY
-            screen_level_setlevel(4);
-        } else screen_level_setlevel(lvl + 1);
+            return 4;
+        } else return lvl + 1;
+    }
+    return -1;
+}
+
+void
+screen_level_transition_to_next()
+{
+    // WARNING: WHEN CALLING THIS, RETURN IMMEDIATELY SO YOU DON'T
+    // OVERWRITE THE NEXT SCREEN WITH JUNK.
+    uint8_t lvl = screen_level_getlevel();
+    int16_t next = level_get_next();
+    if(next >= 0) {
+        screen_level_setlevel(next);
         scene_change(SCREEN_LEVEL);
+    } else if(lvl == 2 || lvl == 3) {
+        // Finished engine test
+        scene_change(SCREEN_TITLE);
     } else {
         /* screen_slide_set_next(SLIDE_COMINGSOON); */
         screen_slide_set_next(SLIDE_THANKS);
@@ -1586,6 +1690,23 @@ screen_level_transition_to_next()
     }
 }
 
+// Reads the pack of the next act into RAM while the score tally runs, so
+// that loading it on the transition does not need the CD at all
+static void
+level_prefetch_next()
+{
+    if(level_mode == LEVEL_MODE_DEMO) return;
+    int16_t next = level_get_next();
+    if(next < 0) return;
+
+    LevelInfo info;
+    char filename[255];
+    level_get_info(next, &info);
+    snprintf(filename, 255, "\\LEVELS\\R%1u\\Z%1u.PAK;1", info.round, info.act + 1);
+    printf("Prefetching %s...\n", filename);
+    file_pack_prefetch(filename);
+}
+
 void
 screen_level_transition_start_timer()
 {
@@ -13,6 +13,7 @@
 #include "util.h"
 #include "timer.h"
 #include "basic_font.h"
+#include "textfmt.h"
 #include "player.h"
 #include "screens/sprite_test.h"
 
@@ -131,23 +132,25 @@ static const char *menutext[] = {
 void
 screen_levelselect_load()
 {
-    screen_levelselect_data *data = screen_alloc(sizeof(screen_levelselect_data));
+    screen_levelselect_data *data = screen_alloc_data(sizeof(screen_levelselect_data));
     data->menu_choice = 0;
     bzero(data->buffer, 255);
 
     uint32_t length;
     TIM_IMAGE bg;
+    texture_batch_begin();
     uint8_t *img = file_read("\\MISC\\LVLSEL.TIM;1", &length);
     load_texture(img, &bg);
     data->bg_mode = bg.mode;
     data->bg_prect_x = bg.prect->x;
     data->bg_prect_y = bg.prect->y;
-    free(img);
+    texture_batch_free(img);
 
     // Load icon images at 384x0 (16-bit colors because yes)
     img = file_read("\\MISC\\STICONS.TIM;1", &length);
     load_texture(img, &bg);
-    free(img);
+    texture_batch_free(img);
+    texture_batch_end();
 
     data->bg_frame = 0;
     data->bg_state = 0;
@@ -467,13 +470,15 @@ screen_levelselect_draw(void *d)
 
         if(cursel == CHOICE_SOUNDTEST) {
             char buffer[80];
-            snprintf(buffer, 80, "BGM TEST    *%02X*",
-                     data->soundtest_selection);
+            textfmt_str(textfmt_hex(textfmt_str(buffer, "BGM TEST    *"),
+                                    data->soundtest_selection, 2),
+                        "*");
             font_draw_sm(buffer, vx, vy);
         } else if(cursel == CHOICE_SLIDE) {
             char buffer[80];
-            snprintf(buffer, 80, "SPLASH      *%02X*",
-                     data->slidetest_selection);
+            textfmt_str(textfmt_hex(textfmt_str(buffer, "SPLASH      *"),
+                                    data->slidetest_selection, 2),
+                        "*");
             font_draw_sm(buffer, vx, vy);
         } else if(cursel == CHOICE_CHARACTER) {
             char buffer[80];
@@ -16,7 +16,8 @@ typedef struct {
 void
 screen_modeltest_load()
 {
-    screen_modeltest_data *data = screen_alloc(sizeof(screen_modeltest_data));
+    screen_modeltest_data *data = screen_alloc_data(sizeof(screen_modeltest_data));
+    render_set_ot_length(OT_LENGTH);
 
     data->ring = screen_alloc(sizeof(Model));
     load_model(data->ring, "\\MODELS\\COMMON\\RING.MDL");
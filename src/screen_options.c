@@ -7,6 +7,7 @@
 #include "util.h"
 #include "input.h"
 #include "basic_font.h"
+#include "textfmt.h"
 #include "sound.h"
 #include "timer.h"
 
@@ -46,7 +47,7 @@ typedef struct {
 void
 screen_options_load()
 {
-    screen_options_data *data = screen_alloc(sizeof(screen_options_data));
+    screen_options_data *data = screen_alloc_data(sizeof(screen_options_data));
 
     uint32_t length;
     TIM_IMAGE tim;
@@ -240,7 +241,7 @@ _draw_control(int16_t vy, const char *caption, int16_t value, uint8_t selected)
 
     // 1% of 0x3fff is roughly 0xa3
     uint16_t perc = value / 0xa3;
-    snprintf(buffer, 4, "%3u", perc);
+    textfmt_dec(buffer, perc, 3, TEXTFMT_PAD_SPACE);
     uint16_t volsz = font_measurew_sm(buffer);
 
     if(selected) font_set_color(128, 128, 0);
@@ -80,7 +80,7 @@ typedef struct {
 void
 screen_slide_load()
 {   
-    screen_slide_data *data = screen_alloc(sizeof(screen_slide_data));
+    screen_slide_data *data = screen_alloc_data(sizeof(screen_slide_data));
     data->current = next_slide;
     data->current_text = next_slide_text;
     next_slide = -1;
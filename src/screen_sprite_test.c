@@ -27,7 +27,7 @@ typedef struct {
 void
 screen_sprite_test_load()
 {
-    screen_sprite_test_data *data = screen_alloc(sizeof(screen_sprite_test_data));
+    screen_sprite_test_data *data = screen_alloc_data(sizeof(screen_sprite_test_data));
 
     uint32_t filelength;
     TIM_IMAGE tim;
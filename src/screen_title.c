@@ -94,17 +94,21 @@ title_load_texture(const char *filename, texture_props *props)
     props->mode = img.mode;
     props->prect_x  = img.prect->x;
     props->prect_y  = img.prect->y;
-    free(data);
+    texture_batch_free(data);
 }
 
 void
 screen_title_load()
 {
-    screen_title_data *data = screen_alloc(sizeof(screen_title_data));
+    screen_title_data *data = screen_alloc_data(sizeof(screen_title_data));
+    // The planet is sorted by depth
+    render_set_ot_length(OT_LENGTH);
 
+    texture_batch_begin();
     title_load_texture("\\SPRITES\\TITLE\\TITLE.TIM;1", &data->props_title);
     title_load_texture("\\SPRITES\\TITLE\\PRL.TIM;1", &data->props_prl);
     title_load_texture("\\SPRITES\\TITLE\\CLD.TIM;1", &data->props_cld);
+    texture_batch_end();
 
     data->rot   = (SVECTOR) { 0 };
     data->pos   = (VECTOR)  { 0, 0, 450 };
@@ -397,7 +401,7 @@ screen_title_drawcld(screen_title_data *data)
             (uint32_t *)&poly->x3,
             &otz);
 
-        if((nclip > 0) && (otz > 0) && (otz < OT_LENGTH)) {
+        if((nclip > 0) && (otz > 0) && (otz < render_get_ot_length())) {
             sort_prim(poly, otz);
             increment_prim(sizeof(POLY_FT4));
         }
@@ -33,6 +33,16 @@ static volatile CdlLOC  cdda_toc[MAX_TOC_TRACKS];
 static volatile uint8_t cdda_current_track;
 static volatile uint8_t cdda_track_loops;
 static volatile uint8_t cdda_is_stereo = BGM_DEFAULT_IS_STEREO;
+static volatile uint8_t cdda_playing = 0;
+
+// The drive cannot play audio while reading data, so streamed reads pause
+// the track and pick it up again where it was
+static uint8_t cdda_suspended = 0;
+static CdlLOC  cdda_resume_loc;
+
+// Streamed level regions keep the drive busy all the time, so no track is
+// started while they are active
+static uint8_t cdda_blocked = 0;
 
 // Volume levels
 static volatile uint16_t volume_master = 0;
@@ -148,6 +158,7 @@ _cdda_loop_callback()
 {
     if(!cdda_track_loops || (cdda_current_track > cdda_toc_size)) {
         CdControlF(CdlPause, 0);
+        cdda_playing = 0;
         return;
     }
     CdControlF(CdlSetloc, (CdlLOC *)&cdda_toc[cdda_current_track]);
@@ -256,8 +267,18 @@ sound_cdda_play_track(uint8_t track, uint8_t loops)
     // Mode: Report + CD-DA + Auto-pause callback
     uint8_t mode = CdlModeRept | CdlModeDA | CdlModeAP;
 
+    if(cdda_blocked) return;
+
     cdda_current_track = track;
     cdda_track_loops = loops;
+    cdda_playing = 1;
+
+    // Reads in progress own the drive; start once they are done
+    if(cdda_suspended) {
+        cdda_resume_loc = cdda_toc[track];
+        return;
+    }
+
     CdSync(0, 0);
     CdControl(CdlSetmode, &mode, 0);
     CdControl(CdlSetloc, (CdlLOC *)&cdda_toc[cdda_current_track], 0);
@@ -267,6 +288,13 @@ sound_cdda_play_track(uint8_t track, uint8_t loops)
 void
 sound_cdda_stop()
 {
+    cdda_playing = 0;
+    if(cdda_suspended) {
+        cdda_current_track = 0xff;
+        cdda_track_loops = 0;
+        return;
+    }
+
     CdControl(CdlPause, 0, 0);
     CdSync(0, 0);
     CdControl(CdlDemute, 0, 0);
@@ -274,6 +302,49 @@ sound_cdda_stop()
     cdda_track_loops = 0;
 }
 
+void
+sound_cdda_suspend()
+{
+    if(cdda_suspended) return;
+    cdda_suspended = 1;
+    if(!cdda_playing) return;
+
+    // Absolute position of the sector being played
+    uint8_t result[8];
+    CdControlB(CdlGetlocP, 0, result);
+    cdda_resume_loc.minute = result[5];
+    cdda_resume_loc.second = result[6];
+    cdda_resume_loc.sector = result[7];
+    cdda_resume_loc.track  = 0;
+    CdControlB(CdlPause, 0, 0);
+}
+
+void
+sound_cdda_resume()
+{
+    if(!cdda_suspended) return;
+    cdda_suspended = 0;
+    if(!cdda_playing) return;
+
+    // Mode: Report + CD-DA + Auto-pause callback
+    uint8_t mode = CdlModeRept | CdlModeDA | CdlModeAP;
+    CdControl(CdlSetmode, &mode, 0);
+    CdControl(CdlSetloc, &cdda_resume_loc, 0);
+    CdControl(CdlPlay, 0, 0);
+}
+
+void
+sound_cdda_set_blocked(uint8_t state)
+{
+    cdda_blocked = state;
+}
+
+uint8_t
+sound_cdda_is_playing()
+{
+    return cdda_playing;
+}
+
 uint8_t
 sound_cdda_get_num_tracks()
 {
@@ -0,0 +1,103 @@
+#include "textfmt.h"
+
+static const char _hex_digits[] = "0123456789ABCDEF";
+static const uint16_t _pow10[] = { 1, 10, 100, 1000, 10000 };
+
+// Writes digits backwards into a scratch buffer, then the padded field.
+// Magnitudes are kept unsigned so that INT32_MIN needs no special case
+static char *
+_emit(char *dst, const char *digits, uint8_t ndigits,
+      uint8_t negative, uint8_t width, char pad)
+{
+    int16_t fill = (int16_t)width - ndigits - negative;
+    if(pad == TEXTFMT_PAD_ZERO) {
+        if(negative) *dst++ = '-';
+        while(fill-- > 0) *dst++ = '0';
+    } else {
+        while(fill-- > 0) *dst++ = ' ';
+        if(negative) *dst++ = '-';
+    }
+    while(ndigits > 0) *dst++ = digits[--ndigits];
+    *dst = '\0';
+    return dst;
+}
+
+static uint8_t
+_udigits(char *scratch, uint32_t value)
+{
+    uint8_t n = 0;
+    do {
+        // Divisions by a constant become multiplications on GCC
+        uint32_t q = value / 10;
+        scratch[n++] = '0' + (value - q * 10);
+        value = q;
+    } while(value > 0);
+    return n;
+}
+
+char *
+textfmt_dec(char *dst, int32_t value, uint8_t width, char pad)
+{
+    char scratch[10];
+    uint8_t negative = value < 0;
+    uint32_t mag = negative ? -(uint32_t)value : (uint32_t)value;
+    return _emit(dst, scratch, _udigits(scratch, mag), negative, width, pad);
+}
+
+char *
+textfmt_hex(char *dst, uint32_t value, uint8_t width)
+{
+    char scratch[8];
+    uint8_t n = 0;
+    do {
+        scratch[n++] = _hex_digits[value & 0xf];
+        value >>= 4;
+    } while(value > 0);
+    return _emit(dst, scratch, n, 0, width, TEXTFMT_PAD_ZERO);
+}
+
+char *
+textfmt_time(char *dst, uint32_t seconds)
+{
+    uint32_t minutes = seconds / 60;
+    seconds -= minutes * 60;
+    dst = textfmt_dec(dst, minutes, 2, TEXTFMT_PAD_SPACE);
+    *dst++ = ':';
+    return textfmt_dec(dst, seconds, 2, TEXTFMT_PAD_ZERO);
+}
+
+char *
+textfmt_fixed(char *dst, int32_t value, uint8_t decimals, uint8_t width)
+{
+    char scratch[16];
+    if(decimals > 4) decimals = 4;
+    uint8_t negative = value < 0;
+    uint32_t mag = negative ? -(uint32_t)value : (uint32_t)value;
+
+    // Fractional digits first, since the scratch buffer is written backwards
+    uint8_t n = 0;
+    if(decimals > 0) {
+        uint32_t frac = ((mag & 0xfff) * _pow10[decimals]) >> 12;
+        for(uint8_t i = 0; i < decimals; i++) {
+            uint32_t q = frac / 10;
+            scratch[n++] = '0' + (frac - q * 10);
+            frac = q;
+        }
+        scratch[n++] = '.';
+    }
+    n += _udigits(scratch + n, mag >> 12);
+
+    // A value truncated to zero shows no sign
+    if(negative && ((mag >> 12) == 0)
+       && ((((mag & 0xfff) * _pow10[decimals]) >> 12) == 0))
+        negative = 0;
+    return _emit(dst, scratch, n, negative, width, TEXTFMT_PAD_SPACE);
+}
+
+char *
+textfmt_str(char *dst, const char *src)
+{
+    while(*src != '\0') *dst++ = *src++;
+    *dst = '\0';
+    return dst;
+}
@@ -1,6 +1,7 @@
 #include "timer.h"
 #include <psxapi.h>
 #include <psxetc.h>
+#include <psxgpu.h>
 #include <stdio.h>
 
 extern uint8_t paused;
@@ -12,6 +13,12 @@ volatile uint8_t  counting_frames = 0;
 volatile uint32_t frame_count = 0;
 volatile uint32_t global_count = 0;
 
+// Step accumulator, in fifths of an NTSC vblank (or sixths of a PAL one)
+#define STEP_UNITS      5
+#define STEP_UNITS_PAL  6
+static int      last_vblank = 0;
+static uint32_t step_accum = 0;
+
 void
 timer_tick()
 {
@@ -40,12 +47,37 @@ timer_init()
 inline void
 timer_update()
 {
-    frame_counter++;
     if(counting_frames && !paused)
         frame_count++;
     global_count++;
 }
 
+uint8_t
+timer_steps()
+{
+    int now = VSync(-1);
+    frame_counter++;
+    step_accum += (now - last_vblank)
+        * ((GetVideoMode() == MODE_PAL) ? STEP_UNITS_PAL : STEP_UNITS);
+    last_vblank = now;
+
+    // Whatever cannot be caught up with is dropped, so that a long stall
+    // does not turn into a burst of fast-forwarded steps
+    uint32_t steps = step_accum / STEP_UNITS;
+    step_accum -= steps * STEP_UNITS;
+    if(steps > TIMER_MAX_STEPS) steps = TIMER_MAX_STEPS;
+    return steps;
+}
+
+void
+timer_reset_steps()
+{
+    // Drops whatever time was left over. The next call to timer_steps runs
+    // one step, plus any step due to vblanks elapsed after this call
+    last_vblank = VSync(-1);
+    step_accum = STEP_UNITS;
+}
+
 int
 get_frame_rate()
 {
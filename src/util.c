@@ -1,4 +1,6 @@
 #include "util.h"
+#include "cdload.h"
+#include "cache.h"
 #include <inline_c.h>
 #include <psxcd.h>
 #include <psxgpu.h>
@@ -82,50 +84,695 @@ CrossProduct12(VECTOR *v0, VECTOR *v1, VECTOR *out)
     gte_stlvnl(out);
 }
 
-uint8_t *
-file_read(const char *filename, uint32_t *length)
+// File index. Built once at boot by walking the ISO9660 directory tree,
+// so that file_read does not need to parse directory records again.
+// Full paths are kept, so that paths with the same hash are told apart.
+// tools/tests/test_fileindex.py checks these limits against iso.xml
+#define FILE_INDEX_MAX   512
+#define FILE_PATH_MAX    128
+#define FILE_NAMES_LEN   4096
+#define ISO_PVD_SECTOR   16
+#define ISO_ROOT_RECORD  156
+
+typedef struct {
+    uint32_t hash;
+    uint16_t name;  // Offset of the full path within _file_names
+    int      lba;
+    uint32_t size;
+} FileIndexEntry;
+
+static FileIndexEntry _file_index[FILE_INDEX_MAX];
+static uint16_t       _file_index_count = 0;
+static char           _file_names[FILE_NAMES_LEN];
+static uint16_t       _file_names_used = 0;
+
+static uint32_t
+_path_hash(const char *s)
 {
-    CdlFILE filepos;
-    int numsectors;
+    // FNV-1a
+    uint32_t h = 0x811c9dc5;
+    while(*s) {
+        h ^= (uint8_t)*s++;
+        h *= 0x01000193;
+    }
+    return h;
+}
+
+static uint32_t
+_get_long_le_at(uint8_t *bytes, uint32_t b)
+{
+    return bytes[b]
+        | (bytes[b + 1] << 8)
+        | (bytes[b + 2] << 16)
+        | (bytes[b + 3] << 24);
+}
+
+static uint8_t *
+_read_sectors(int lba, int numsectors)
+{
+    CdlLOC loc;
+    uint8_t *buffer = (uint8_t *) malloc(2048 * numsectors);
+    if(!buffer) return NULL;
+    CdIntToPos(lba, &loc);
+    CdControl(CdlSetloc, (uint8_t *) &loc, 0);
+    CdRead(numsectors, (uint32_t *) buffer, CdlModeSpeed);
+    CdReadSync(0, 0);
+    return buffer;
+}
+
+static void
+_file_index_dir(char *path, uint32_t pathlen, int lba, uint32_t size)
+{
+    int numsectors = (size + 2047) / 2048;
+    uint8_t *dir = _read_sectors(lba, numsectors);
+    if(!dir) return;
+
+    uint32_t b = 0;
+    while(b < size) {
+        uint8_t reclen = dir[b];
+        if(reclen == 0) {
+            // Records never cross sectors; skip to the next one
+            b = (b + 2048) & ~2047;
+            continue;
+        }
+
+        int      rlba  = _get_long_le_at(dir, b + 2);
+        uint32_t rsize = _get_long_le_at(dir, b + 10);
+        uint8_t  flags = dir[b + 25];
+        uint8_t  namelen = dir[b + 32];
+        const char *name = (const char *)&dir[b + 33];
+        b += reclen;
+
+        // Skip "." and ".." entries
+        if((namelen == 1) && ((name[0] == 0) || (name[0] == 1))) continue;
+        if(pathlen + 1 + namelen >= FILE_PATH_MAX) continue;
+
+        path[pathlen] = '\\';
+        memcpy(&path[pathlen + 1], name, namelen);
+        path[pathlen + 1 + namelen] = '\0';
+
+        uint32_t fullen = pathlen + 1 + namelen + 1;
+        if(flags & 0x02) {
+            _file_index_dir(path, pathlen + 1 + namelen, rlba, rsize);
+        } else if((_file_index_count < FILE_INDEX_MAX)
+                  && (_file_names_used + fullen <= FILE_NAMES_LEN)) {
+            // Files left out are still found through CdSearchFile
+            FileIndexEntry *entry = &_file_index[_file_index_count++];
+            entry->hash = _path_hash(path);
+            entry->name = _file_names_used;
+            entry->lba = rlba;
+            entry->size = rsize;
+            memcpy(&_file_names[_file_names_used], path, fullen);
+            _file_names_used += fullen;
+        }
+    }
+
+    path[pathlen] = '\0';
+    free(dir);
+}
+
+void
+file_index_init()
+{
+    char path[FILE_PATH_MAX] = { 0 };
+    _file_index_count = 0;
+    _file_names_used = 0;
+
+    uint8_t *pvd = _read_sectors(ISO_PVD_SECTOR, 1);
+    if(!pvd) return;
+    int      lba  = _get_long_le_at(pvd, ISO_ROOT_RECORD + 2);
+    uint32_t size = _get_long_le_at(pvd, ISO_ROOT_RECORD + 10);
+    free(pvd);
+
+    _file_index_dir(path, 0, lba, size);
+    printf("Indexed %d files on disc\n", _file_index_count);
+}
+
+uint8_t
+file_locate(const char *filename, CdlFILE *filepos)
+{
+    uint32_t hash = _path_hash(filename);
+    for(uint16_t i = 0; i < _file_index_count; i++) {
+        if((_file_index[i].hash == hash)
+           && !strcmp(&_file_names[_file_index[i].name], filename)) {
+            CdIntToPos(_file_index[i].lba, &filepos->pos);
+            filepos->size = _file_index[i].size;
+            return 1;
+        }
+    }
+
+    // Not indexed (or the index was never built); ask the BIOS
+    return CdSearchFile(filepos, filename) != NULL;
+}
+
+// Compressed files. Files within level packs may be LZSS-compressed by
+// lzcomp.py, in which case they are decompressed transparently when read. The header
+// tells how far into the destination buffer the compressed file must be
+// placed so that it can be decompressed in place.
+uint8_t
+lz_header(uint8_t *data, uint32_t length, uint32_t *size, uint32_t *inplace)
+{
+    uint32_t b = 0;
+    if((length < LZ_HEADER_SIZE) || (get_long_be(data, &b) != LZ_MAGIC))
+        return 0;
+    *size = get_long_be(data, &b);
+    *inplace = get_long_be(data, &b);
+    return 1;
+}
+
+void
+lz_decompress(uint8_t *dst, const uint8_t *src, uint32_t size)
+{
+    uint8_t *end = dst + size;
+    while(dst < end) {
+        uint8_t flags = *src++;
+        for(int bit = 0; (bit < 8) && (dst < end); bit++, flags >>= 1) {
+            if(flags & 0x01) {
+                *dst++ = *src++;
+            } else {
+                // Byte by byte, since matches may overlap their own output
+                uint32_t dist = ((src[0] << 4) | (src[1] >> 4)) + 1;
+                uint32_t len = (src[1] & 0x0f) + 3;
+                const uint8_t *from = dst - dist;
+                src += 2;
+                while(len--) *dst++ = *from++;
+            }
+        }
+    }
+}
+
+static uint32_t _file_sector[512];
+
+// Header expected by file_read_asset. Files are checked against it as soon
+// as their first bytes are known, so that no buffer is allocated for them
+// if they do not match. Plain reads expect nothing (NULL)
+typedef struct {
+    const char *filename;
+    const char *magic;
+    uint16_t   version;
+} FileExpect;
+
+static uint8_t
+_file_check_asset(const uint8_t *data, uint32_t size, const FileExpect *expect)
+{
+    if(!expect) return 1;
+
+    // Compressed files only need their first few bytes unpacked. Matches
+    // may run a little past the end, so leave room for the longest one
+    uint8_t unpacked[sizeof(AssetHeader) + 18];
+    uint32_t usize, inplace;
+    if(lz_header((uint8_t *)data, size, &usize, &inplace)) {
+        size = usize;
+        if(size >= sizeof(AssetHeader)) {
+            lz_decompress(unpacked, data + LZ_HEADER_SIZE, sizeof(AssetHeader));
+            data = unpacked;
+        }
+    }
+
+    const AssetHeader *header = (const AssetHeader *)data;
+    if((size < sizeof(AssetHeader))
+       || (strncmp(header->magic, expect->magic, 4) != 0)) {
+        printf("File %s is not a %.4s asset, it may need to be recooked\n",
+               expect->filename, expect->magic);
+        return 0;
+    }
+    if(header->version != expect->version) {
+        printf("File %s has version %d, expected %d\n",
+               expect->filename, header->version, expect->version);
+        return 0;
+    }
+    return 1;
+}
+
+// Reads a file straight off the CD with a single read. The uncompressed
+// size and in-place offset of compressed files (usize != 0) come from the
+// pack's table of contents; loose files are never compressed
+static uint8_t *
+_file_read_sectors(int lba, uint32_t size, uint32_t usize, uint32_t inplace,
+                   uint32_t *length, FileAllocator alloc,
+                   const FileExpect *expect)
+{
+    CdlLOC loc;
+    int numsectors = (size + 2047) / 2048;
+    uint32_t start = 0;
+    uint32_t total = 2048 * numsectors;
     uint8_t *buffer;
-    buffer = NULL;
 
-    if(CdSearchFile(&filepos, filename) == NULL) {
-        printf("File %s not found!\n", filename);
-        return NULL;
+    CdIntToPos(lba, &loc);
+
+    // Assets are checked before allocating, so that a stale file does not
+    // leave a buffer behind. Only this costs an extra read of one sector
+    if(expect) {
+        CdControl(CdlSetloc, (uint8_t *) &loc, 0);
+        CdRead(1, _file_sector, CdlModeSpeed);
+        CdReadSync(0, 0);
+        if(!_file_check_asset((uint8_t *)_file_sector, size, expect))
+            return NULL;
     }
 
-    numsectors = (filepos.size + 2047) / 2048;
-    buffer = (uint8_t *) malloc(2048 * numsectors);
+    if(usize) {
+        start = (inplace + 3) & ~3;
+        total = MAX(usize, start + total);
+    }
+
+    buffer = (uint8_t *) alloc(total);
     if(!buffer) {
-        printf("Error allocating %d sectors.\n", numsectors);
+        printf("Error allocating %d bytes.\n", total);
         return NULL;
     }
 
-    CdControl(CdlSetloc, (uint8_t *) &filepos.pos, 0);
-    CdRead(numsectors, (uint32_t *) buffer, CdlModeSpeed);
+    CdControl(CdlSetloc, (uint8_t *) &loc, 0);
+    CdRead(numsectors, (uint32_t *)(buffer + start), CdlModeSpeed);
     CdReadSync(0, 0);
 
-    *length = filepos.size;
+    if(usize) {
+        lz_decompress(buffer, buffer + start + LZ_HEADER_SIZE, usize);
+        *length = usize;
+    } else if(lz_header(buffer, size, &usize, &inplace)) {
+        // Left over from a cook that still compressed loose files
+        printf("Error: Compressed file outside of a pack, recook assets\n");
+        return NULL;
+    } else *length = size;
+    return buffer;
+}
+
+static uint8_t *
+_file_unpack(uint8_t *data, uint32_t size, uint32_t *length,
+             FileAllocator alloc, const FileExpect *expect)
+{
+    uint32_t usize, inplace;
+    if(!_file_check_asset(data, size, expect)) return NULL;
+
+    uint8_t compressed = lz_header(data, size, &usize, &inplace);
+    uint32_t total = compressed ? usize : size;
+    uint8_t *buffer = (uint8_t *) alloc(total);
+    if(!buffer) {
+        printf("Error allocating %d bytes.\n", total);
+        return NULL;
+    }
+
+    if(compressed) lz_decompress(buffer, data + LZ_HEADER_SIZE, usize);
+    else memcpy(buffer, data, size);
+    *length = total;
     return buffer;
 }
 
+// Level packs. While a pack is mounted, files within the pack's directory
+// are served from it instead of being searched for on the CD.
+#define PACK_MAGIC       0x50414b32 // "PAK2"
+#define PACK_NAME_LEN    12
+#define PACK_MAX_ENTRIES 32
+
+typedef struct {
+    char     name[PACK_NAME_LEN + 1];
+    uint32_t offset;
+    uint32_t size;
+    uint32_t usize;   // Uncompressed size, 0 if stored as-is
+    uint32_t inplace;
+} PackEntry;
+
+static struct {
+    uint8_t   mounted;
+    char      prefix[64];
+    int       lba;
+    uint8_t  *data;
+    uint16_t  num_entries;
+    PackEntry entries[PACK_MAX_ENTRIES];
+} _pack = { 0 };
+
+// A pack may be read ahead of time through the async loader, and is then
+// handed over to the next file_pack_mount of the same file
+enum {
+    PACK_PREFETCH_NONE,
+    PACK_PREFETCH_LOADING,
+    PACK_PREFETCH_READY,
+};
+
+static struct {
+    uint8_t  state;
+    char     filename[64];
+    uint8_t  *data;
+} _prefetch = { 0 };
+
+static void
+_file_pack_prefetch_chunk(uint8_t *data, uint32_t offset, uint32_t length,
+                          uint8_t last, void *userdata)
+{
+    (void)(userdata);
+    if(!data) {
+        free(_prefetch.data);
+        _prefetch.data = NULL;
+        _prefetch.state = PACK_PREFETCH_NONE;
+        return;
+    }
+    memcpy(_prefetch.data + offset, data, length);
+    if(last) _prefetch.state = PACK_PREFETCH_READY;
+}
+
+uint8_t
+file_pack_prefetch(const char *filename)
+{
+    CdlFILE filepos;
+
+    file_pack_discard_prefetch();
+    if(!file_locate(filename, &filepos)) return 0;
+
+    _prefetch.data = (uint8_t *) malloc(filepos.size);
+    if(!_prefetch.data) {
+        printf("Not enough memory to prefetch %s\n", filename);
+        return 0;
+    }
+    strncpy(_prefetch.filename, filename, sizeof(_prefetch.filename) - 1);
+    _prefetch.filename[sizeof(_prefetch.filename) - 1] = '\0';
+    _prefetch.state = PACK_PREFETCH_LOADING;
+    if(!cdload_request(filename, _file_pack_prefetch_chunk, NULL)) {
+        file_pack_discard_prefetch();
+        return 0;
+    }
+    return 1;
+}
+
+void
+file_pack_discard_prefetch()
+{
+    // The loader must not write into the buffer after it is gone
+    if(_prefetch.state == PACK_PREFETCH_LOADING) cdload_sync(NULL);
+    if(_prefetch.data) free(_prefetch.data);
+    _prefetch.data = NULL;
+    _prefetch.state = PACK_PREFETCH_NONE;
+}
+
+static uint8_t
+_file_pack_take_prefetch(const char *filename)
+{
+    if((_prefetch.state == PACK_PREFETCH_NONE)
+       || (strcmp(_prefetch.filename, filename) != 0)) {
+        file_pack_discard_prefetch();
+        return 0;
+    }
+
+    if(_prefetch.state == PACK_PREFETCH_LOADING) cdload_sync(NULL);
+    if(_prefetch.state != PACK_PREFETCH_READY) return 0;
+
+    _pack.data = _prefetch.data;
+    _prefetch.data = NULL;
+    _prefetch.state = PACK_PREFETCH_NONE;
+    return 1;
+}
+
+uint8_t
+file_pack_mount(const char *filename)
+{
+    CdlFILE filepos;
+    uint8_t *bytes;
+    uint32_t b;
+
+    file_pack_unmount();
+
+    if(!file_locate(filename, &filepos)) {
+        printf("Pack %s not found, loading files individually\n", filename);
+        file_pack_discard_prefetch();
+        return 0;
+    }
+
+    if(_file_pack_take_prefetch(filename)) {
+        // Already on RAM, no need to touch the CD
+        bytes = _pack.data;
+    } else {
+        // Read the whole pack at once if possible. Otherwise keep only the
+        // table of contents and read each file as requested
+        int numsectors = (filepos.size + 2047) / 2048;
+        _pack.data = (uint8_t *) malloc(2048 * numsectors);
+        if(!_pack.data) numsectors = 1;
+        bytes = _pack.data ? _pack.data : (uint8_t *) malloc(2048);
+        if(!bytes) {
+            printf("Error allocating %d sectors.\n", numsectors);
+            return 0;
+        }
+
+        CdControl(CdlSetloc, (uint8_t *) &filepos.pos, 0);
+        CdRead(numsectors, (uint32_t *) bytes, CdlModeSpeed);
+        CdReadSync(0, 0);
+    }
+
+    b = 0;
+    if(get_long_be(bytes, &b) != PACK_MAGIC) {
+        printf("Pack %s is corrupt, ignoring\n", filename);
+        goto fail;
+    }
+    _pack.num_entries = get_short_be(bytes, &b);
+    b += 2; // _unused
+    if(_pack.num_entries > PACK_MAX_ENTRIES) {
+        printf("Pack %s has too many files, ignoring\n", filename);
+        goto fail;
+    }
+
+    for(uint16_t i = 0; i < _pack.num_entries; i++) {
+        PackEntry *entry = &_pack.entries[i];
+        for(int j = 0; j < PACK_NAME_LEN; j++)
+            entry->name[j] = get_byte(bytes, &b);
+        entry->name[PACK_NAME_LEN] = '\0';
+        entry->offset = get_long_be(bytes, &b);
+        entry->size = get_long_be(bytes, &b);
+        entry->usize = get_long_be(bytes, &b);
+        entry->inplace = get_long_be(bytes, &b);
+    }
+
+    // Files are looked up relative to the pack's directory
+    const char *sep = strrchr(filename, '\\');
+    uint32_t prefixlen = sep ? (uint32_t)(sep - filename) + 1 : 0;
+    if(prefixlen >= sizeof(_pack.prefix)) goto fail;
+    memcpy(_pack.prefix, filename, prefixlen);
+    _pack.prefix[prefixlen] = '\0';
+
+    if(!_pack.data) free(bytes);
+    _pack.lba = CdPosToInt(&filepos.pos);
+    _pack.mounted = 1;
+    printf("Mounted pack %s (%d files%s)\n", filename, _pack.num_entries,
+           _pack.data ? ", in RAM" : "");
+    return 1;
+
+fail:
+    free(bytes);
+    _pack.data = NULL;
+    return 0;
+}
+
+void
+file_pack_unmount()
+{
+    if(_pack.data) free(_pack.data);
+    _pack.data = NULL;
+    _pack.mounted = 0;
+    _pack.num_entries = 0;
+}
+
+static PackEntry *
+_file_pack_find(const char *filename)
+{
+    uint32_t prefixlen = strlen(_pack.prefix);
+    if(strncmp(filename, _pack.prefix, prefixlen) != 0) return NULL;
+    filename += prefixlen;
+
+    // Compare names up to the ISO9660 version suffix
+    uint32_t namelen = 0;
+    while(filename[namelen] && (filename[namelen] != ';')) namelen++;
+    if(namelen > PACK_NAME_LEN) return NULL;
+
+    for(uint16_t i = 0; i < _pack.num_entries; i++) {
+        PackEntry *entry = &_pack.entries[i];
+        if((strncmp(entry->name, filename, namelen) == 0)
+           && (entry->name[namelen] == '\0'))
+            return entry;
+    }
+    return NULL;
+}
+
+static uint8_t *
+_file_pack_read(PackEntry *entry, uint32_t *length, FileAllocator alloc,
+                const FileExpect *expect)
+{
+    if(_pack.data)
+        return _file_unpack(_pack.data + entry->offset, entry->size,
+                            length, alloc, expect);
+    return _file_read_sectors(_pack.lba + (entry->offset / 2048),
+                              entry->size, entry->usize, entry->inplace,
+                              length, alloc, expect);
+}
+
+uint8_t *
+file_pack_data(const char *filename, uint32_t *length)
+{
+    if(!_pack.mounted || !_pack.data) return NULL;
+    PackEntry *entry = _file_pack_find(filename);
+    if(!entry) return NULL;
+    *length = entry->size;
+    return _pack.data + entry->offset;
+}
+
+static void *
+_file_malloc(uint32_t size)
+{
+    return malloc(size);
+}
+
+static uint8_t *
+_file_read(const char *filename, uint32_t *length, FileAllocator alloc,
+           const FileExpect *expect)
+{
+    CdlFILE filepos;
+
+    if(_pack.mounted) {
+        PackEntry *entry = _file_pack_find(filename);
+        if(entry) return _file_pack_read(entry, length, alloc, expect);
+    }
+
+    if(!file_locate(filename, &filepos)) {
+        printf("File %s not found!\n", filename);
+        return NULL;
+    }
+
+    return _file_read_sectors(CdPosToInt(&filepos.pos), filepos.size, 0, 0,
+                              length, alloc, expect);
+}
+
+uint8_t *
+file_read_alloc(const char *filename, uint32_t *length, FileAllocator alloc)
+{
+    return _file_read(filename, length, alloc, NULL);
+}
+
+uint8_t *
+file_read(const char *filename, uint32_t *length)
+{
+    return file_read_alloc(filename, length, _file_malloc);
+}
+
+uint8_t *
+file_read_view(const char *filename, uint32_t *length)
+{
+    // Files stored as-is within a pack on RAM need no copy of their own
+    if(_pack.mounted && _pack.data) {
+        PackEntry *entry = _file_pack_find(filename);
+        uint32_t usize, inplace;
+        if(entry && !lz_header(_pack.data + entry->offset, entry->size,
+                               &usize, &inplace)) {
+            *length = entry->size;
+            return _pack.data + entry->offset;
+        }
+    }
+    return file_read(filename, length);
+}
+
+void
+file_release(uint8_t *bytes)
+{
+    if(_pack.data) {
+        for(uint16_t i = 0; i < _pack.num_entries; i++)
+            if(bytes == _pack.data + _pack.entries[i].offset) return;
+    }
+    free(bytes);
+}
+
+uint8_t *
+file_read_asset(const char *filename, uint32_t *length, FileAllocator alloc,
+                const char *magic, uint16_t version)
+{
+    FileExpect expect = { filename, magic, version };
+    return _file_read(filename, length, alloc, &expect);
+}
+
+// Textures uploaded within a batch are only waited for once, when the
+// batch ends. Their source buffers must be kept until then, so these are
+// handed to texture_batch_free instead of being freed right away
+#define TEXTURE_BATCH_MAX_FREES 16
+
+static struct {
+    uint8_t depth;
+    uint8_t num_frees;
+    void    *frees[TEXTURE_BATCH_MAX_FREES];
+} _batch = { 0 };
+
+static void
+_texture_batch_flush()
+{
+    DrawSync(0);
+    for(uint8_t i = 0; i < _batch.num_frees; i++)
+        free(_batch.frees[i]);
+    _batch.num_frees = 0;
+}
+
+void
+texture_batch_begin()
+{
+    _batch.depth++;
+}
+
+void
+texture_batch_free(void *data)
+{
+    if(_batch.depth == 0) {
+        free(data);
+        return;
+    }
+    if(_batch.num_frees >= TEXTURE_BATCH_MAX_FREES) _texture_batch_flush();
+    _batch.frees[_batch.num_frees++] = data;
+}
+
+void
+texture_batch_end()
+{
+    if(_batch.depth == 0) return;
+    if(--_batch.depth == 0) _texture_batch_flush();
+}
+
+static void
+_texture_sync()
+{
+    if(_batch.depth == 0) DrawSync(0);
+}
+
 void
 load_clut_only(TIM_IMAGE *tim)
 {
     if(tim->mode & 0x8) {
         LoadImage(tim->crect, tim->caddr);
-        DrawSync(0);
+        _texture_sync();
+        cache_vram_written(tim->crect);
+        vram_written(tim->crect);
     }
 }
 
 void
 load_texture(uint8_t *data, TIM_IMAGE *tim)
+{
+    load_texture_at(data, tim, NULL, 0, 0, 0);
+}
+
+uint8_t
+load_texture_at(uint8_t *data, TIM_IMAGE *tim, VramArea *area,
+                uint16_t ox, uint16_t oy, uint8_t clut_row)
 {
     GetTimInfo((const uint32_t *)data, tim);
+    // Textures placed on an allocated area ignore their embedded coordinates
+    if(area) {
+        tim->prect->x = area->prect.x + ox;
+        tim->prect->y = area->prect.y + oy;
+        if(tim->mode & 0x8) {
+            tim->crect->x = area->crect.x;
+            tim->crect->y = area->crect.y + clut_row;
+        }
+        if(!vram_area_fits(area, tim->prect,
+                           (tim->mode & 0x8) ? tim->crect : NULL))
+            return 0;
+    }
     LoadImage(tim->prect, tim->paddr);
-    DrawSync(0);
+    _texture_sync();
+    cache_vram_written(tim->prect);
+    vram_written(tim->prect);
     load_clut_only(tim);
+    if(area) area->resident = 1;
+    return 1;
 }
 
 uint16_t *
@@ -0,0 +1,211 @@
+#include "vram.h"
+#include <stdio.h>
+#include <strings.h>
+
+#define CELL_FREE     0x00
+#define CELL_RESERVED 0xff
+
+// Owner of each cell and CLUT row: area id + 1, or one of the above
+static uint8_t  _cells[VRAM_CELLS_Y][VRAM_CELLS_X];
+static uint8_t  _clut_rows[VRAM_CLUT_ROWS];
+static VramArea _areas[VRAM_AREA_MAX];
+
+static const char *_area_names[] = {
+    "PLAYER",
+    "TILES",
+    "BG",
+    "OBJCOMMON",
+    "OBJLEVEL",
+    "WATER",
+};
+
+void
+vram_init()
+{
+    bzero(_cells, sizeof(_cells));
+    bzero(_clut_rows, sizeof(_clut_rows));
+    bzero(_areas, sizeof(_areas));
+
+    // Framebuffers: 0x0 to 319x511
+    for(uint8_t y = 0; y < VRAM_CELLS_Y; y++) {
+        for(uint8_t x = 0; x < 5; x++)
+            _cells[y][x] = CELL_RESERVED;
+        // Character offscreen renderer (960x0) and basic font (960x256)
+        _cells[y][VRAM_CELLS_X - 1] = CELL_RESERVED;
+    }
+    // Basic font CLUT
+    _clut_rows[490 - VRAM_CLUT_Y] = CELL_RESERVED;
+}
+
+static void
+_release(VramAreaId id)
+{
+    for(uint8_t y = 0; y < VRAM_CELLS_Y; y++)
+        for(uint8_t x = 0; x < VRAM_CELLS_X; x++)
+            if(_cells[y][x] == id + 1) _cells[y][x] = CELL_FREE;
+    for(uint8_t i = 0; i < VRAM_CLUT_ROWS; i++)
+        if(_clut_rows[i] == id + 1) _clut_rows[i] = CELL_FREE;
+    _areas[id] = (VramArea){ 0 };
+}
+
+static uint8_t
+_cells_free(uint8_t cx, uint8_t cy, uint8_t cw, uint8_t ch)
+{
+    for(uint8_t y = cy; y < cy + ch; y++)
+        for(uint8_t x = cx; x < cx + cw; x++)
+            if(_cells[y][x] != CELL_FREE) return 0;
+    return 1;
+}
+
+VramArea *
+vram_alloc(VramAreaId id, uint16_t w, uint16_t h,
+           uint8_t clut_rows, VramScope scope)
+{
+    VramArea *area = &_areas[id];
+    uint8_t cw = (w + VRAM_CELL_W - 1) / VRAM_CELL_W;
+    uint8_t ch = (h + VRAM_CELL_H - 1) / VRAM_CELL_H;
+
+    // Asking again for an area of the same shape keeps it where it is,
+    // so that persistent textures can still be used if resident
+    if(area->allocated) {
+        if((area->prect.w == cw * VRAM_CELL_W)
+           && (area->prect.h == ch * VRAM_CELL_H)
+           && (area->crect.h == clut_rows)) {
+            area->scope = scope;
+            return area;
+        }
+        _release(id);
+    }
+
+    int8_t px = -1, py = -1;
+    for(uint8_t y = 0; (px < 0) && (y + ch <= VRAM_CELLS_Y); y++) {
+        for(uint8_t x = 0; x + cw <= VRAM_CELLS_X; x++) {
+            if(_cells_free(x, y, cw, ch)) {
+                px = x;
+                py = y;
+                break;
+            }
+        }
+    }
+
+    // CLUT rows must be contiguous, so palettes can be told apart by row
+    int8_t crow = 0;
+    if(clut_rows > 0) {
+        crow = -1;
+        for(uint8_t i = 0; i + clut_rows <= VRAM_CLUT_ROWS; i++) {
+            uint8_t j = 0;
+            while((j < clut_rows) && (_clut_rows[i + j] == CELL_FREE)) j++;
+            if(j == clut_rows) {
+                crow = i;
+                break;
+            }
+        }
+    }
+
+    if((px < 0) || (crow < 0)) {
+        printf("Error: Cannot fit %s (%dx%d, %d CLUTs) in VRAM\n",
+               _area_names[id], w, h, clut_rows);
+        return NULL;
+    }
+
+    for(uint8_t y = py; y < py + ch; y++)
+        for(uint8_t x = px; x < px + cw; x++)
+            _cells[y][x] = id + 1;
+    for(uint8_t i = crow; i < crow + clut_rows; i++)
+        _clut_rows[i] = id + 1;
+
+    area->allocated = 1;
+    area->scope = scope;
+    area->resident = 0;
+    setRECT(&area->prect,
+            px * VRAM_CELL_W, py * VRAM_CELL_H,
+            cw * VRAM_CELL_W, ch * VRAM_CELL_H);
+    setRECT(&area->crect, 0, VRAM_CLUT_Y + crow, 256, clut_rows);
+    return area;
+}
+
+VramArea *
+vram_get(VramAreaId id)
+{
+    return _areas[id].allocated ? &_areas[id] : NULL;
+}
+
+static uint8_t
+_rect_inside(RECT *r, RECT *bounds)
+{
+    return (r->x >= bounds->x) && (r->y >= bounds->y)
+        && (r->x + r->w <= bounds->x + bounds->w)
+        && (r->y + r->h <= bounds->y + bounds->h);
+}
+
+// Textures are placed on an area by their owners, so this is where an
+// oversized one is caught before it overwrites the neighbouring areas.
+// Either rect may be NULL if there is nothing to upload for it
+uint8_t
+vram_area_fits(VramArea *area, RECT *prect, RECT *crect)
+{
+    uint8_t id = area - _areas;
+    if(prect && !_rect_inside(prect, &area->prect)) {
+        printf("Error: Texture of %dx%d at %d,%d does not fit in %s\n",
+               prect->w, prect->h, prect->x, prect->y, _area_names[id]);
+        return 0;
+    }
+    if(crect && !_rect_inside(crect, &area->crect)) {
+        printf("Error: CLUT of %dx%d at %d,%d does not fit in %s\n",
+               crect->w, crect->h, crect->x, crect->y, _area_names[id]);
+        return 0;
+    }
+    return 1;
+}
+
+void
+vram_free_scene()
+{
+    for(uint8_t i = 0; i < VRAM_AREA_MAX; i++)
+        if(_areas[i].allocated && (_areas[i].scope == VRAM_SCOPE_SCENE))
+            _release(i);
+}
+
+static uint8_t
+_rect_overlaps(RECT *a, RECT *b)
+{
+    return (a->x < b->x + b->w) && (b->x < a->x + a->w)
+        && (a->y < b->y + b->h) && (b->y < a->y + a->h);
+}
+
+void
+vram_written(RECT *rect)
+{
+    for(uint8_t i = 0; i < VRAM_AREA_MAX; i++) {
+        VramArea *area = &_areas[i];
+        if(!area->allocated || !area->resident) continue;
+        if(_rect_overlaps(rect, &area->prect)
+           || ((area->crect.h > 0) && _rect_overlaps(rect, &area->crect)))
+            area->resident = 0;
+    }
+}
+
+void
+vram_debrief()
+{
+    uint8_t used = 0, clut_used = 0;
+    for(uint8_t y = 0; y < VRAM_CELLS_Y; y++)
+        for(uint8_t x = 0; x < VRAM_CELLS_X; x++)
+            if(_cells[y][x] != CELL_FREE) used++;
+    for(uint8_t i = 0; i < VRAM_CLUT_ROWS; i++)
+        if(_clut_rows[i] != CELL_FREE) clut_used++;
+
+    printf("VRAM cells used:  %u / %u\n"
+           "VRAM CLUTs used:  %u / %u\n",
+           used, VRAM_CELLS_X * VRAM_CELLS_Y,
+           clut_used, VRAM_CLUT_ROWS);
+    for(uint8_t i = 0; i < VRAM_AREA_MAX; i++) {
+        VramArea *area = &_areas[i];
+        if(!area->allocated) continue;
+        printf("  Area %-10s %4dx%-3d %3dx%-3d CLUT %d+%d%s\n",
+               _area_names[i],
+               area->prect.x, area->prect.y, area->prect.w, area->prect.h,
+               area->crect.y, area->crect.h,
+               area->resident ? " (resident)" : "");
+    }
+}
@@ -0,0 +1,124 @@
+#include "water.h"
+#include <stdio.h>
+#include <strings.h>
+#include <psxgpu.h>
+#include "vram.h"
+#include "cache.h"
+#include "render.h"
+#include "util.h"
+
+// Underwater tint. Same as the old overlay: half of the original color,
+// plus half of a dark blue (0x68 on 8 bits)
+#define WATER_TINT_B 6
+
+// Areas whose palettes get an underwater copy
+static const VramAreaId _wet_areas[] = {
+    VRAM_AREA_PLAYER,
+    VRAM_AREA_TILES,
+    VRAM_AREA_BG,
+    VRAM_AREA_OBJ_COMMON,
+    VRAM_AREA_OBJ_LEVEL,
+};
+
+static int32_t  _water_y = -1;
+static int16_t  _line = WATER_NO_LINE;
+// Underwater row for each CLUT row, or 0 if it has none
+static uint16_t _wet_row[VRAM_CLUT_ROWS];
+
+static uint16_t
+_water_color(uint16_t c)
+{
+    // Fully transparent color must stay that way
+    if(c == 0) return 0;
+    uint16_t r = (c & 0x1f) >> 1;
+    uint16_t g = ((c >> 5) & 0x1f) >> 1;
+    uint16_t b = (((c >> 10) & 0x1f) >> 1) + WATER_TINT_B;
+    return (c & 0x8000) | (b << 10) | (g << 5) | r;
+}
+
+void
+water_init(int32_t water_y)
+{
+    _water_y = water_y;
+    _line = WATER_NO_LINE;
+    bzero(_wet_row, sizeof(_wet_row));
+    if(water_y < 0) return;
+
+    uint8_t num_rows = 0;
+    for(uint8_t i = 0; i < sizeof(_wet_areas) / sizeof(VramAreaId); i++) {
+        VramArea *area = vram_get(_wet_areas[i]);
+        if(area) num_rows += area->crect.h;
+    }
+
+    // Palette rows only, no texture cells
+    VramArea *wet = vram_alloc(VRAM_AREA_WATER, 0, 0, num_rows,
+                               VRAM_SCOPE_SCENE);
+    if(!wet) {
+        printf("Warning: No room for underwater palettes\n");
+        _water_y = -1;
+        return;
+    }
+
+    // Palettes are read back from VRAM, so everything must be uploaded
+    DrawSync(0);
+    uint16_t colors[256];
+    uint16_t dst = wet->crect.y;
+    for(uint8_t i = 0; i < sizeof(_wet_areas) / sizeof(VramAreaId); i++) {
+        VramArea *area = vram_get(_wet_areas[i]);
+        if(!area) continue;
+        for(uint16_t src = area->crect.y;
+            src < area->crect.y + area->crect.h;
+            src++, dst++) {
+            RECT rect = { 0, src, 256, 1 };
+            StoreImage(&rect, (uint32_t *)colors);
+            DrawSync(0);
+            water_tint(colors, colors, 256);
+            rect.y = dst;
+            LoadImage(&rect, (uint32_t *)colors);
+            DrawSync(0);
+            cache_vram_written(&rect);
+            vram_written(&rect);
+            _wet_row[src - VRAM_CLUT_Y] = dst;
+        }
+    }
+    wet->resident = 1;
+    printf("Built %d underwater palettes\n", num_rows);
+}
+
+void
+water_update(int32_t cam_y)
+{
+    if(_water_y < 0) return;
+    // Screen Y of the water surface. Kept within a screen's height of
+    // the visible area, which is enough for anything drawn around it
+    int32_t line = ((_water_y - cam_y) >> 12) + CENTERY;
+    _line = CLAMP(line, -SCREEN_YRES, SCREEN_YRES << 1);
+}
+
+int16_t
+water_line()
+{
+    return _line;
+}
+
+uint16_t
+water_clut_row(uint16_t row)
+{
+    if((row < VRAM_CLUT_Y) || (row >= VRAM_CLUT_Y + VRAM_CLUT_ROWS))
+        return row;
+    uint16_t wet = _wet_row[row - VRAM_CLUT_Y];
+    return wet ? wet : row;
+}
+
+void
+water_tint(uint16_t *dst, const uint16_t *src, uint16_t n)
+{
+    for(uint16_t c = 0; c < n; c++)
+        dst[c] = _water_color(src[c]);
+}
+
+uint16_t
+water_clut_row_at(uint16_t row, int16_t vy)
+{
+    return (vy >= _line) ? water_clut_row(row) : row;
+}
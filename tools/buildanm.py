@@ -0,0 +1,210 @@
+#!/bin/env python
+# buildanm.py
+# Cooks the art animations of a level: palette rotations (CLUT cycling) and
+# tile frame swaps (small VRAM rectangles replaced by frames taken from the
+# level's own textures). The engine applies them with small uploads.
+# Usage: buildanm.py path/to/animations.toml
+# Writes ANIM.ANM next to the .toml file. Textures are read from the same
+# directory.
+
+import os
+import sys
+import toml
+from ctypes import c_byte, c_ubyte, c_short, c_ushort, c_uint
+
+# Native PlayStation format: little endian, naturally aligned
+c_short = c_short.__ctype_le__
+c_ushort = c_ushort.__ctype_le__
+c_uint = c_uint.__ctype_le__
+
+ANIM_MAGIC = b"ANM1"
+ANIM_VERSION = 1
+HEADER_SIZE = 20
+PALETTE_SIZE = 8
+TILES_SIZE = 16
+
+# Texture name -> (area, VRAM x offset in halfwords, CLUT row within area).
+# Must match where level_load_level places each texture
+TEXTURES = {
+    "TILES.TIM": (0, 0, 0),
+    "TILES0.TIM": (0, 0, 0),
+    "TILES1.TIM": (0, 64, 0),
+    "BG0.TIM": (1, 0, 0),
+    "BG1.TIM": (1, 64, 1),
+    "OBJ.TIM": (2, 0, 0),
+}
+
+# animations.toml:
+# [[palette]]              # Rotates a range of colors
+# texture = "TILES.TIM"    # Texture whose palette is rotated
+# first = 8                # First color index of the range
+# count = 4                # Number of colors in the range
+# period = 6               # Frames between each step
+# direction = 1            # 1 moves colors up the range, -1 down
+#
+# [[tiles]]                # Swaps a rectangle of a texture between frames
+# texture = "TILES.TIM"    # Texture the rectangle and frames are on
+# x = 64                   # Rectangle, in texels
+# y = 128
+# w = 16
+# h = 16
+# frames = [[64, 128], [80, 128], [96, 128]]  # Top-left of each frame
+# period = 8               # Frames between each swap
+
+# Binary layout (little endian):
+# - magic ("ANM1")
+# - version (uint16_t)
+# - unused, alignment (uint16_t)
+# - number of palette animations (uint16_t)
+# - number of tile animations (uint16_t)
+# - offset of palette animations from start of file (uint32_t)
+# - offset of tile animations from start of file (uint32_t)
+# - palette animations ([]PaletteAnim):
+#   - area (uint8_t, 0 = tiles, 1 = background, 2 = level objects)
+#   - CLUT row within area (uint8_t)
+#   - first color (uint8_t)
+#   - number of colors (uint8_t)
+#   - period in frames (uint8_t)
+#   - direction (int8_t)
+#   - unused, alignment (uint16_t)
+# - tile animations ([]TileAnim):
+#   - area (uint8_t)
+#   - number of frames (uint8_t)
+#   - period in frames (uint8_t)
+#   - unused, alignment (uint8_t)
+#   - rectangle within area, in VRAM halfwords (int16_t x, y, w, h)
+#   - offset of frame pixels from start of file (uint32_t)
+# - frame pixels of each tile animation ([frames][h][w]uint16_t), each
+#   frame padded to 4 bytes
+
+
+def u16(data, pos):
+    return int.from_bytes(data[pos : pos + 2], "little")
+
+
+def u32(data, pos):
+    return int.from_bytes(data[pos : pos + 4], "little")
+
+
+def load_tim(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    assert u32(data, 0) == 0x10, f"{path} is not a TIM file"
+    flags = u32(data, 4)
+    pos = 8
+    if flags & 0x8:
+        pos += u32(data, pos)
+    # Image block: length, x, y, width (halfwords), height
+    width = u16(data, pos + 8)
+    height = u16(data, pos + 10)
+    pixels = data[pos + 12 : pos + 12 + width * height * 2]
+    # Texels per halfword, from the pixel mode
+    per_halfword = {0: 4, 1: 2, 2: 1}[flags & 0x3]
+    return width, height, pixels, per_halfword
+
+
+def to_halfwords(name, value, per_halfword):
+    if value % per_halfword != 0:
+        print(f"{name}: {value} is not aligned to {per_halfword} texels")
+        exit(1)
+    return value // per_halfword
+
+
+def texture(basepath, name, cache):
+    if name not in TEXTURES:
+        print(f"Unknown texture {name}")
+        exit(1)
+    if name not in cache:
+        cache[name] = load_tim(os.path.join(basepath, name))
+    return cache[name]
+
+
+def parse_palette(entry):
+    area, _, row = TEXTURES[entry["texture"]]
+    first = entry["first"]
+    count = entry["count"]
+    if (count < 2) or (first + count > 256):
+        print(f"Invalid palette range {first}+{count}")
+        exit(1)
+    return (
+        bytes(c_ubyte(area))
+        + bytes(c_ubyte(row))
+        + bytes(c_ubyte(first))
+        + bytes(c_ubyte(count))
+        + bytes(c_ubyte(entry.get("period", 8)))
+        + bytes(c_byte(1 if entry.get("direction", 1) >= 0 else -1))
+        + bytes(c_ushort(0))
+    )
+
+
+def parse_tiles(entry, basepath, cache):
+    name = entry["texture"]
+    area, ox, _ = TEXTURES[name]
+    width, height, pixels, per_halfword = texture(basepath, name, cache)
+    x = to_halfwords(name, entry["x"], per_halfword)
+    w = to_halfwords(name, entry["w"], per_halfword)
+    y = entry["y"]
+    h = entry["h"]
+
+    frames = b""
+    for fx, fy in entry["frames"]:
+        fx = to_halfwords(name, fx, per_halfword)
+        if (fx + w > width) or (fy + h > height):
+            print(f"{name}: frame at {fx},{fy} is out of bounds")
+            exit(1)
+        for row in range(fy, fy + h):
+            start = (row * width + fx) * 2
+            frames += pixels[start : start + w * 2]
+        frames += bytes((4 - len(frames) % 4) % 4)
+
+    header = (
+        bytes(c_ubyte(area))
+        + bytes(c_ubyte(len(entry["frames"])))
+        + bytes(c_ubyte(entry.get("period", 8)))
+        + bytes(c_ubyte(0))
+        + bytes(c_short(ox + x))
+        + bytes(c_short(y))
+        + bytes(c_short(w))
+        + bytes(c_short(h))
+    )
+    return header, frames
+
+
+def main():
+    if len(sys.argv) < 2:
+        print("Usage: buildanm.py path/to/animations.toml")
+        exit(1)
+    toml_path = os.path.realpath(sys.argv[1])
+    basepath = os.path.dirname(toml_path)
+    data = toml.load(toml_path)
+
+    cache = {}
+    palettes = [parse_palette(p) for p in data.get("palette", [])]
+    tiles = [parse_tiles(t, basepath, cache) for t in data.get("tiles", [])]
+
+    palettes_offset = HEADER_SIZE
+    tiles_offset = palettes_offset + len(palettes) * PALETTE_SIZE
+    frames_offset = tiles_offset + len(tiles) * TILES_SIZE
+
+    out_path = os.path.join(basepath, "ANIM.ANM")
+    with open(out_path, "wb") as f:
+        f.write(ANIM_MAGIC)
+        f.write(c_ushort(ANIM_VERSION))
+        f.write(c_ushort(0))
+        f.write(c_ushort(len(palettes)))
+        f.write(c_ushort(len(tiles)))
+        f.write(c_uint(palettes_offset))
+        f.write(c_uint(tiles_offset))
+        for p in palettes:
+            f.write(p)
+        for header, frames in tiles:
+            f.write(header)
+            f.write(c_uint(frames_offset))
+            frames_offset += len(frames)
+        for _, frames in tiles:
+            f.write(frames)
+    print(f"Wrote {out_path} ({len(palettes)} palettes, {len(tiles)} tiles)")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,138 @@
+#!/bin/env python
+# buildpak.py
+# Packs all files needed by a single level act into a single file, so that
+# the engine can load the whole act with a single seek on the CD.
+# Usage: buildpak.py path/to/Z1.PAK
+# The act number and the level directory are taken from the output path.
+
+import os
+import sys
+import ctypes
+from ctypes import c_ushort, c_uint
+from lzcomp import compress, is_compressed
+
+c_ushort = c_ushort.__ctype_be__
+c_uint = c_uint.__ctype_be__
+
+SECTOR_SIZE = 2048
+PAK_MAGIC = 0x50414b32  # "PAK2"
+NAME_LEN = 12
+MAX_ENTRIES = 32  # PACK_MAX_ENTRIES on the engine
+
+# Binary layout (big endian):
+# - magic (uint32_t, "PAK2")
+# - number of entries (uint16_t)
+# - unused, alignment (uint16_t)
+# - entries ([]PackEntry):
+#   - file name as seen by the engine (char[12], zero-padded)
+#   - offset of file data from start of pack (uint32_t, sector aligned)
+#   - file size in bytes (uint32_t)
+#   - uncompressed file size, or 0 if stored as-is (uint32_t)
+#   - in-place decompression offset, see lzcomp.py (uint32_t)
+# - padding up to the end of the sector
+# - file data, each one starting on a new sector. Each file may be
+#   LZSS-compressed (see lzcomp.py); its size is then the compressed size.
+#   The engine sizes its buffer from the table, so a file that is not in RAM
+#   can be read with a single CD read
+
+# Example C structs:
+# typedef struct {
+#     char     name[12];
+#     uint32_t offset;
+#     uint32_t size;
+#     uint32_t usize;
+#     uint32_t inplace;
+# } PackEntry;
+#
+# typedef struct {
+#     uint32_t  magic;
+#     uint16_t  num_entries;
+#     uint16_t  _unused;
+#     PackEntry *entries;
+# } PackHeader;
+
+# Files are listed in the order level_load_level reads them, so that the
+# CD head never needs to go backwards. Pairs are (name in pack, source).
+def pack_files(act):
+    return [
+        ("TILES.TIM", "TILES.TIM"),
+        ("TILES0.TIM", "TILES0.TIM"),
+        ("TILES1.TIM", "TILES1.TIM"),
+        ("BG0.TIM", "BG0.TIM"),
+        ("BG1.TIM", "BG1.TIM"),
+        ("PRL.PRL", "PRL.PRL"),
+        ("ANIM.ANM", "ANIM.ANM"),
+        ("MAP16.MAP", "MAP16.MAP"),
+        ("MAP16.COL", "MAP16.COL"),
+        ("MAP128.MAP", "MAP128.MAP"),
+        (f"Z{act}.LVL", f"Z{act}.LVL"),
+        ("OBJ.TIM", "OBJ.TIM"),
+        ("BOSS.TIM", "BOSS.TIM"),
+        ("OBJ.OTD", "objects.OTD"),
+        (f"Z{act}.OMP", f"Z{act}.OMP"),
+    ]
+
+
+def align(n):
+    return (n + SECTOR_SIZE - 1) & ~(SECTOR_SIZE - 1)
+
+
+def main():
+    if len(sys.argv) < 2:
+        print("Usage: buildpak.py path/to/Z1.PAK")
+        exit(1)
+    outfile = sys.argv[1]
+    basepath = os.path.dirname(outfile)
+    act = os.path.basename(outfile)[1:-4]
+
+    # Streamed acts read their chunks by region instead
+    streamed = os.path.isfile(os.path.join(basepath, f"Z{act}.RGN"))
+
+    entries = []
+    for name, src in pack_files(act):
+        path = os.path.join(basepath, src)
+        if streamed and name == "MAP128.MAP":
+            continue
+        if os.path.isfile(path):
+            with open(path, "rb") as f:
+                data = f.read()
+            if not is_compressed(data):
+                packed = compress(data)
+                if len(packed) < len(data):
+                    data = packed
+            entries.append((name, data))
+
+    if len(entries) > MAX_ENTRIES:
+        print(f"Too many files for pack ({len(entries)}, max {MAX_ENTRIES})")
+        exit(1)
+
+    header_size = 8 + len(entries) * (NAME_LEN + 16)
+    if header_size > SECTOR_SIZE:
+        print("Too many files for pack header")
+        exit(1)
+
+    with open(outfile, "wb") as f:
+        f.write(c_uint(PAK_MAGIC))
+        f.write(c_ushort(len(entries)))
+        f.write(c_ushort(0))  # _unused
+        offset = SECTOR_SIZE
+        for name, data in entries:
+            f.write(name.encode("ascii").ljust(NAME_LEN, b"\0"))
+            f.write(c_uint(offset))
+            f.write(c_uint(len(data)))
+            if is_compressed(data):
+                f.write(data[4:12])  # Same as in the LZSS header
+            else:
+                f.write(c_uint(0))
+                f.write(c_uint(0))
+            offset = align(offset + len(data))
+        f.write(bytes(SECTOR_SIZE - header_size))
+        for name, data in entries:
+            f.write(data)
+            f.write(bytes(align(len(data)) - len(data)))
+            print(f"{name}: {len(data)} bytes")
+    print(f"Wrote {outfile} ({len(entries)} files)")
+
+
+if __name__ == "__main__":
+    main()
@@ -5,6 +5,7 @@ import toml
 from os.path import realpath, dirname, basename
 from dataclasses import dataclass, field
 from ctypes import c_ubyte, c_byte, c_short, c_ushort, c_int
+from math import ceil
 from pprint import pp
 
 c_short = c_short.__ctype_be__
@@ -20,6 +21,22 @@ def tofixed12(value: float) -> int:
     return tofixed(value, 12)
 
 
+# Angles are in 4096ths of a full period, as used by rsin
+def toangle(value: float) -> int:
+    return int(round(value * 4096)) & 0xFFFF
+
+
+MAX_BANDS = 64
+
+# Line scroll settings of a strip (all optional):
+# band_height = 8          # Split strip into bands this many lines tall
+# band_scrollx = [...]     # Scroll factor of each band, from top to bottom
+# scrollx_bottom = 0.75    # ...or interpolate from scrollx down to this
+# wave_amplitude = 3       # Sine displacement of bands, in pixels
+# wave_length = 64         # Lines per full sine period
+# wave_period = 120        # Steps (1/60s) per full sine period
+
+
 @dataclass
 class ParallaxStrip:
     u0: int = 0
@@ -31,6 +48,11 @@ class ParallaxStrip:
     scrollx: float = 0
     speedx: float = 0
     y0: int = 0
+    band_height: int = 0
+    band_scrollx: [float] = field(default_factory=list)
+    wave_amplitude: int = 0
+    wave_step: int = 0
+    wave_speed: int = 0
 
     def write_to(self, f):
         f.write(c_ubyte(self.u0))
@@ -42,6 +64,13 @@ class ParallaxStrip:
         f.write(c_int(tofixed12(self.scrollx)))
         f.write(c_int(tofixed12(self.speedx)))
         f.write(c_short(self.y0))
+        f.write(c_ubyte(self.band_height))
+        if self.band_height > 0:
+            f.write(c_ubyte(self.wave_amplitude))
+            f.write(c_ushort(self.wave_step))
+            f.write(c_ushort(self.wave_speed))
+            for factor in self.band_scrollx:
+                f.write(c_int(tofixed12(factor)))
 
 
 @dataclass
@@ -55,6 +84,39 @@ class Parallax:
                 s.write_to(f)
 
 
+def parse_bands(name, strip: ParallaxStrip, strip_data):
+    strip.band_height = strip_data.get("band_height", 0)
+    if strip.band_height == 0:
+        return
+    if strip.band_height > 255:
+        print(f"Strip {name}: band height must be below 256")
+        exit(1)
+
+    num_bands = ceil(strip.height / strip.band_height)
+    if num_bands > MAX_BANDS:
+        print(f"Strip {name}: too many bands ({num_bands}, max {MAX_BANDS})")
+        exit(1)
+
+    factors = strip_data.get("band_scrollx")
+    if factors is None:
+        top = strip.scrollx
+        bottom = strip_data.get("scrollx_bottom", top)
+        last = max(num_bands - 1, 1)
+        factors = [top + (bottom - top) * i / last for i in range(num_bands)]
+    if len(factors) != num_bands:
+        print(f"Strip {name}: expected {num_bands} band factors, got {len(factors)}")
+        exit(1)
+    strip.band_scrollx = factors
+
+    strip.wave_amplitude = strip_data.get("wave_amplitude", 0)
+    wave_length = strip_data.get("wave_length", 0)
+    wave_period = strip_data.get("wave_period", 0)
+    if wave_length > 0:
+        strip.wave_step = toangle(strip.band_height / wave_length)
+    if wave_period > 0:
+        strip.wave_speed = toangle(1 / wave_period)
+
+
 def parse(data) -> Parallax:
     p = Parallax()
     for name, strip_data in data.items():
@@ -71,6 +133,7 @@ def parse(data) -> Parallax:
         strip.u0 = strip_data.get("u0")
         strip.v0 = v0 % 256
 
+        parse_bands(name, strip, strip_data)
         p.strips.append(strip)
     return p
 
@@ -0,0 +1,149 @@
+#!/bin/env python
+# buildrgn.py
+# Splits the 128x128 chunks used by a level act into horizontal regions, so
+# that the engine only needs to keep the regions around the camera in RAM.
+# Only levels with a regions.toml file in their directory are streamed.
+# Usage: buildrgn.py path/to/Z1.RGN
+# The cooked Z1.LVL and MAP128.MAP are taken from the same directory.
+
+import os
+import sys
+import toml
+from ctypes import c_ushort, c_uint
+from lzcomp import decompress, is_compressed
+
+# Native PlayStation format: little endian, naturally aligned
+c_ushort = c_ushort.__ctype_le__
+c_uint = c_uint.__ctype_le__
+
+SECTOR_SIZE = 2048
+REGION_MAGIC = b"RGN1"
+REGION_VERSION = 1
+HEADER_SIZE = 20
+FRAMES_PER_CHUNK = 64
+FRAME_SIZE = 4
+
+# regions.toml:
+# width = 8  # Region width in chunks. Must cover at least a whole screen
+
+# Binary layout (little endian):
+# - magic ("RGN1")
+# - version (uint16_t)
+# - unused, alignment (uint16_t)
+# - number of regions (uint16_t)
+# - region width in chunks (uint16_t)
+# - number of chunks on MAP128.MAP (uint16_t)
+# - most chunks used by a single region (uint16_t)
+# - offset of region table from start of file (uint32_t)
+# - region table ([]RegionEntry):
+#   - offset of region data from start of file (uint32_t, sector aligned)
+#   - number of chunks within region (uint16_t)
+#   - unused, alignment (uint16_t)
+# - padding up to the end of the sector
+# - region data, each one starting on a new sector:
+#   - chunk ids ([]uint16_t), padded to 4 bytes
+#   - frames of each chunk, as in MAP128.MAP ([64]Frame128 per chunk)
+
+
+def read_cooked(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    return decompress(data) if is_compressed(data) else data
+
+
+def u16(data, pos):
+    return int.from_bytes(data[pos : pos + 2], "little")
+
+
+def u32(data, pos):
+    return int.from_bytes(data[pos : pos + 4], "little")
+
+
+def load_layers(path):
+    data = read_cooked(path)
+    assert data[0:4] == b"LVL1", f"{path} is not a level file"
+    num_layers = data[8]
+    layers = []
+    for i in range(num_layers):
+        entry = 12 + i * 8
+        width = u16(data, entry)
+        height = u16(data, entry + 2)
+        offset = u32(data, entry + 4)
+        tiles = [u16(data, offset + j * 2) for j in range(width * height)]
+        layers.append((width, height, tiles))
+    return layers
+
+
+def load_chunks(path):
+    data = read_cooked(path)
+    assert data[0:4] == b"M128", f"{path} is not a MAP128 file"
+    num_chunks = u16(data, 10)
+    offset = u32(data, 16)
+    size = FRAMES_PER_CHUNK * FRAME_SIZE
+    return [
+        data[offset + i * size : offset + (i + 1) * size] for i in range(num_chunks)
+    ]
+
+
+def align(n, a):
+    return (n + a - 1) & ~(a - 1)
+
+
+def main():
+    if len(sys.argv) < 2:
+        print("Usage: buildrgn.py path/to/Z1.RGN")
+        exit(1)
+    outfile = sys.argv[1]
+    basepath = os.path.dirname(outfile)
+    config = toml.load(os.path.join(basepath, "regions.toml"))
+    region_width = config.get("width", 8)
+
+    layers = load_layers(os.path.splitext(outfile)[0] + ".LVL")
+    chunks = load_chunks(os.path.join(basepath, "MAP128.MAP"))
+    level_width = max(w for w, _, _ in layers)
+    num_regions = (level_width + region_width - 1) // region_width
+
+    # Chunks referenced by each column span, across all layers and rows
+    regions = []
+    for r in range(num_regions):
+        ids = set()
+        for width, height, tiles in layers:
+            for y in range(height):
+                for x in range(r * region_width, min((r + 1) * region_width, width)):
+                    ids.add(tiles[y * width + x])
+        regions.append(sorted(ids))
+
+    table_size = HEADER_SIZE + num_regions * 8
+    if table_size > SECTOR_SIZE:
+        print("Too many regions for region header, use wider regions")
+        exit(1)
+
+    with open(outfile, "wb") as f:
+        f.write(REGION_MAGIC)
+        f.write(c_ushort(REGION_VERSION))
+        f.write(c_ushort(0))
+        f.write(c_ushort(num_regions))
+        f.write(c_ushort(region_width))
+        f.write(c_ushort(len(chunks)))
+        f.write(c_ushort(max(len(ids) for ids in regions)))
+        f.write(c_uint(HEADER_SIZE))
+        offset = SECTOR_SIZE
+        blobs = []
+        for ids in regions:
+            blob = b"".join(bytes(c_ushort(i)) for i in ids)
+            blob += bytes(align(len(blob), 4) - len(blob))
+            blob += b"".join(chunks[i] for i in ids)
+            blobs.append(blob)
+            f.write(c_uint(offset))
+            f.write(c_ushort(len(ids)))
+            f.write(c_ushort(0))
+            offset += align(len(blob), SECTOR_SIZE)
+        f.write(bytes(SECTOR_SIZE - table_size))
+        for blob in blobs:
+            f.write(blob)
+            f.write(bytes(align(len(blob), SECTOR_SIZE) - len(blob)))
+    print(f"Wrote {outfile} ({num_regions} regions of {region_width} chunks)")
+
+
+if __name__ == "__main__":
+    main()
@@ -10,10 +10,15 @@ import sys
 import pandas as pd
 import numpy as np
 import math
-from ctypes import c_ushort, c_ubyte
+from ctypes import c_ushort, c_ubyte, c_uint
 
-# Set endianness of some types to big endian
-c_ushort = c_ushort.__ctype_be__
+# Native PlayStation format: little endian, naturally aligned
+c_ushort = c_ushort.__ctype_le__
+c_uint = c_uint.__ctype_le__
+
+MAP128_MAGIC = b"M128"
+MAP128_VERSION = 1
+HEADER_SIZE = 20
 
 
 def reshape_dimension(d):
@@ -54,19 +59,30 @@ def get_max_grid(df):
 
 
 # Binary layout:
-# --> MUST BE SAVED IN BIG ENDIAN FORMAT.
-# 1. Tile width: short (16 bits)
-# 2. Number of tiles: short (16 bits)
-# 3. Frame rows / columns: short (16 bits)
-# 4. Array of frame data.
-#    4.1. Frames: Columns * Rows
-#         4.1.1 Tilenum: short (16 bits)
-#         4.1.2 Props:   byte  (8 bits)
+# --> MUST BE SAVED IN LITTLE ENDIAN FORMAT. The engine uses it in place.
+# 1. Magic: "M128" (4 bytes)
+# 2. Version: short (16 bits)
+# 3. Unused, alignment: short (16 bits)
+# 4. Tile width: short (16 bits)
+# 5. Number of tiles: short (16 bits)
+# 6. Frame rows / columns: short (16 bits)
+# 7. Unused, alignment: short (16 bits)
+# 8. Offset of frame data from start of file: int (32 bits)
+# 9. Array of frame data.
+#    9.1. Frames: Columns * Rows
+#         9.1.1 Tilenum: short (16 bits)
+#         9.1.2 Props:   byte  (8 bits)
+#         9.1.3 Unused, alignment: byte (8 bits)
 def export_binary(f, solid, oneway, nocol, front):
     grid = get_max_grid(solid)
+    f.write(MAP128_MAGIC)
+    f.write(c_ushort(MAP128_VERSION))
+    f.write(c_ushort(0))
     f.write(c_ushort(128))
     f.write(c_ushort(grid[0] * grid[1]))
     f.write(c_ushort(8))
+    f.write(c_ushort(0))
+    f.write(c_uint(HEADER_SIZE))
     # Loop for each chunk
     for cy in range(0, grid[1]):
         for cx in range(0, grid[0]):
@@ -98,6 +114,7 @@ def export_binary(f, solid, oneway, nocol, front):
                         props = 4 if index > 0 else 0
                     f.write(c_ushort(max(index, 0)))
                     f.write(c_ubyte(props))
+                    f.write(c_ubyte(0))
 
 
 # def debug_print(df):
@@ -7,14 +7,19 @@ import json
 import sys
 import numpy as np
 import math
-from ctypes import c_ushort, c_ubyte, c_int32
+from ctypes import c_ushort, c_ubyte, c_int32, c_uint
 from enum import Enum
 from pprint import pp as pprint
 from math import sqrt
 
-# Ensure binary C types are encoded as big endian
-c_ushort = c_ushort.__ctype_be__
-c_int32 = c_int32.__ctype_be__
+# Native PlayStation format: little endian, naturally aligned
+c_ushort = c_ushort.__ctype_le__
+c_int32 = c_int32.__ctype_le__
+c_uint = c_uint.__ctype_le__
+
+COLLISION_MAGIC = b"COL1"
+COLLISION_VERSION = 1
+HEADER_SIZE = 20
 
 # This package depends on shapely because I'm fed up with attempting to code
 # point and polygon checking myself. On arch linux, install python-shapely.
@@ -265,35 +270,48 @@ def write_mask_data(f, mask_data):
         f.write(b)
 
 
-# Binary layout:
-# 1. Number of tiles (ushort, 2 bytes)
-# 2. Tile data [many]
-#   2.1. tile id (ushort, 2 bytes)
-#   2.2. Floor
-#        2.2.1. Angle (4 bytes - PSX format)
-#        2.2.2. Data (8 bytes)
-#   2.3. Right wall
-#        2.3.1. Angle (4 bytes - PSX format)
-#        2.3.2. Data (8 bytes)
-#   2.4. Ceiling
-#        2.4.1. Angle (4 bytes - PSX format)
-#        2.4.2. Data (8 bytes)
-#   2.5. Left wall
-#        2.5.1. Angle (4 bytes - PSX format)
-#        2.5.2. Data (8 bytes)
+# Binary layout (little endian, used in place by the engine):
+# 1. Magic: "COL1" (4 bytes)
+# 2. Version (ushort, 2 bytes)
+# 3. Unused, alignment (ushort, 2 bytes)
+# 4. Number of tiles (ushort, 2 bytes)
+# 5. Unused, alignment (ushort, 2 bytes)
+# 6. Offset of tile ids from start of file (uint, 4 bytes)
+# 7. Offset of tile data from start of file (uint, 4 bytes)
+# 8. Tile ids [many] (ushort, 2 bytes), padded to 4 bytes
+# 9. Tile data [many], laid out like the engine's Collision struct
+#   9.1. Floor data (8 bytes)
+#   9.2. Right wall data (8 bytes)
+#   9.3. Ceiling data (8 bytes)
+#   9.4. Left wall data (8 bytes)
+#   9.5. Floor angle (4 bytes - PSX format)
+#   9.6. Right wall angle (4 bytes - PSX format)
+#   9.7. Ceiling angle (4 bytes - PSX format)
+#   9.8. Left wall angle (4 bytes - PSX format)
 def write_file(f, tile_data):
-    f.write(c_ushort(len(tile_data)))
+    num_tiles = len(tile_data)
+    ids_size = (num_tiles * 2 + 3) & ~3
+    f.write(COLLISION_MAGIC)
+    f.write(c_ushort(COLLISION_VERSION))
+    f.write(c_ushort(0))
+    f.write(c_ushort(num_tiles))
+    f.write(c_ushort(0))
+    f.write(c_uint(HEADER_SIZE))
+    f.write(c_uint(HEADER_SIZE + ids_size))
     for tile in tile_data:
         f.write(c_ushort(tile.get("id")))
+    if num_tiles % 2:
+        f.write(c_ushort(0))
+    for tile in tile_data:
         masks = tile.get("masks")
-        f.write(c_int32(masks.get("floor")[0]))
         write_mask_data(f, masks.get("floor")[1])
-        f.write(c_int32(masks.get("rwall")[0]))
         write_mask_data(f, masks.get("rwall")[1])
-        f.write(c_int32(masks.get("ceiling")[0]))
         write_mask_data(f, masks.get("ceiling")[1])
-        f.write(c_int32(masks.get("lwall")[0]))
         write_mask_data(f, masks.get("lwall")[1])
+        f.write(c_int32(masks.get("floor")[0]))
+        f.write(c_int32(masks.get("rwall")[0]))
+        f.write(c_int32(masks.get("ceiling")[0]))
+        f.write(c_int32(masks.get("lwall")[0]))
 
 
 def main():
@@ -7,29 +7,43 @@
 import sys
 import json
 import ctypes
-from ctypes import c_ushort, c_ubyte
+from ctypes import c_ushort, c_ubyte, c_uint
 
-c_ushort = c_ushort.__ctype_be__
+# Native PlayStation format: little endian, naturally aligned
+c_ushort = c_ushort.__ctype_le__
+c_uint = c_uint.__ctype_le__
 
-# Binary layout:
+LEVEL_MAGIC = b"LVL1"
+LEVEL_VERSION = 2
+
+# Binary layout (little endian, used in place by the engine):
+# - magic ("LVL1")
+# - version (uint16_t)
+# - unused, alignment (uint16_t)
 # - number of layers (uint8_t, never above 3)
 # - unused, alignment (uint8_t)
-# - level data per layer:
-#   - layer width in tiles (uint8_t, never above 256)
-#   - layer height in tiles (uint8_t, never above 256)
-#   - array of tiles ([]uint16_t, big endian)
+# - unused, alignment (uint16_t)
+# - layer table, per layer:
+#   - layer width in tiles (uint16_t, never above 1023)
+#   - layer height in tiles (uint16_t, never above 31)
+#   - offset of tiles from start of file (uint32_t)
+# - tiles of each layer ([]uint16_t), each array aligned to 4 bytes
 
 # Example C structs:
 # typedef struct {
-#     uint8_t  width;
-#     uint8_t  height;
-#     uint16_t *tiles; // (big endian)
+#     uint16_t width;
+#     uint16_t height;
+#     uint16_t *tiles; // (offset, fixed up on load)
 # } LayerData;
 #
 # typedef struct {
+#     char      magic[4];
+#     uint16_t  version;
+#     uint16_t  _unused0;
 #     uint8_t   num_layers;
-#     uint8_t   _unused;
-#     LayerData *layer_data;
+#     uint8_t   _unused1;
+#     uint16_t  _unused2;
+#     LayerData layer_data[];
 # } LevelData;
 
 jsonfile = ""
@@ -53,16 +67,28 @@ def main():
 
     with open(outfile, "wb") as f:
         print(f"Number of level layers: {j.get('num_layers')}")
+        f.write(LEVEL_MAGIC)
+        f.write(c_ushort(LEVEL_VERSION))
+        f.write(c_ushort(0))  # _unused0
         f.write(c_ubyte(j.get("num_layers")))
-        f.write(c_ubyte(0))  # _unused
+        f.write(c_ubyte(0))  # _unused1
+        f.write(c_ushort(0))  # _unused2
         layer_data = j.get("layer_data")
+        offset = 12 + len(layer_data) * 8
         for layer in layer_data:
             # print(layer.get("width"))
             # print(layer.get("height"))
-            f.write(c_ubyte(layer.get("width")))
-            f.write(c_ubyte(layer.get("height")))
-            for tile in layer.get("tiles"):
+            f.write(c_ushort(layer.get("width")))
+            f.write(c_ushort(layer.get("height")))
+            f.write(c_uint(offset))
+            offset += len(layer.get("tiles")) * 2
+            offset = (offset + 3) & ~3
+        for layer in layer_data:
+            tiles = layer.get("tiles")
+            for tile in tiles:
                 f.write(c_ushort(tile))
+            if len(tiles) % 2:
+                f.write(c_ushort(0))
 
 
 if __name__ == "__main__":
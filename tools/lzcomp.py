@@ -0,0 +1,137 @@
+#!/bin/env python
+# lzcomp.py
+# LZSS compressor for cooked assets. Files are compressed in place; files
+# that are already compressed, or that would not get any smaller, are left
+# untouched. buildpak.py compresses files within level packs with it, and
+# the engine decompresses these transparently when they are read.
+# Usage: lzcomp.py FILE [FILE...]
+
+import sys
+import ctypes
+from ctypes import c_uint
+
+c_uint = c_uint.__ctype_be__
+
+LZ_MAGIC = 0x534C5A31  # "SLZ1"
+HEADER_SIZE = 12
+WINDOW = 4096
+MIN_MATCH = 3
+MAX_MATCH = 18
+MAX_CHAIN = 64
+
+# Binary layout (big endian):
+# - magic (uint32_t, "SLZ1")
+# - uncompressed size (uint32_t)
+# - in-place offset (uint32_t): smallest offset at which this whole file
+#   may be placed within the destination buffer so that it can be
+#   decompressed in place without overwriting unread input
+# - LZSS stream:
+#   - flags byte, read from the least significant bit; for each bit:
+#     - 1: literal byte
+#     - 0: match, two bytes: OOOOOOOO OOOOLLLL
+#          distance = O + 1 (1..4096), length = L + 3 (3..18)
+
+
+def compress(data):
+    out = bytearray()
+    chains = {}
+    i = 0
+    n = len(data)
+    # Tracks how far output gets ahead of input, for in-place decoding
+    inplace = 0
+    read = HEADER_SIZE
+
+    while i < n:
+        flagpos = len(out)
+        out.append(0)
+        read += 1
+        flags = 0
+        for bit in range(8):
+            if i >= n:
+                break
+            best_len = 0
+            best_dist = 0
+            if i + MIN_MATCH <= n:
+                key = bytes(data[i:i + MIN_MATCH])
+                for j in reversed(chains.get(key, [])[-MAX_CHAIN:]):
+                    dist = i - j
+                    if dist > WINDOW:
+                        break
+                    length = 0
+                    while (length < MAX_MATCH and i + length < n
+                           and data[j + length] == data[i + length]):
+                        length += 1
+                    if length > best_len:
+                        best_len = length
+                        best_dist = dist
+                        if length == MAX_MATCH:
+                            break
+            if best_len >= MIN_MATCH:
+                d = best_dist - 1
+                out.append((d >> 4) & 0xFF)
+                out.append(((d & 0xF) << 4) | (best_len - MIN_MATCH))
+                read += 2
+                step = best_len
+            else:
+                flags |= 1 << bit
+                out.append(data[i])
+                read += 1
+                step = 1
+            for k in range(i, i + step):
+                if k + MIN_MATCH <= n:
+                    chains.setdefault(bytes(data[k:k + MIN_MATCH]), []).append(k)
+            i += step
+            inplace = max(inplace, i - read)
+        out[flagpos] = flags
+
+    header = bytes(c_uint(LZ_MAGIC)) + bytes(c_uint(n)) + bytes(c_uint(inplace))
+    return header + bytes(out)
+
+
+def decompress(data):
+    size = int.from_bytes(data[4:8], "big")
+    out = bytearray()
+    b = HEADER_SIZE
+    while len(out) < size:
+        flags = data[b]
+        b += 1
+        for bit in range(8):
+            if len(out) >= size:
+                break
+            if flags & (1 << bit):
+                out.append(data[b])
+                b += 1
+            else:
+                d = ((data[b] << 4) | (data[b + 1] >> 4)) + 1
+                length = (data[b + 1] & 0xF) + MIN_MATCH
+                b += 2
+                for _ in range(length):
+                    out.append(out[-d])
+    return bytes(out)
+
+
+def is_compressed(data):
+    return len(data) >= HEADER_SIZE and int.from_bytes(data[0:4], "big") == LZ_MAGIC
+
+
+def main():
+    if len(sys.argv) < 2:
+        print("Usage: lzcomp.py FILE [FILE...]")
+        exit(1)
+    for filename in sys.argv[1:]:
+        with open(filename, "rb") as f:
+            data = f.read()
+        if is_compressed(data):
+            continue
+        packed = compress(data)
+        assert decompress(packed) == data
+        if len(packed) >= len(data):
+            print(f"{filename}: {len(data)} bytes, left uncompressed")
+            continue
+        with open(filename, "wb") as f:
+            f.write(packed)
+        print(f"{filename}: {len(data)} -> {len(packed)} bytes")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,10 @@
+// Host-side stand-in for PSn00bSDK's psxcd.h (types only)
+#ifndef HOST_PSXCD_H
+#define HOST_PSXCD_H
+
+#include <stdint.h>
+
+typedef struct { uint8_t minute, second, sector, track; } CdlLOC;
+typedef struct { CdlLOC pos; uint32_t size; char name[16]; } CdlFILE;
+
+#endif
@@ -0,0 +1,49 @@
+// Host-side stand-in for the parts of PSn00bSDK's psxgpu.h that headers
+// shared with tests rely on. Drawing is never performed by tests.
+#ifndef HOST_PSXGPU_H
+#define HOST_PSXGPU_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct { int16_t x, y, w, h; } RECT;
+
+typedef struct { RECT clip; int16_t ofs[2]; RECT tw; uint16_t tpage; } DRAWENV;
+typedef struct { RECT disp; RECT screen; } DISPENV;
+
+typedef struct {
+    uint32_t mode;
+    RECT     *crect;
+    uint32_t *caddr;
+    RECT     *prect;
+    uint32_t *paddr;
+} TIM_IMAGE;
+
+typedef struct {
+    uint32_t tag;
+    uint8_t  r0, g0, b0, code;
+    int16_t  x0, y0, x1, y1, x2, y2, x3, y3;
+} POLY_F4;
+
+typedef struct {
+    uint32_t tag;
+    uint8_t  r0, g0, b0, code;
+    int16_t  x0, y0, x1, y1;
+} LINE_F2;
+
+#define setPolyF4(p)              ((void)(p))
+#define setLineF2(p)              ((void)(p))
+#define setSemiTrans(p, abe)      ((void)(p))
+#define setRGB0(p, r, g, b)       ((void)(p))
+#define setXYWH(p, x, y, w, h)    ((void)(p))
+#define setXY2(p, x0, y0, x1, y1) ((void)(p))
+
+#define setRECT(r, _x, _y, _w, _h) \
+    ((r)->x = (_x), (r)->y = (_y), (r)->w = (_w), (r)->h = (_h))
+
+// VRAM transfers are provided by the tests that need them
+int  DrawSync(int mode);
+void LoadImage(const RECT *rect, const uint32_t *data);
+void StoreImage(const RECT *rect, uint32_t *data);
+
+#endif
@@ -0,0 +1,13 @@
+// Host-side stand-in for PSn00bSDK's psxgte.h (types only)
+#ifndef HOST_PSXGTE_H
+#define HOST_PSXGTE_H
+
+#include <stdint.h>
+
+typedef struct { int32_t vx, vy, vz, pad; } VECTOR;
+typedef struct { int16_t vx, vy, vz, pad; } SVECTOR;
+typedef struct { int16_t m[3][3]; int32_t t[3]; } MATRIX;
+
+#define ONE 4096
+
+#endif
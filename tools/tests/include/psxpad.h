@@ -0,0 +1,9 @@
+// Host-side stand-in for PSn00bSDK's psxpad.h (types only)
+#ifndef HOST_PSXPAD_H
+#define HOST_PSXPAD_H
+
+#include <stdint.h>
+
+typedef uint16_t PadButton;
+
+#endif
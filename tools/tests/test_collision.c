@@ -0,0 +1,283 @@
+// Host-side tests for swept sensors (src/collision.c).
+// Fires a point with the player's sensors at thin walls, floors and
+// ceilings with increasing speeds, and checks that it never goes through.
+// Build and run with: make test
+
+#include <stdio.h>
+#include <string.h>
+#include "collision.h"
+#include "player.h"
+#include "camera.h"
+#include "render.h"
+
+// Globals collision.c expects from the rest of the engine
+TileMap16   *map16;
+TileMap128  *map128;
+LevelData   *leveldata;
+Player      *player;
+Camera      *camera;
+int         debug_mode = 0;
+
+static Player _player;
+static Camera _camera;
+
+void *get_next_prim() { static uint8_t prim[64]; return prim; }
+void increment_prim(uint32_t size) { (void)size; }
+void sort_prim(void *prim, uint32_t otz) { (void)prim; (void)otz; }
+
+// Level of 4x2 chunks, made of 16x16 pieces which are either empty or
+// fully solid
+#define TEST_LEVEL_W 4
+#define TEST_LEVEL_H 2
+
+static TileMap16      _map16;
+static TileMap128     _map128;
+static LevelData      _leveldata;
+static LevelLayerData _layer;
+static uint16_t       _tiles[TEST_LEVEL_W * TEST_LEVEL_H];
+static Frame128       _frames[TEST_LEVEL_W * TEST_LEVEL_H][64];
+static Frame128       *_chunks[TEST_LEVEL_W * TEST_LEVEL_H + 1];
+static Collision      _solid;
+static Collision      *_collision[2];
+
+static void
+_level_clear()
+{
+    memset(_frames, 0, sizeof(_frames));
+    memset(&_solid.floor, 0xff, 8);
+    memset(&_solid.rwall, 0xff, 8);
+    memset(&_solid.ceiling, 0xff, 8);
+    memset(&_solid.lwall, 0xff, 8);
+    _collision[0] = NULL;
+    _collision[1] = &_solid;
+
+    _map16.collision = _collision;
+    _map128.chunks = _chunks;
+    _map128.num_tiles = TEST_LEVEL_W * TEST_LEVEL_H + 1;
+    _chunks[0] = NULL;
+    for(int i = 0; i < TEST_LEVEL_W * TEST_LEVEL_H; i++) {
+        _tiles[i] = i + 1;
+        _chunks[i + 1] = _frames[i];
+    }
+    _layer.width = TEST_LEVEL_W;
+    _layer.height = TEST_LEVEL_H;
+    _layer.tiles = _tiles;
+    _leveldata.num_layers = 1;
+    _leveldata.layers = &_layer;
+
+    map16 = &_map16;
+    map128 = &_map128;
+    leveldata = &_leveldata;
+    player = &_player;
+    camera = &_camera;
+}
+
+// Makes the 16x16 piece containing pixel (x, y) solid
+static void
+_level_solid(int32_t x, int32_t y)
+{
+    int32_t chunk = (y >> 7) * TEST_LEVEL_W + (x >> 7);
+    int32_t piece = (((y & 0x7f) >> 4) << 3) + ((x & 0x7f) >> 4);
+    _frames[chunk][piece].index = 1;
+    _frames[chunk][piece].props = MAP128_PROP_SOLID;
+}
+
+static int _failures = 0;
+
+#define CHECK(cond, ...)                              \
+    do {                                              \
+        if(!(cond)) {                                 \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__);                      \
+            printf("\n");                             \
+            _failures++;                              \
+        }                                             \
+    } while(0)
+
+// Sensors are placed and hits are resolved with the same offsets as in
+// player.c, for an airborne player in floor mode
+
+// Moves the player horizontally until a push sensor hits something.
+// Returns the final X and whether it stopped
+static int32_t
+_fire_x(int32_t x, int32_t y, int32_t speed, uint8_t swept, uint8_t *stopped)
+{
+    int32_t vel = speed << 12;
+    LinecastDirection dir = (speed > 0) ? CDIR_RWALL : CDIR_LWALL;
+    *stopped = 0;
+    for(int step = 0; step < 512; step++) {
+        uint8_t mag = swept
+            ? linecast_sweep_magnitude(PUSH_RADIUS, vel)
+            : PUSH_RADIUS;
+        CollisionEvent ev = linecast(x, y - PUSH_SENSOR_Y, dir, mag, CDIR_FLOOR);
+        if(ev.collided) {
+            x = (speed > 0) ? ev.coord - PUSH_SNAP_RIGHT : ev.coord + PUSH_SNAP_LEFT;
+            *stopped = 1;
+            break;
+        }
+        x += speed;
+        if((x < 0) || (x >= (TEST_LEVEL_W << 7))) break;
+    }
+    return x;
+}
+
+// Nearest hit of a pair of sensors, picked like player.c does
+static int32_t
+_nearest(CollisionEvent *a, CollisionEvent *b)
+{
+    int32_t coord = 0;
+    if(a->collided) coord = a->coord;
+    if((b->collided && (b->coord < coord)) || (coord == 0)) coord = b->coord;
+    return coord;
+}
+
+// Same, vertically, with the ground (falling) or ceiling (rising) sensors
+static int32_t
+_fire_y(int32_t x, int32_t y, int32_t speed, uint8_t rolling,
+        uint8_t swept, uint8_t *stopped)
+{
+    int32_t vel = speed << 12;
+    uint16_t width = rolling ? WIDTH_RADIUS_ROLLING : WIDTH_RADIUS_NORMAL;
+    uint16_t radius = rolling ? HEIGHT_RADIUS_ROLLING : HEIGHT_RADIUS_NORMAL;
+    int32_t left = x - width;
+    int32_t right = x + width - 1;
+    *stopped = 0;
+    for(int step = 0; step < 512; step++) {
+        CollisionEvent ev1, ev2;
+        if(speed > 0) {
+            uint8_t mag = swept ? linecast_sweep_magnitude(radius, vel) : radius;
+            ev1 = linecast(left, y, CDIR_FLOOR, mag, CDIR_FLOOR);
+            ev2 = linecast(right, y, CDIR_FLOOR, mag, CDIR_FLOOR);
+            if(ev1.collided || ev2.collided)
+                y = _nearest(&ev1, &ev2) - GROUND_SNAP;
+        } else {
+            uint8_t ceil_mag = CEILING_MAGNITUDE(radius);
+            uint8_t mag = swept ? linecast_sweep_magnitude(ceil_mag, vel) : ceil_mag;
+            ev1 = linecast(left, y - ceil_mag, CDIR_CEILING, mag, CDIR_FLOOR);
+            ev2 = linecast(right, y - ceil_mag, CDIR_CEILING, mag, CDIR_FLOOR);
+            if(ev1.collided || ev2.collided)
+                y = _nearest(&ev1, &ev2) + CEILING_SNAP;
+        }
+        if(ev1.collided || ev2.collided) {
+            *stopped = 1;
+            break;
+        }
+        y += speed;
+        if((y < 0) || (y >= (TEST_LEVEL_H << 7))) break;
+    }
+    return y;
+}
+
+static void
+test_sweep_magnitude()
+{
+    // Normal speeds leave sensors alone
+    CHECK(linecast_sweep_magnitude(PUSH_RADIUS, 6 << 12) == PUSH_RADIUS,
+          "push sensor stretched at walking speed");
+    CHECK(linecast_sweep_magnitude(PUSH_RADIUS, -(10 << 12)) == PUSH_RADIUS,
+          "push sensor stretched at its own reach");
+    CHECK(linecast_sweep_magnitude(PUSH_RADIUS, -(24 << 12)) == 24,
+          "push sensor not stretched to cover the step");
+    CHECK(linecast_sweep_magnitude(CEILING_MAGNITUDE(HEIGHT_RADIUS_ROLLING),
+                                   -(16 << 12)) == 16,
+          "ceiling sensor not stretched to cover the step");
+    CHECK(linecast_sweep_magnitude(PUSH_RADIUS, 1000 << 12) == LINECAST_MAX_SWEEP,
+          "sweep not capped");
+}
+
+static void
+test_walls()
+{
+    // A wall a single piece thick, from x = 320 to 335
+    _level_clear();
+    for(int32_t y = 0; y < (TEST_LEVEL_H << 7); y += 16)
+        _level_solid(320, y);
+
+    uint8_t tunnelled_unswept = 0;
+    for(int32_t speed = 1; speed <= 64; speed++) {
+        for(int32_t start = 0; start < 16; start++) {
+            uint8_t stopped;
+            int32_t x = _fire_x(200 + start, 100, speed, 1, &stopped);
+            CHECK(stopped && (x < 320),
+                  "went through right wall at %d px/step from %d (x = %d)",
+                  speed, 200 + start, x);
+
+            x = _fire_x(460 - start, 100, -speed, 1, &stopped);
+            CHECK(stopped && (x > 335),
+                  "went through left wall at %d px/step from %d (x = %d)",
+                  speed, 460 - start, x);
+
+            _fire_x(200 + start, 100, speed, 0, &stopped);
+            if(!stopped) tunnelled_unswept = 1;
+        }
+    }
+    // Otherwise this test would not be testing anything
+    CHECK(tunnelled_unswept, "plain sensors never tunnelled through the wall");
+}
+
+static void
+test_floors_and_ceilings()
+{
+    // A floor a single piece thick, from y = 160 to 175, and a ceiling
+    // from y = 80 to 95
+    _level_clear();
+    for(int32_t x = 0; x < (TEST_LEVEL_W << 7); x += 16) {
+        _level_solid(x, 160);
+        _level_solid(x, 80);
+    }
+
+    uint8_t tunnelled_unswept = 0;
+    for(int32_t speed = 1; speed <= 64; speed++) {
+        for(int32_t start = 0; start < 16; start++) {
+            uint8_t stopped;
+            int32_t y = _fire_y(200, 100 + start, speed, 0, 1, &stopped);
+            CHECK(stopped && (y < 160),
+                  "fell through floor at %d px/step from %d (y = %d)",
+                  speed, 100 + start, y);
+
+            y = _fire_y(200, 150 - start, -speed, 1, 1, &stopped);
+            CHECK(stopped && (y > 95),
+                  "went through ceiling at %d px/step from %d (y = %d)",
+                  speed, 150 - start, y);
+
+            _fire_y(200, 150 - start, -speed, 1, 0, &stopped);
+            if(!stopped) tunnelled_unswept = 1;
+        }
+    }
+    CHECK(tunnelled_unswept, "plain sensors never tunnelled through the ceiling");
+}
+
+static void
+test_outside_level()
+{
+    // Sensors reaching out of the level must find nothing there
+    _level_clear();
+    for(int32_t y = 0; y < (TEST_LEVEL_H << 7); y += 16)
+        _level_solid(0, y);
+    CollisionEvent ev = linecast(8, 100, CDIR_LWALL, 64, CDIR_FLOOR);
+    CHECK(ev.collided && (ev.coord < 16), "missed the wall at the level edge");
+    ev = linecast(-40, 100, CDIR_LWALL, 64, CDIR_FLOOR);
+    CHECK(!ev.collided, "collided left of the level");
+    ev = linecast(100, (TEST_LEVEL_H << 7) + 10, CDIR_FLOOR, 64, CDIR_FLOOR);
+    CHECK(!ev.collided, "collided below the level");
+
+    // Chunk ids the mapping does not have are treated as empty
+    _tiles[0] = TEST_LEVEL_W * TEST_LEVEL_H + 50;
+    ev = linecast(64, 64, CDIR_FLOOR, 32, CDIR_FLOOR);
+    CHECK(!ev.collided, "collided with a chunk that does not exist");
+}
+
+int
+main()
+{
+    test_sweep_magnitude();
+    test_walls();
+    test_floors_and_ceilings();
+    test_outside_level();
+    if(_failures) {
+        printf("test_collision: %d failures\n", _failures);
+        return 1;
+    }
+    printf("test_collision: OK\n");
+    return 0;
+}
@@ -0,0 +1,175 @@
+#!/bin/env python
+# test_fileindex.py
+# Host-side check of the boot-time file index (file_index_init in
+# src/util.c). Regenerates the index from the mkpsxiso layout in iso.xml
+# and checks that it fits the engine's limits. If a disc image was built,
+# its ISO9660 directory tree is walked the same way the engine does, and
+# every path, LBA and size is checked against the layout.
+# Usage: test_fileindex.py [path/to/SONICXA.bin] (or make test)
+
+import os
+import re
+import sys
+import xml.etree.ElementTree as ET
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..")
+DEFAULT_IMAGE = os.path.join(ROOT, "build", "SONICXA.bin")
+
+ISO_PVD_SECTOR = 16
+ISO_ROOT_RECORD = 156
+
+
+def engine_limits():
+    with open(os.path.join(ROOT, "src", "util.c")) as f:
+        src = f.read()
+    limits = {}
+    for name in ("FILE_INDEX_MAX", "FILE_PATH_MAX", "FILE_NAMES_LEN"):
+        m = re.search(rf"#define\s+{name}\s+(\d+)", src)
+        assert m, f"{name} not found in src/util.c"
+        limits[name] = int(m.group(1))
+    return limits
+
+
+# Same as _path_hash on the engine
+def path_hash(path):
+    h = 0x811c9dc5
+    for c in path.encode("ascii"):
+        h ^= c
+        h = (h * 0x01000193) & 0xFFFFFFFF
+    return h
+
+
+# Paths as the engine builds them from directory records, along with the
+# source of each data file when it can be found from here
+def layout_paths(filename):
+    tree = ET.parse(filename).getroot().find("track/directory_tree")
+    paths = {}
+
+    def walk(node, prefix):
+        for child in node:
+            if child.tag == "dir":
+                walk(child, prefix + "\\" + child.get("name"))
+            elif child.tag == "file":
+                source = child.get("source", "")
+                source = source.replace("${PROJECT_SOURCE_DIR}", ROOT)
+                if child.get("type") != "data" or not os.path.isfile(source):
+                    source = None
+                path = prefix + "\\" + child.get("name") + ";1"
+                if path in paths:
+                    raise ValueError(f"iso.xml lists {path} twice")
+                paths[path] = source
+
+    walk(tree, "")
+    return paths
+
+
+# Reads 2048-byte user data sectors, from either a plain ISO or a raw
+# BIN image as written by mkpsxiso (mode 2 form 1, 2352-byte sectors)
+class Image:
+    def __init__(self, filename):
+        with open(filename, "rb") as f:
+            self.data = f.read()
+        sync = bytes([0] + [0xFF] * 10 + [0])
+        self.raw = self.data[:12] == sync
+
+    def read(self, lba, numsectors):
+        if not self.raw:
+            return self.data[lba * 2048:(lba + numsectors) * 2048]
+        out = bytearray()
+        for i in range(numsectors):
+            at = (lba + i) * 2352 + 24
+            out += self.data[at:at + 2048]
+        return bytes(out)
+
+
+# Same walk as _file_index_dir on the engine
+def image_index(image):
+    index = {}
+    pvd = image.read(ISO_PVD_SECTOR, 1)
+    root_lba = int.from_bytes(pvd[ISO_ROOT_RECORD + 2:ISO_ROOT_RECORD + 6], "little")
+    root_size = int.from_bytes(pvd[ISO_ROOT_RECORD + 10:ISO_ROOT_RECORD + 14], "little")
+
+    def walk(path, lba, size):
+        dir = image.read(lba, (size + 2047) // 2048)
+        b = 0
+        while b < size:
+            reclen = dir[b]
+            if reclen == 0:
+                b = (b + 2048) & ~2047
+                continue
+            rlba = int.from_bytes(dir[b + 2:b + 6], "little")
+            rsize = int.from_bytes(dir[b + 10:b + 14], "little")
+            flags = dir[b + 25]
+            namelen = dir[b + 32]
+            name = dir[b + 33:b + 33 + namelen]
+            b += reclen
+            if namelen == 1 and name[0] in (0, 1):
+                continue
+            full = path + "\\" + name.decode("ascii")
+            if flags & 0x02:
+                walk(full, rlba, rsize)
+            else:
+                index[full] = (rlba, rsize)
+
+    walk("", root_lba, root_size)
+    return index
+
+
+def main():
+    failures = []
+    limits = engine_limits()
+    paths = layout_paths(os.path.join(ROOT, "iso.xml"))
+
+    if len(paths) > limits["FILE_INDEX_MAX"]:
+        failures.append(f"{len(paths)} files, index holds {limits['FILE_INDEX_MAX']}")
+    names_len = sum(len(p) + 1 for p in paths)
+    if names_len > limits["FILE_NAMES_LEN"]:
+        failures.append(f"paths take {names_len} bytes, index holds "
+                        f"{limits['FILE_NAMES_LEN']}")
+    for p in paths:
+        if len(p) >= limits["FILE_PATH_MAX"]:
+            failures.append(f"{p} is longer than FILE_PATH_MAX")
+
+    # Paths are compared on a hash hit, so a collision only costs a string
+    # comparison. Still worth knowing about
+    hashes = {}
+    for p in paths:
+        other = hashes.setdefault(path_hash(p), p)
+        if other != p:
+            print(f"Note: {p} and {other} have the same hash")
+
+    image_file = sys.argv[1] if len(sys.argv) > 1 else DEFAULT_IMAGE
+    if os.path.isfile(image_file):
+        image = Image(image_file)
+        index = image_index(image)
+        for p, source in paths.items():
+            if p not in index:
+                failures.append(f"{p} is in iso.xml but not on the image")
+                continue
+            if not source:
+                continue
+            # The indexed LBA and size must lead to the very same file
+            lba, size = index[p]
+            with open(source, "rb") as f:
+                data = f.read()
+            if size != len(data):
+                failures.append(f"{p} is {size} bytes, source is {len(data)}")
+            elif image.read(lba, 1)[:min(size, 2048)] != data[:2048]:
+                failures.append(f"{p} does not start at LBA {lba}")
+        for p in index:
+            if p not in paths:
+                failures.append(f"{p} is on the image but not in iso.xml")
+        print(f"Walked {len(index)} files on {os.path.relpath(image_file, ROOT)}")
+    else:
+        print("No disc image built, only checking iso.xml")
+
+    for f in failures:
+        print(f"FAIL {f}")
+    if failures:
+        print(f"test_fileindex: {len(failures)} failures")
+        exit(1)
+    print(f"test_fileindex: OK ({len(paths)} files, {names_len} bytes of paths)")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,235 @@
+// Host-side tests for level art animations (src/levelanim.c).
+// Loads an ANM1 file built in memory, steps it and checks which palettes
+// and tile frames are uploaded to VRAM, and when.
+// Build and run with: make test
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include "levelanim.h"
+#include "vram.h"
+#include "cache.h"
+#include "screen.h"
+#include "water.h"
+
+/* ============================== */
+/*   STAND-INS FOR THE ENGINE     */
+/* ============================== */
+
+// A tiles area, as placed by level_load_level, with its CLUT row filled
+// with colors 0x100 + index
+static VramArea _tiles_area = {
+    .allocated = 1,
+    .prect = { 448, 0, 128, 256 },
+    .crect = { 0, 481, 256, 1 },
+};
+
+// The file handed out by file_read_asset, and what it was asked for
+static uint8_t    *_file;
+static const char *_expected_magic;
+static uint16_t   _expected_version;
+
+// Last upload made with LoadImage
+static RECT     _upload_rect;
+static uint16_t _upload_data[64];
+static int      _num_uploads;
+
+uint8_t *
+file_read_asset(const char *filename, uint32_t *length, FileAllocator alloc,
+                const char *magic, uint16_t version)
+{
+    (void)(filename);
+    (void)(length);
+    (void)(alloc);
+    _expected_magic = magic;
+    _expected_version = version;
+    return _file;
+}
+
+void *screen_alloc_tagged(uint32_t size, ArenaTag tag) { (void)tag; return calloc(1, size); }
+VramArea *vram_get(VramAreaId id) { return (id == VRAM_AREA_TILES) ? &_tiles_area : NULL; }
+void vram_written(RECT *rect) { (void)rect; }
+void cache_vram_written(RECT *rect) { (void)rect; }
+uint16_t water_clut_row(uint16_t row) { return row; }
+void water_tint(uint16_t *dst, const uint16_t *src, uint16_t n) { memcpy(dst, src, n * 2); }
+int DrawSync(int mode) { (void)mode; return 0; }
+
+void
+StoreImage(const RECT *rect, uint32_t *data)
+{
+    uint16_t *colors = (uint16_t *)data;
+    for(int i = 0; i < rect->w; i++) colors[i] = 0x100 + rect->x + i;
+}
+
+void
+LoadImage(const RECT *rect, const uint32_t *data)
+{
+    _upload_rect = *rect;
+    memcpy(_upload_data, data, rect->w * rect->h * sizeof(uint16_t));
+    _num_uploads++;
+}
+
+/* ============================== */
+/*          TEST FILE             */
+/* ============================== */
+
+// One palette rotation of colors 8-11 every 3 steps, and one 2x2 tile
+// swapping between 3 frames every 2 steps. Frame n is filled with n * 100
+// plus the index of each halfword
+#define TILE_FRAMES 3
+
+static struct {
+    LevelAnimFile header;
+    PaletteAnim   palette;
+    TileAnim      tiles;
+    uint16_t      frames[TILE_FRAMES][4];
+} _anm;
+
+static void
+_anm_build()
+{
+    memset(&_anm, 0, sizeof(_anm));
+    memcpy(_anm.header.header.magic, LEVELANIM_MAGIC, 4);
+    _anm.header.header.version = LEVELANIM_VERSION;
+    _anm.header.num_palettes = 1;
+    _anm.header.num_tiles = 1;
+    _anm.header.palettes_offset = offsetof(__typeof__(_anm), palette);
+    _anm.header.tiles_offset = offsetof(__typeof__(_anm), tiles);
+
+    _anm.palette = (PaletteAnim){
+        .area = LEVELANIM_AREA_TILES, .row = 0, .first = 8, .count = 4,
+        .period = 3, .direction = 1,
+    };
+    _anm.tiles = (TileAnim){
+        .area = LEVELANIM_AREA_TILES, .num_frames = TILE_FRAMES, .period = 2,
+        .x = 4, .y = 8, .w = 2, .h = 2,
+        .frames_offset = offsetof(__typeof__(_anm), frames),
+    };
+    for(int f = 0; f < TILE_FRAMES; f++)
+        for(int i = 0; i < 4; i++)
+            _anm.frames[f][i] = f * 100 + i;
+
+    _file = (uint8_t *)&_anm;
+}
+
+static int _failures = 0;
+
+#define CHECK(cond, ...)                              \
+    do {                                              \
+        if(!(cond)) {                                 \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__);                      \
+            printf("\n");                             \
+            _failures++;                              \
+        }                                             \
+    } while(0)
+
+// Runs a number of steps, then flushes like a drawn frame would
+static void
+_step(int steps)
+{
+    _num_uploads = 0;
+    for(int i = 0; i < steps; i++) levelanim_update();
+    levelanim_flush();
+}
+
+static void
+test_load()
+{
+    _anm_build();
+    levelanim_load("\\LEVELS\\R2\\ANIM.ANM;1");
+    CHECK(!strncmp(_expected_magic, LEVELANIM_MAGIC, 4)
+          && (_expected_version == LEVELANIM_VERSION),
+          "not read as an ANM1 asset");
+
+    // Nothing moves until the level's textures are on VRAM
+    _step(10);
+    CHECK(_num_uploads == 0, "animated before levelanim_start");
+    levelanim_unload();
+
+    // A missing (or stale) file leaves the level without animations
+    _file = NULL;
+    levelanim_load("\\LEVELS\\R2\\ANIM.ANM;1");
+    levelanim_start();
+    _step(10);
+    CHECK(_num_uploads == 0, "animated without a file");
+    levelanim_unload();
+}
+
+static void
+test_tile_frames()
+{
+    _anm_build();
+    _anm.palette.period = 255; // Keep the palette out of the way
+    levelanim_load("\\LEVELS\\R2\\ANIM.ANM;1");
+    levelanim_start();
+
+    _step(1);
+    CHECK(_num_uploads == 0, "tile swapped before its period");
+
+    // Frames go 1, 2, then back to 0, every 2 steps
+    for(int n = 1; n <= 4; n++) {
+        uint16_t frame = n % TILE_FRAMES;
+        _step((n == 1) ? 1 : 2);
+        CHECK(_num_uploads == 1, "tile not swapped on swap %d", n);
+        CHECK((_upload_rect.x == 448 + 4) && (_upload_rect.y == 8)
+              && (_upload_rect.w == 2) && (_upload_rect.h == 2),
+              "tile uploaded to %d,%d (%dx%d)", _upload_rect.x,
+              _upload_rect.y, _upload_rect.w, _upload_rect.h);
+        CHECK((_upload_data[0] == frame * 100) && (_upload_data[3] == frame * 100 + 3),
+              "swap %d uploaded %d, expected frame %d", n, _upload_data[0], frame);
+    }
+    levelanim_unload();
+}
+
+static void
+test_palette_rotation()
+{
+    _anm_build();
+    _anm.tiles.period = 255; // Keep the tile out of the way
+    levelanim_load("\\LEVELS\\R2\\ANIM.ANM;1");
+    levelanim_start();
+
+    // Colors 8-11 move up the range by one every 3 steps
+    _step(3);
+    CHECK(_num_uploads == 1, "palette not rotated after its period");
+    CHECK((_upload_rect.x == 8) && (_upload_rect.y == 481) && (_upload_rect.w == 4),
+          "palette uploaded to %d,%d (%d colors)",
+          _upload_rect.x, _upload_rect.y, _upload_rect.w);
+    CHECK((_upload_data[0] == 0x10b) && (_upload_data[1] == 0x108)
+          && (_upload_data[3] == 0x10a),
+          "rotated to %03x %03x %03x %03x", _upload_data[0], _upload_data[1],
+          _upload_data[2], _upload_data[3]);
+
+    // A full turn brings the original colors back
+    _step(9);
+    CHECK((_upload_data[0] == 0x108) && (_upload_data[3] == 0x10b),
+          "full turn ended at %03x ... %03x", _upload_data[0], _upload_data[3]);
+
+    // Rotating the other way
+    levelanim_unload();
+    _anm_build();
+    _anm.palette.direction = -1;
+    _anm.tiles.period = 255;
+    levelanim_load("\\LEVELS\\R2\\ANIM.ANM;1");
+    levelanim_start();
+    _step(3);
+    CHECK((_upload_data[0] == 0x109) && (_upload_data[3] == 0x108),
+          "rotated backwards to %03x ... %03x", _upload_data[0], _upload_data[3]);
+    levelanim_unload();
+}
+
+int
+main()
+{
+    test_load();
+    test_tile_frames();
+    test_palette_rotation();
+    if(_failures) {
+        printf("test_levelanim: %d failures\n", _failures);
+        return 1;
+    }
+    printf("test_levelanim: OK\n");
+    return 0;
+}
@@ -0,0 +1,121 @@
+#!/bin/env python
+# test_lzcomp.py
+# Round-trip tests for tools/lzcomp.py. Every kind of asset that may be
+# compressed is run through compress and decompress, and is decompressed
+# once more the way the engine does it: in place, with the compressed file
+# placed at its in-place offset within the destination buffer.
+# Usage: test_lzcomp.py (or make test)
+
+import os
+import sys
+import glob
+import random
+
+TOOLS = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+sys.path.insert(0, TOOLS)
+from lzcomp import compress, decompress, is_compressed, HEADER_SIZE  # noqa
+
+ROOT = os.path.join(TOOLS, "..")
+
+# Everything the Makefile runs through lzcomp.py, plus everything
+# buildpak.py may compress within a pack
+ASSET_TYPES = ["MAP", "COL", "LVL", "OMP", "TIM", "PRL", "ANM", "RGN",
+               "OTD", "CHARA"]
+
+
+# Same as lz_decompress on the engine, byte by byte within one buffer.
+# Fails if a write ever reaches input that was not read yet
+def decompress_inplace(packed):
+    size = int.from_bytes(packed[4:8], "big")
+    inplace = int.from_bytes(packed[8:12], "big")
+    start = (inplace + 3) & ~3
+    buf = bytearray(max(size, start + len(packed)))
+    buf[start:start + len(packed)] = packed
+    dst = 0
+    src = start + HEADER_SIZE
+    while dst < size:
+        flags = buf[src]
+        src += 1
+        for bit in range(8):
+            if dst >= size:
+                break
+            if flags & (1 << bit):
+                literal = buf[src]
+                src += 1
+                assert dst < src, "output overran unread input"
+                buf[dst] = literal
+                dst += 1
+            else:
+                d = ((buf[src] << 4) | (buf[src + 1] >> 4)) + 1
+                length = (buf[src + 1] & 0xF) + 3
+                src += 2
+                for _ in range(length):
+                    assert dst < src, "output overran unread input"
+                    buf[dst] = buf[dst - d]
+                    dst += 1
+    return bytes(buf[:size])
+
+
+def check(name, data):
+    packed = compress(data)
+    assert is_compressed(packed), "not marked as compressed"
+    assert decompress(packed) == data, "round trip differs"
+    assert decompress_inplace(packed) == data, "in-place result differs"
+
+
+def synthetic():
+    rnd = random.Random(1234)
+    yield "empty", b""
+    yield "one byte", b"\x42"
+    yield "zeros", bytes(10000)
+    yield "random", bytes(rnd.getrandbits(8) for _ in range(10000))
+    # Matches at the longest distance, and just out of the window
+    block = bytes(rnd.getrandbits(8) for _ in range(4096))
+    yield "window edge", block + block[:100]
+    yield "past window", block + b"\0" + block[:100]
+    # Runs that overlap their own output
+    yield "runs", b"".join(bytes([i]) * (i % 40 + 1) for i in range(256))
+    # Big endian tables, as most cooked files are
+    yield "table", b"".join(rnd.choice([0, 1, 2, 0x100, 0x1FF]).to_bytes(2, "big")
+                            for _ in range(8000))
+
+
+def main():
+    failures = 0
+    checked = 0
+    for name, data in synthetic():
+        try:
+            check(name, data)
+        except AssertionError as e:
+            print(f"FAIL {name}: {e}")
+            failures += 1
+
+    for ext in ASSET_TYPES:
+        files = sorted(glob.glob(os.path.join(ROOT, "assets", "**", f"*.{ext}"),
+                                 recursive=True), key=os.path.getsize)
+        files = [f for f in files if os.path.isfile(f)]
+        if not files:
+            print(f"No {ext} files found, run make cook to test them")
+            continue
+        # Smallest and largest of each kind
+        for path in sorted({files[0], files[-1]}):
+            with open(path, "rb") as f:
+                data = f.read()
+            name = os.path.relpath(path, ROOT)
+            checked += 1
+            if is_compressed(data):
+                data = decompress(data)
+            try:
+                check(name, data)
+            except AssertionError as e:
+                print(f"FAIL {name}: {e}")
+                failures += 1
+
+    if failures:
+        print(f"test_lzcomp: {failures} failures")
+        exit(1)
+    print(f"test_lzcomp: OK ({checked} asset files)")
+
+
+if __name__ == "__main__":
+    main()
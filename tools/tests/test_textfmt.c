@@ -0,0 +1,169 @@
+// Host-side tests for the on-screen number formatters (src/textfmt.c).
+// Every formatter is compared against snprintf over sweeps of its input
+// range, at every width and padding it supports.
+// Build and run with: make test
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "textfmt.h"
+
+static int _failures = 0;
+
+static void
+_compare(const char *what, const char *got, const char *end,
+         const char *expected)
+{
+    if((strcmp(got, expected) != 0) || (end != got + strlen(got))) {
+        if(_failures < 20)
+            printf("FAIL %s: got \"%s\", expected \"%s\"\n",
+                   what, got, expected);
+        _failures++;
+    }
+}
+
+static void
+_check_dec(int32_t value)
+{
+    char got[32], expected[32], what[64];
+    for(uint8_t width = 0; width <= 12; width++) {
+        char *end = textfmt_dec(got, value, width, TEXTFMT_PAD_SPACE);
+        snprintf(expected, sizeof(expected), "%*d", width, value);
+        snprintf(what, sizeof(what), "dec(%d, %u, ' ')", value, width);
+        _compare(what, got, end, expected);
+
+        end = textfmt_dec(got, value, width, TEXTFMT_PAD_ZERO);
+        snprintf(expected, sizeof(expected), "%0*d", width, value);
+        snprintf(what, sizeof(what), "dec(%d, %u, '0')", value, width);
+        _compare(what, got, end, expected);
+    }
+}
+
+static void
+_check_hex(uint32_t value)
+{
+    char got[32], expected[32], what[64];
+    for(uint8_t width = 0; width <= 10; width++) {
+        char *end = textfmt_hex(got, value, width);
+        snprintf(expected, sizeof(expected), "%0*X", width, value);
+        snprintf(what, sizeof(what), "hex(%08X, %u)", value, width);
+        _compare(what, got, end, expected);
+    }
+}
+
+// Fixed point is truncated towards zero, which snprintf cannot do with
+// floats, so the reference is built from the integer and fractional parts
+static void
+_check_fixed(int32_t value)
+{
+    static const uint32_t pow10[] = { 1, 10, 100, 1000, 10000 };
+    char got[32], expected[32], number[32], what[64];
+    uint32_t mag = (value < 0) ? -(uint32_t)value : (uint32_t)value;
+    for(uint8_t decimals = 0; decimals <= 4; decimals++) {
+        uint32_t frac = ((mag & 0xfff) * pow10[decimals]) >> 12;
+        const char *sign = ((value < 0) && ((mag >> 12) || frac)) ? "-" : "";
+        if(decimals > 0)
+            snprintf(number, sizeof(number), "%s%u.%0*u",
+                     sign, mag >> 12, decimals, frac);
+        else snprintf(number, sizeof(number), "%s%u", sign, mag >> 12);
+
+        for(uint8_t width = 0; width <= 12; width += 4) {
+            char *end = textfmt_fixed(got, value, decimals, width);
+            snprintf(expected, sizeof(expected), "%*s", width, number);
+            snprintf(what, sizeof(what), "fixed(%08X, %u, %u)",
+                     (uint32_t)value, decimals, width);
+            _compare(what, got, end, expected);
+        }
+    }
+}
+
+static void
+test_dec()
+{
+    for(int32_t v = -100000; v <= 100000; v++)
+        _check_dec(v);
+    // Coarse sweep of the whole range, plus every power of ten and its
+    // neighbours, and both ends
+    for(int64_t v = INT32_MIN; v <= INT32_MAX; v += 65521)
+        _check_dec((int32_t)v);
+    for(int64_t p = 1; p <= 1000000000; p *= 10) {
+        for(int32_t d = -1; d <= 1; d++) {
+            _check_dec((int32_t)(p + d));
+            _check_dec((int32_t)(-p + d));
+        }
+    }
+    _check_dec(INT32_MIN);
+    _check_dec(INT32_MAX);
+}
+
+static void
+test_hex()
+{
+    for(uint32_t v = 0; v <= 0x20000; v++)
+        _check_hex(v);
+    for(uint64_t v = 0; v <= UINT32_MAX; v += 65521)
+        _check_hex((uint32_t)v);
+    for(uint8_t shift = 0; shift < 32; shift++) {
+        _check_hex(1u << shift);
+        _check_hex((1u << shift) - 1);
+    }
+    _check_hex(UINT32_MAX);
+}
+
+static void
+test_time()
+{
+    char got[32], expected[32], what[64];
+    // Every value up to 100 minutes, then a few that overflow the field
+    for(uint32_t s = 0; s <= 6000; s++) {
+        char *end = textfmt_time(got, s);
+        snprintf(expected, sizeof(expected), "%2u:%02u", s / 60, s % 60);
+        snprintf(what, sizeof(what), "time(%u)", s);
+        _compare(what, got, end, expected);
+    }
+    for(uint32_t s = 6000; s < 1000000; s += 997) {
+        char *end = textfmt_time(got, s);
+        snprintf(expected, sizeof(expected), "%2u:%02u", s / 60, s % 60);
+        snprintf(what, sizeof(what), "time(%u)", s);
+        _compare(what, got, end, expected);
+    }
+}
+
+static void
+test_fixed()
+{
+    // Every fraction around zero, for both signs
+    for(int32_t v = -0x10000; v <= 0x10000; v++)
+        _check_fixed(v);
+    for(int64_t v = INT32_MIN; v <= INT32_MAX; v += 65521)
+        _check_fixed((int32_t)v);
+    _check_fixed(INT32_MIN);
+    _check_fixed(INT32_MAX);
+}
+
+static void
+test_chaining()
+{
+    char got[64];
+    char *p = textfmt_str(got, "X ");
+    p = textfmt_hex(p, 0xbeef, 6);
+    p = textfmt_str(p, " T ");
+    p = textfmt_time(p, 125);
+    _compare("chained line", got, p, "X 00BEEF T  2:05");
+}
+
+int
+main()
+{
+    test_dec();
+    test_hex();
+    test_time();
+    test_fixed();
+    test_chaining();
+    if(_failures) {
+        printf("test_textfmt: %d failures\n", _failures);
+        return 1;
+    }
+    printf("test_textfmt: OK\n");
+    return 0;
+}